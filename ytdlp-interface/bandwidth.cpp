@@ -0,0 +1,454 @@
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "bandwidth.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#pragma warning (disable: 4267)
+
+
+namespace
+{
+	std::string base64_decode(const std::string &in)
+	{
+		const std::string chars {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+		std::string out;
+		unsigned val {0};
+		int bits {-8};
+		for(auto c : in)
+		{
+			auto pos {chars.find(c)};
+			if(pos == -1) break;
+			val = (val << 6) + pos;
+			bits += 6;
+			if(bits >= 0)
+			{
+				out += char((val >> bits) & 0xff);
+				bits -= 8;
+			}
+		}
+		return out;
+	}
+
+	SOCKET connect_to(std::string host, std::string port)
+	{
+		if(host.size() > 2 && host.front() == '[' && host.back() == ']')
+			host = host.substr(1, host.size() - 2);
+		addrinfo hints {}, *res {nullptr};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		if(getaddrinfo(host.data(), port.data(), &hints, &res) != 0)
+			return INVALID_SOCKET;
+		SOCKET s {INVALID_SOCKET};
+		for(auto ai {res}; ai; ai = ai->ai_next)
+		{
+			s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+			if(s == INVALID_SOCKET)
+				continue;
+			if(connect(s, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0)
+				break;
+			closesocket(s);
+			s = INVALID_SOCKET;
+		}
+		freeaddrinfo(res);
+		return s;
+	}
+
+	bool send_all(SOCKET s, const char *data, size_t size)
+	{
+		while(size)
+		{
+			auto sent {send(s, data, static_cast<int>(size), 0)};
+			if(sent <= 0)
+				return false;
+			data += sent;
+			size -= sent;
+		}
+		return true;
+	}
+
+	// splits "host:port" / "[v6]:port" into its parts
+	void split_hostport(const std::string &str, std::string &host, std::string &port, std::string default_port)
+	{
+		auto pos {str.rfind(':')};
+		if(pos != -1 && str.find(']', pos) == -1)
+		{
+			host = str.substr(0, pos);
+			port = str.substr(pos + 1);
+		}
+		else
+		{
+			host = str;
+			port = default_port;
+		}
+	}
+}
+
+
+bandwidth_proxy::~bandwidth_proxy()
+{
+	if(running)
+	{
+		running = false;
+		closesocket(listener);
+		cv.notify_all();
+		if(thr_accept.joinable())
+			thr_accept.join();
+		{
+			// the threads serving the connections are blocked in recv or send, closing their sockets ends that
+			std::lock_guard<std::mutex> lock {mtx};
+			for(auto s : sockets)
+				closesocket(s);
+			sockets.clear();
+		}
+		for(auto &client : clients)
+			if(client.thr.joinable())
+				client.thr.join();
+		if(thr_refill.joinable())
+			thr_refill.join();
+		WSACleanup();
+	}
+}
+
+
+void bandwidth_proxy::budget(unsigned long long bytes_per_sec)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	rate = bytes_per_sec;
+}
+
+
+std::wstring bandwidth_proxy::proxy_url(std::wstring item)
+{
+	if(!running && !start())
+		return L"";
+	std::lock_guard<std::mutex> lock {mtx};
+	auto &user {users[item]};
+	if(user.empty())
+		user = "item" + std::to_string(next_user++);
+	buckets[user] = {};
+	return L"http://" + std::wstring {user.begin(), user.end()} + L":x@127.0.0.1:" + std::to_wstring(port);
+}
+
+
+bandwidth_proxy::stats_t bandwidth_proxy::release(std::wstring item)
+{
+	using namespace std::chrono;
+	stats_t stats;
+	std::lock_guard<std::mutex> lock {mtx};
+	auto it {users.find(item)};
+	if(it != users.end())
+	{
+		auto itb {buckets.find(it->second)};
+		if(itb != buckets.end())
+		{
+			stats.bytes = itb->second.bytes;
+			stats.secs = duration_cast<milliseconds>(steady_clock::now() - itb->second.start).count() / 1000.0;
+			buckets.erase(itb);
+		}
+		users.erase(it);
+	}
+	return stats;
+}
+
+
+unsigned long long bandwidth_proxy::total_rate()
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	unsigned long long sum {0};
+	for(auto n : slices)
+		sum += n;
+	return slices.empty() ? 0 : sum * slices_per_sec / slices.size();
+}
+
+
+bool bandwidth_proxy::start()
+{
+	WSADATA wsadata;
+	if(WSAStartup(MAKEWORD(2, 2), &wsadata) != 0)
+	{
+		err = "WSAStartup failed";
+		return false;
+	}
+
+	SOCKET s {socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+	sockaddr_in addr {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0; // let the system pick a free port
+	int addrlen {sizeof addr};
+	if(s == INVALID_SOCKET || bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 ||
+	   getsockname(s, reinterpret_cast<sockaddr*>(&addr), &addrlen) != 0 || listen(s, SOMAXCONN) != 0)
+	{
+		err = "failed to open a listening socket on the loopback interface (error " + std::to_string(WSAGetLastError()) + ")";
+		if(s != INVALID_SOCKET)
+			closesocket(s);
+		WSACleanup();
+		return false;
+	}
+	listener = s;
+	port = ntohs(addr.sin_port);
+	running = true;
+
+	thr_accept = std::thread {[this]
+	{
+		while(running)
+		{
+			SOCKET client {accept(listener, nullptr, nullptr)};
+			for(auto it {clients.begin()}; it != clients.end();)
+			{
+				if(it->done)
+				{
+					it->thr.join();
+					it = clients.erase(it);
+				}
+				else ++it;
+			}
+			if(client == INVALID_SOCKET)
+				continue;
+			if(!track(client))
+			{
+				closesocket(client);
+				continue;
+			}
+			auto &entry {clients.emplace_back()};
+			entry.thr = std::thread {[this, client, &entry]
+			{
+				serve(client);
+				entry.done = true;
+			}};
+		}
+	}};
+
+	thr_refill = std::thread {[this]
+	{
+		using namespace std::chrono;
+		while(running)
+		{
+			std::this_thread::sleep_for(milliseconds {1000 / slices_per_sec});
+			std::lock_guard<std::mutex> lock {mtx};
+			slices.push_back(slice_bytes);
+			if(slices.size() > slices_per_sec)
+				slices.pop_front();
+			slice_bytes = 0;
+			if(rate)
+			{
+				// tokens don't carry over, so no more than one slice worth of the budget can be spent per slice
+				auto active {std::count_if(buckets.begin(), buckets.end(), [](auto &el) { return el.second.active; })};
+				auto share {active ? std::max(1ull, rate / slices_per_sec / active) : 0};
+				for(auto &[user, bucket] : buckets)
+				{
+					bucket.tokens = bucket.active ? share : 0;
+					bucket.active = false;
+				}
+			}
+			cv.notify_all();
+		}
+	}};
+
+	return true;
+}
+
+
+size_t bandwidth_proxy::acquire(const std::string &user, size_t want)
+{
+	std::unique_lock<std::mutex> lock {mtx};
+	while(running)
+	{
+		// a user that has no bucket isn't one of the items (or the item was released), so it gets nothing
+		auto it {buckets.find(user)};
+		if(it == buckets.end())
+			return 0;
+		auto &bucket {it->second};
+		bucket.active = true;
+		if(!rate || bucket.tokens)
+		{
+			auto granted {rate ? std::min<unsigned long long>(bucket.tokens, want) : want};
+			if(rate) bucket.tokens -= granted;
+			bucket.bytes += granted;
+			slice_bytes += granted;
+			return granted;
+		}
+		cv.wait(lock);
+	}
+	return 0;
+}
+
+
+void bandwidth_proxy::refund(const std::string &user, size_t amount)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	auto it {buckets.find(user)};
+	if(it != buckets.end())
+	{
+		if(rate) it->second.tokens += amount;
+		it->second.bytes -= std::min<unsigned long long>(it->second.bytes, amount);
+	}
+	slice_bytes -= std::min<unsigned long long>(slice_bytes, amount);
+}
+
+
+void bandwidth_proxy::relay(uintptr_t from, uintptr_t to, std::string user, bool throttled)
+{
+	std::string buf(16384, '\0');
+	while(running)
+	{
+		auto granted {throttled ? acquire(user, buf.size()) : buf.size()};
+		if(!granted)
+			break;
+		auto received {recv(from, &buf.front(), static_cast<int>(granted), 0)};
+		if(throttled && received < static_cast<int>(granted))
+			refund(user, granted - std::max<int>(received, 0));
+		if(received <= 0 || !send_all(to, buf.data(), received))
+			break;
+	}
+	shutdown(to, SD_SEND);
+}
+
+
+bool bandwidth_proxy::track(uintptr_t s)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	if(!running)
+		return false;
+	sockets.insert(s);
+	return true;
+}
+
+
+void bandwidth_proxy::close(uintptr_t s)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	if(sockets.erase(s))
+		closesocket(s);
+}
+
+
+void bandwidth_proxy::serve(uintptr_t client)
+{
+	// read the request head; anything after it belongs to the tunnel/request body and is forwarded as-is
+	std::string head, extra;
+	char buf[4096];
+	while(head.find("\r\n\r\n") == -1 && head.size() < 65536)
+	{
+		auto received {recv(client, buf, sizeof buf, 0)};
+		if(received <= 0)
+		{
+			close(client);
+			return;
+		}
+		head.append(buf, received);
+	}
+	auto pos {head.find("\r\n\r\n")};
+	if(pos == -1)
+	{
+		close(client);
+		return;
+	}
+	extra = head.substr(pos + 4);
+	head.erase(pos + 2);
+
+	auto eol {head.find("\r\n")};
+	std::string reqline {head.substr(0, eol)}, headers {head.substr(eol + 2)};
+	auto sp1 {reqline.find(' ')}, sp2 {reqline.rfind(' ')};
+	if(sp1 == -1 || sp2 == sp1)
+	{
+		close(client);
+		return;
+	}
+	std::string method {reqline.substr(0, sp1)}, target {reqline.substr(sp1 + 1, sp2 - sp1 - 1)}, version {reqline.substr(sp2 + 1)};
+
+	std::string user {"anonymous"}, newheaders;
+	std::stringstream ss {headers};
+	for(std::string line; std::getline(ss, line);)
+	{
+		if(!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if(line.empty()) continue;
+		std::string name {line.substr(0, line.find(':'))};
+		std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+		if(name == "proxy-authorization")
+		{
+			auto pos {line.find("Basic ")};
+			if(pos != -1)
+			{
+				auto creds {base64_decode(line.substr(pos + 6))};
+				user = creds.substr(0, creds.find(':'));
+			}
+		}
+		else if(name != "proxy-connection" && name != "connection")
+			newheaders += line + "\r\n";
+	}
+
+	bool known_user;
+	{
+		std::lock_guard<std::mutex> lock {mtx};
+		known_user = buckets.contains(user);
+	}
+	if(!known_user)
+	{
+		const std::string reply {"HTTP/1.1 407 Proxy Authentication Required\r\nConnection: close\r\n\r\n"};
+		send_all(client, reply.data(), reply.size());
+		close(client);
+		return;
+	}
+
+	std::string host, port;
+	SOCKET upstream {INVALID_SOCKET};
+	if(method == "CONNECT")
+	{
+		split_hostport(target, host, port, "443");
+		upstream = connect_to(host, port);
+		if(upstream != INVALID_SOCKET)
+		{
+			const std::string reply {version + " 200 Connection established\r\n\r\n"};
+			send_all(client, reply.data(), reply.size());
+		}
+	}
+	else if(target.find("http://") == 0)
+	{
+		auto path_pos {target.find('/', 7)};
+		split_hostport(target.substr(7, path_pos == -1 ? -1 : path_pos - 7), host, port, "80");
+		upstream = connect_to(host, port);
+		if(upstream != INVALID_SOCKET)
+		{
+			// one request per connection, so the tunnel below can't end up carrying requests meant for another host
+			auto req {method + ' ' + (path_pos == -1 ? "/" : target.substr(path_pos)) + ' ' + version + "\r\n" +
+				newheaders + "Connection: close\r\n\r\n"};
+			send_all(upstream, req.data(), req.size());
+		}
+	}
+	else
+	{
+		const std::string reply {"HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n"};
+		send_all(client, reply.data(), reply.size());
+		close(client);
+		return;
+	}
+
+	if(upstream != INVALID_SOCKET && !track(upstream))
+	{
+		closesocket(upstream);
+		close(client);
+		return;
+	}
+	if(upstream == INVALID_SOCKET)
+	{
+		const std::string reply {"HTTP/1.1 502 Bad Gateway\r\nConnection: close\r\n\r\n"};
+		send_all(client, reply.data(), reply.size());
+		close(client);
+		return;
+	}
+
+	if(!extra.empty())
+		send_all(upstream, extra.data(), extra.size());
+
+	// only the download direction is metered; the requests going up are tiny in comparison
+	std::thread thr_up {[this, client, upstream, user] { relay(client, upstream, user, false); }};
+	relay(upstream, client, user, true);
+	thr_up.join();
+	close(upstream);
+	close(client);
+}
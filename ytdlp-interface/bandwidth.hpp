@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+
+/* Local HTTP proxy that keeps the combined throughput of all the yt-dlp processes routed through it under a global
+   budget. Each queue item talks to the proxy with its own username, which selects its bucket. Every 100 ms, the budget
+   for that slice of time is split evenly between the buckets that are moving data, so the shares rebalance by
+   themselves as items start and finish, and an item that can't use its share leaves it to the others. */
+
+class bandwidth_proxy
+{
+public:
+	struct stats_t
+	{
+		unsigned long long bytes {0};
+		double secs {0};
+	};
+
+	~bandwidth_proxy();
+	void budget(unsigned long long bytes_per_sec);
+	unsigned long long budget() { return rate; }
+	std::wstring proxy_url(std::wstring item); // starts the proxy on first use; empty string if it couldn't be started
+	stats_t release(std::wstring item); // the item's process has exited
+	unsigned long long total_rate(); // actual combined throughput over the last second, in bytes per second
+	std::string error() { return err; }
+
+private:
+	struct bucket_t
+	{
+		unsigned long long tokens {0}, bytes {0};
+		std::chrono::steady_clock::time_point start {std::chrono::steady_clock::now()};
+		bool active {false}; // moved data or waited for tokens during the current slice
+	};
+
+	struct client_t
+	{
+		std::thread thr;
+		std::atomic_bool done {false};
+	};
+
+	bool start();
+	void serve(uintptr_t client);
+	bool track(uintptr_t s); // registers an open socket, so that the destructor can close it; false if it's shutting down
+	void close(uintptr_t s); // closes a socket, unless the destructor already did
+	void relay(uintptr_t from, uintptr_t to, std::string user, bool throttled);
+	size_t acquire(const std::string &user, size_t want);
+	void refund(const std::string &user, size_t amount);
+
+	static constexpr int slices_per_sec {10};
+	std::map<std::string, bucket_t> buckets;
+	std::map<std::wstring, std::string> users; // queue item URL -> proxy username
+	std::deque<unsigned long long> slices; // bytes granted in each of the last slices
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::thread thr_accept, thr_refill;
+	std::list<client_t> clients; // the threads serving the connections; only the accept thread adds or removes them
+	std::set<uintptr_t> sockets; // open sockets of the connections being served
+	uintptr_t listener {~uintptr_t {0}};
+	unsigned short port {0};
+	unsigned long long rate {0}, slice_bytes {0};
+	unsigned next_user {1};
+	std::atomic<bool> running {false};
+	std::string err;
+};
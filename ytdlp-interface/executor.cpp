@@ -0,0 +1,75 @@
+#include "executor.hpp"
+
+#include <algorithm>
+
+
+executor::executor(unsigned io_threads, unsigned cpu_threads)
+{
+	for(auto [which, count] : {std::pair {pool::io, io_threads}, std::pair {pool::cpu, cpu_threads}})
+	{
+		auto &p {pools[static_cast<int>(which)]};
+		for(unsigned n {0}; n < std::max(1u, count); n++)
+			p.workers.emplace_back([this, &p] { work(p); });
+	}
+}
+
+
+void executor::enqueue(pool which, job_t job)
+{
+	auto &p {pools[static_cast<int>(which)]};
+	{
+		std::lock_guard lock {p.mtx};
+		if(!stopping)
+		{
+			p.jobs.push_back(std::move(job));
+			p.cv.notify_one();
+			return;
+		}
+	}
+	job(stop.get_token()); // after shutdown, the task runs here, already stopped, so that its future gets a result
+}
+
+
+void executor::work(pool_t &p)
+{
+	for(;;)
+	{
+		std::unique_lock lock {p.mtx};
+		p.cv.wait(lock, [&] { return !p.jobs.empty() || stopping; });
+		if(p.jobs.empty())
+			return; // stopping, and nothing left to run
+		auto job {std::move(p.jobs.front())};
+		p.jobs.pop_front();
+		p.active++;
+		lock.unlock();
+		job(stop.get_token());
+		lock.lock();
+		p.active--;
+		p.completed++;
+	}
+}
+
+
+void executor::shutdown()
+{
+	std::lock_guard guard {shutdown_mtx};
+	stopping = true;
+	for(auto &p : pools)
+		std::lock_guard lock {p.mtx}; // a worker that's about to wait sees stopping, or is woken up below
+	stop.request_stop();
+	for(auto &p : pools)
+	{
+		p.cv.notify_all();
+		for(auto &worker : p.workers)
+			if(worker.joinable())
+				worker.join();
+	}
+}
+
+
+executor::metrics_t executor::metrics(pool which) const
+{
+	const auto &p {pools[static_cast<int>(which)]};
+	std::lock_guard lock {p.mtx};
+	return {p.workers.size(), p.jobs.size(), p.active, p.completed};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stop_token>
+#include <type_traits>
+#include <condition_variable>
+
+/* Fixed sets of worker threads that run the program's background work, instead of a thread started for each job:
+   the I/O pool is for work that mostly waits (child processes, network), the CPU pool for work that keeps a core busy.
+   A task gets a stop_token, which is how it's asked to stop (it has to check the token, or a flag that's tied to it),
+   and its result is delivered through a future. shutdown() asks all the tasks to stop, lets the queued ones run with
+   their tokens already stopped, and waits for all of them, so that nothing runs after it returns. */
+
+class executor
+{
+public:
+	enum class pool : unsigned char { io, cpu };
+
+	template<typename T> class task
+	{
+	public:
+		bool valid() const { return result.valid(); }
+		bool running() const { return result.valid() && result.wait_for(std::chrono::seconds {0}) != std::future_status::ready; }
+		void cancel() { stop.request_stop(); }
+		void wait() const { if(result.valid()) result.wait(); }
+		T get() { return result.get(); } // waits for the result, after which the task is no longer valid
+
+	private:
+		friend class executor;
+		std::future<T> result;
+		std::stop_source stop;
+	};
+
+	struct metrics_t { size_t threads {0}, queued {0}, active {0}, completed {0}; };
+
+	executor(unsigned io_threads, unsigned cpu_threads);
+	~executor() { shutdown(); }
+	executor(const executor &) = delete;
+	executor &operator=(const executor &) = delete;
+
+	template<typename F> auto submit(pool which, F fn) -> task<std::invoke_result_t<F, std::stop_token>>;
+	void shutdown();
+	metrics_t metrics(pool which) const;
+
+private:
+	using job_t = std::function<void(std::stop_token)>; // gets the executor's own token (see submit)
+
+	struct pool_t
+	{
+		std::vector<std::thread> workers;
+		std::deque<job_t> jobs;
+		mutable std::mutex mtx;
+		std::condition_variable cv;
+		size_t active {0}, completed {0};
+	};
+
+	void enqueue(pool which, job_t job);
+	void work(pool_t &p);
+
+	pool_t pools[2];
+	std::stop_source stop; // requested by shutdown
+	std::atomic_bool stopping {false};
+	std::mutex shutdown_mtx;
+};
+
+
+template<typename F>
+auto executor::submit(pool which, F fn) -> task<std::invoke_result_t<F, std::stop_token>>
+{
+	using T = std::invoke_result_t<F, std::stop_token>;
+	task<T> t;
+	auto job {std::make_shared<std::packaged_task<T(std::stop_token)>>(std::move(fn))};
+	t.result = job->get_future();
+	enqueue(which, [job, task_stop = t.stop](std::stop_token executor_stop) mutable
+	{
+		// a shutdown stops the task as well as a cancel() does
+		std::stop_callback on_shutdown {executor_stop, [&task_stop] { task_stop.request_stop(); }};
+		(*job)(task_stop.get_token());
+	});
+	return t;
+}
@@ -7,7 +7,8 @@ void GUI::fm_formats()
 	using ::widgets::theme;
 	auto url {bottoms.visible()};
 	auto &bottom {bottoms.at(url)};
-	auto &vidinfo {bottom.vidinfo};
+	auto vidinfo {bottom.full_vidinfo()}; // the thumbnails and chapters aren't among the fields kept parsed
+	auto vidinfo_contains = [&vidinfo](const std::string &key) { return vidinfo.contains(key) && vidinfo[key] != nullptr; };
 
 	themed_form fm {nullptr, *this, {}, appear::decorate<appear::minimize, appear::sizable>{}};
 	fm.caption(title + " - manual selection of formats");
@@ -186,14 +187,14 @@ void GUI::fm_formats()
 		fm.close();
 	});
 
-	auto get_int = [](const nlohmann::json &j, const std::string &key) -> std::string
+	auto get_int = [](int val) -> std::string
 	{
-		return (j.contains(key) && j[key] != nullptr) ? std::to_string(j[key].get<unsigned>()) : "---";
+		return val != -1 ? std::to_string(val) : "---";
 	};
 
-	auto get_string = [](const nlohmann::json &j, const std::string &key) -> std::string
+	auto get_string = [](const std::string &str) -> std::string
 	{
-		return (j.contains(key) && j[key] != nullptr) ? j[key].get<std::string>() : "---";
+		return str.empty() ? "---" : str;
 	};
 
 	btnok.events().click([&, this]
@@ -252,28 +253,22 @@ void GUI::fm_formats()
 
 		if(sel.size() == 1)
 		{
-			auto item {lbq.at(lbq.selected().front())};
-			auto it {std::find_if(vidinfo["formats"].begin(), vidinfo["formats"].end(), [&](const auto &el)
-			{
-				return el["format"].get<std::string>().rfind(nana::to_utf8(strfmt)) != -1;
-			})};
-			std::string fsize {"---"}, fmt_note, ext, fmtid;
-			if(it != vidinfo["formats"].end())
+			auto pqi {queue_items.find(bottom.url)};
+			std::string fsize {"---"};
+			if(auto it {bottom.formats.find(nana::to_utf8(strfmt))}; it && pqi)
 			{
 				auto &fmt {*it};
-				if(fmt.contains("filesize") && fmt["filesize"] != nullptr)
-					fsize = util::int_to_filesize(fmt["filesize"], false);
+				if(fmt.filesize)
+					fsize = '~' + util::int_to_filesize(fmt.filesize, false);
 				if(list.at(sel.front().cat).text() == "Audio only")
-					fmt_note = get_string(fmt, "format_note");
-				else fmt_note = get_string(fmt, "resolution");
-				ext = get_string(fmt, "ext");
-				fmtid = get_string(fmt, "format_id");
-				item.text(4, fmtid);
-				item.text(5, fmt_note);
-				item.text(6, ext);
-				if(fsize != "---")
-					fsize = '~' + fsize;
-				item.text(7, fsize);
+					pqi->format_note = get_string(fmt.note);
+				else pqi->format_note = get_string(fmt.resolution);
+				pqi->ext = get_string(fmt.ext);
+				pqi->format = get_string(fmt.id);
+				pqi->filesize = fsize;
+				pqi->size = fmt.filesize;
+				pqi->size_approx = true;
+				lbq_update(bottom.url);
 			}
 		}
 
@@ -293,11 +288,11 @@ void GUI::fm_formats()
 	thumb.transparent(true);
 
 	std::string thumb_url, title {"[title missing]"};
-	if(bottom.vidinfo_contains("title"))
+	if(vidinfo_contains("title"))
 		title = vidinfo["title"];
 	if(!bottom.is_ytlink)
 	{
-		if(bottom.vidinfo_contains("thumbnail"))
+		if(vidinfo_contains("thumbnail"))
 			thumb_url = vidinfo["thumbnail"];
 		thumb.stretchable(true);
 		thumb.align(align::center, align_v::center);
@@ -323,9 +318,9 @@ void GUI::fm_formats()
 	list.append({"Audio only", "Video only"});
 
 	int dur {0};
-	bool live {bottom.vidinfo_contains("is_live") && bottom.vidinfo["is_live"] ||
-			bottom.vidinfo_contains("live_status") && bottom.vidinfo["live_status"] == "is_live"};
-	if(!live && bottom.vidinfo_contains("duration"))
+	bool live {vidinfo_contains("is_live") && vidinfo["is_live"] ||
+			vidinfo_contains("live_status") && vidinfo["live_status"] == "is_live"};
+	if(!live && vidinfo_contains("duration"))
 		dur = vidinfo["duration"];
 	int hr {(dur / 60) / 60}, min {(dur / 60) % 60}, sec {dur % 60};
 	if(dur < 60) sec = dur;
@@ -347,23 +342,23 @@ void GUI::fm_formats()
 		ss << sec;
 		durstr += ':' + ss.str();
 	}
-	else if(bottom.vidinfo_contains("duration_string"))
+	else if(vidinfo_contains("duration_string"))
 		durstr = vidinfo["duration_string"];
 	l_durtext.caption(durstr);
 
 	std::string strchap;
-	if(bottom.vidinfo_contains("chapters"))
+	if(vidinfo_contains("chapters"))
 		strchap = std::to_string(vidinfo["chapters"].size());
 	if(strchap.empty() || strchap == "0")
 		l_chaptext.caption("none");
 	else l_chaptext.caption(strchap);
 
-	if(bottom.vidinfo_contains("uploader"))
+	if(vidinfo_contains("uploader"))
 		l_upltext.caption(std::string {vidinfo["uploader"]});
 	else l_upltext.caption("---");
 
 	std::string strdate {"---"};
-	if(bottom.vidinfo_contains("upload_date"))
+	if(vidinfo_contains("upload_date"))
 	{
 		strdate = vidinfo["upload_date"];
 		strdate = strdate.substr(0, 4) + '-' + strdate.substr(4, 2) + '-' + strdate.substr(6, 2);
@@ -372,14 +367,16 @@ void GUI::fm_formats()
 
 	if(!thumb_url.empty())
 	{
-		thr_thumb = std::thread([&]
+		thumb_task = tasks.submit(executor::pool::io, [&, thumb_url, this](std::stop_token stop)
 		{
-			thumbthr_working = true;
 			std::string error;
-			auto thumb_jpg {util::get_inet_res(thumb_url, &error)};
+			auto thumb_jpg {util::get_inet_res(thumb_url, &error, stop)};
+			if(stop.stop_requested())
+				return;
+			paint::image img;
+			std::string text;
 			if(!thumb_jpg.empty())
 			{
-				paint::image img;
 				img.open(thumb_jpg.data(), thumb_jpg.size());
 				if(img.empty())
 				{
@@ -392,25 +389,26 @@ void GUI::fm_formats()
 						ext = thumb_url.substr(pos, idx-pos);
 					}
 					if(ext.empty())
-						thumb_label.caption("thumbnail format unsupported");
-					else thumb_label.caption("thumbnail format unsupported\n(" + ext + ')');
-					fm.get_place().field_display("thumb_label", true);
-					fm.collocate();
+						text = "thumbnail format unsupported";
+					else text = "thumbnail format unsupported\n(" + ext + ')';
 				}
-				else if(thumbthr_working)
-					thumb.load(img);
-				thumbthr_working = false;
-				if(thr_thumb.joinable())
-					thr_thumb.detach();
 			}
-			else
+			else if(error.empty())
+				text = "error downloading thumbnail";
+			else text = error;
+
+			// the form discards this if it's closed before the update is made (see the unload handler)
+			ui_update(ui_queue::kind::other, L"thumbnail", [&, img, text]
 			{
-				if(error.empty())
-					thumb_label.caption("error downloading thumbnail");
-				else thumb_label.caption(error);
-				fm.get_place().field_display("thumb_label", true);
-				fm.collocate();
-			}
+				if(text.empty())
+					thumb.load(img);
+				else
+				{
+					thumb_label.caption(text);
+					fm.get_place().field_display("thumb_label", true);
+					fm.collocate();
+				}
+			});
 		});
 	}
 	else
@@ -421,7 +419,7 @@ void GUI::fm_formats()
 	}
 
 	std::string format_id1, format_id2;
-	if(bottom.vidinfo_contains("format_id"))
+	if(vidinfo_contains("format_id"))
 	{
 		std::string format_id {vidinfo["format_id"]};
 		auto pos(format_id.find('+'));
@@ -434,27 +432,23 @@ void GUI::fm_formats()
 	}
 
 	std::vector<bool> colmask(9, false);
-	for(auto &fmt : vidinfo["formats"])
+	for(auto &fmt : bottom.formats.formats)
 	{
-		std::string format {fmt["format"]}, acodec, vcodec, ext, fps, vbr, abr, asr, filesize {"---"};
-		if(format.find("storyboard") == -1)
+		if(!fmt.storyboard)
 		{
-			abr = get_int(fmt, "abr");
-			vbr = get_int(fmt, "vbr");
-			asr = get_int(fmt, "asr");
-			fps = get_int(fmt, "fps");
-			ext = get_string(fmt, "ext");
-			acodec = get_string(fmt, "acodec");
-			vcodec = get_string(fmt, "vcodec");
-			if(fmt.contains("filesize") && fmt["filesize"] != nullptr)
-				filesize = util::int_to_filesize(fmt["filesize"]);
+			const auto &format {fmt.format};
+			auto acodec {get_string(fmt.acodec_str)}, vcodec {get_string(fmt.vcodec_str)}, ext {get_string(fmt.ext)},
+				fps {get_int(fmt.fps)}, vbr {get_int(fmt.vbr)}, abr {get_int(fmt.abr)}, asr {get_int(fmt.asr)};
+			std::string filesize {"---"};
+			if(fmt.filesize)
+				filesize = util::int_to_filesize(fmt.filesize);
 			unsigned catidx {0};
-			if(acodec == "none")
+			if(fmt.video_only())
 				catidx = 2; // video only
-			else if(vcodec == "none")
+			else if(fmt.audio_only())
 				catidx = 1; // audio only
 			list.at(catidx).append({format, acodec, vcodec, ext, fps, vbr, abr, asr, filesize});
-			auto idstr {to_wstring(fmt["format_id"].get<std::string>())};
+			auto idstr {to_wstring(fmt.id)};
 			auto item {list.at(catidx).back()};
 			item.value(idstr);
 			if(idstr == conf.fmt1 || (conf.audio_multistreams ? conf.fmt2.find(idstr) != -1 : idstr == conf.fmt2))
@@ -487,11 +481,9 @@ void GUI::fm_formats()
 
 	fm.events().unload([&]
 	{
-		if(thr_thumb.joinable())
-		{
-			thumbthr_working = false;
-			thr_thumb.detach();
-		}
+		thumb_task.cancel();
+		thumb_task.wait();
+		ui.discard(L"thumbnail");
 	});
 
 	fm.theme_callback([&, this](bool dark)
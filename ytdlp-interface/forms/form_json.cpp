@@ -16,7 +16,8 @@ void GUI::fm_json()
 	fm.div("vert margin=20 <tree> <weight=20> <label weight=48>");
 
 	auto &bottom {bottoms.current()};
-	::widgets::JSON_Tree t {fm, bottom.playlist_info.empty() ? bottom.vidinfo : bottom.playlist_info, conf.json_hide_null};
+	const auto vidinfo {bottom.playlist_info.empty() ? bottom.full_vidinfo() : nlohmann::json {}}; // for as long as the viewer is open
+	::widgets::JSON_Tree t {fm, bottom.playlist_info.empty() ? vidinfo : bottom.playlist_info, conf.json_hide_null};
 	::widgets::Label lcmd {fm, ""};
 
 	fm["tree"] << t;
@@ -0,0 +1,121 @@
+#include "../gui.hpp"
+#include <nana/gui/filebox.hpp>
+
+
+void GUI::fm_memory()
+{
+	using widgets::theme;
+	using namespace nana;
+
+	themed_form fm {nullptr, *this, {}, appear::decorate<appear::sizable, appear::minimize>{}};
+	fm.center(1000, 600);
+	fm.caption(title + " - memory usage");
+	fm.bgcolor(theme::fmbg);
+	fm.snap(conf.cbsnap);
+	fm.div(R"(vert margin=20
+		<lb> <weight=20> <l_totals weight=110> <weight=20>
+		<weight=35 <> <btnrefresh weight=100> <weight=20> <btnexport weight=140> <weight=20> <btnclose weight=100> <>>
+	)");
+
+	::widgets::Listbox lb {fm, true};
+	::widgets::Label l_totals {fm, ""};
+	::widgets::Button btnrefresh {fm, "Refresh"}, btnexport {fm, "Export as JSON"}, btnclose {fm, "Close"};
+
+	fm["lb"] << lb;
+	fm["l_totals"] << l_totals;
+	fm["btnrefresh"] << btnrefresh;
+	fm["btnexport"] << btnexport;
+	fm["btnclose"] << btnclose;
+
+	l_totals.typeface(paint::font_info {"Tahoma", 10});
+	l_totals.text_align(align::left, align_v::top);
+
+	lb.sortable(false);
+	lb.enable_single(true, false);
+	lb.typeface(paint::font_info {"Calibri", 12});
+	lb.scheme().item_height_ex = 8;
+	lb.append_header("#", dpi_transform(40));
+	lb.append_header("Website", dpi_transform(160));
+	lb.append_header("Media info", dpi_transform(100));
+	lb.append_header("Packed info", dpi_transform(100));
+	lb.append_header("Formats", dpi_transform(90));
+	lb.append_header("Playlist info", dpi_transform(100));
+	lb.append_header("Output", dpi_transform(90));
+	lb.append_header("Widgets", dpi_transform(80));
+	lb.append_header("Total", dpi_transform(100));
+	lb.column_movable(false);
+
+	nlohmann::json report;
+
+	auto populate = [&, this]
+	{
+		report = memory_report();
+		auto size_str = [](const nlohmann::json &j) { return util::int_to_filesize(j.get<unsigned long long>(), false); };
+
+		lb.auto_draw(false);
+		lb.clear();
+		for(const auto &item : report["items"])
+		{
+			lb.at(0).append({item["index"].get<std::string>(), item["website"].get<std::string>(), size_str(item["vidinfo"]),
+				size_str(item["vidinfo_packed"]), size_str(item["formats"]), size_str(item["playlist_info"]), size_str(item["output"]),
+				size_str(item["widgets"]), size_str(item["total"])});
+		}
+		const auto &totals {report["totals"]};
+		lb.at(0).append({"", "All items", size_str(totals["vidinfo"]), size_str(totals["vidinfo_packed"]), size_str(totals["formats"]),
+			size_str(totals["playlist_info"]), size_str(totals["output"]), size_str(totals["widgets"]), size_str(totals["total"])});
+		lb.auto_draw(true);
+
+		const auto &proc {report["process"]};
+		auto mb = [](const nlohmann::json &j) { return util::format_float(j.get<unsigned long long>() / 1048576.0, 1) + " MB"; };
+		const auto &updates {report["ui_updates"]};
+		auto pool = [](const nlohmann::json &j)
+		{
+			return std::to_string(j["active"].get<size_t>()) + " of " + std::to_string(j["threads"].get<size_t>()) +
+				" threads busy, " + std::to_string(j["queued"].get<size_t>()) + " tasks queued, " +
+				std::to_string(j["completed"].get<size_t>()) + " done";
+		};
+		l_totals.caption("Process: working set " + mb(proc["working_set"]) + " (peak " + mb(proc["peak_working_set"]) +
+			"), private bytes " + mb(proc["private_bytes"]) + "\nThreads: " + std::to_string(proc["threads"].get<unsigned>()) +
+			", handles: " + std::to_string(proc["handles"].get<unsigned>()) + ", GDI objects: " +
+			std::to_string(proc["gdi_objects"].get<unsigned>()) + ", USER objects: " + std::to_string(proc["user_objects"].get<unsigned>()) +
+			"\nFavicons: " + std::to_string(report["favicons"]["count"].get<size_t>()) + " (" + size_str(report["favicons"]["bytes"]) +
+			"), output not tied to a queue item: " + size_str(report["output_shared"]) +
+			"\nBackground tasks: I/O pool " + pool(report["tasks"]["io"]) + "; CPU pool " + pool(report["tasks"]["cpu"]) +
+			"\nWidget updates from the worker threads: " + std::to_string(updates["posted"].get<size_t>()) + " posted, " +
+			std::to_string(updates["coalesced"].get<size_t>()) + " merged into pending ones, " + std::to_string(updates["batches"].get<size_t>()) +
+			" batches of up to " + std::to_string(updates["max_batch"].get<size_t>()) + ", latency " +
+			util::format_float(updates["avg_latency_ms"].get<double>(), 1) + " ms on average (max " +
+			util::format_float(updates["max_latency_ms"].get<double>(), 1) + " ms)");
+	};
+
+	btnrefresh.events().click(populate);
+	btnclose.events().click([&] { fm.close(); });
+
+	btnexport.events().click([&, this]
+	{
+		filebox fb {fm, false};
+		fb.init_path(conf.outpath);
+		fb.init_file("ytdlp-interface memory.json");
+		fb.allow_multi_select(false);
+		fb.add_filter("JSON data format", "*.json");
+		fb.title("Save as");
+		auto res {fb()};
+		if(res.size())
+			std::ofstream {res.front()} << std::setw(4) << report;
+	});
+
+	fm.theme_callback([&, this](bool dark)
+	{
+		apply_theme(dark);
+		fm.bgcolor(theme::fmbg);
+		return false;
+	});
+
+	if(conf.cbtheme == 2)
+		fm.system_theme(true);
+	else fm.dark_theme(conf.cbtheme == 0);
+
+	populate();
+	fm.collocate();
+	fm.modality();
+}
\ No newline at end of file
@@ -76,11 +76,10 @@ void GUI::fm_settings()
 		if(fn_write_conf)
 		{
 			conf.unfinished_queue_items.clear();
-			for(auto item : lbq.at(0))
+			for(auto &item : queue_items)
 			{
-				auto text {item.text(3)};
-				if(text != "done" && text != "error")
-					conf.unfinished_queue_items.push_back(nana::to_utf8(item.value<lbqval_t>().url));
+				if(item->state != queue_model::status::done && item->state != queue_model::status::error)
+					conf.unfinished_queue_items.push_back(nana::to_utf8(item->url));
 			}
 			conf.zoomed = is_zoomed(true);
 			if(conf.zoomed || is_zoomed(false)) restore();
@@ -145,7 +144,7 @@ void GUI::fm_settings()
 	widgets::Textbox tb_template {ytdlp}, tb_playlist {ytdlp}, tb_proxy {ytdlp};
 	widgets::Combox com_res {ytdlp}, com_video {ytdlp}, com_audio {ytdlp}, com_vcodec {ytdlp}, com_acodec {ytdlp};
 	widgets::cbox cbfps {ytdlp, "Prefer a higher framerate"}, cbtheme_dark {gui, "Dark"}, cbtheme_light {gui, "Light"},
-		cbtheme_system {gui, "System preference"}, cb_lengthyproc {queuing, "Start next item on lengthy processing"},
+		cbtheme_system {gui, "System preference"}, cb_lengthyproc {queuing, "Post-process outside the download slots"},
 		cb_common {queuing, "Each queue item has its own download options"},
 		cb_autostart {queuing, "When stopping a queue item, automatically start the next one"},
 		cb_queue_autostart {queuing, "When the program starts, automatically start processing the queue"},
@@ -154,11 +153,24 @@ void GUI::fm_settings()
 		cb_mark {sblock, "Mark these categories:"}, cb_remove {sblock, "Remove these categories:"}, cb_proxy {ytdlp, "Use this proxy:"},
 		cbsnap {gui, "Snap windows to screen edges"}, cbminw {gui, "No minimum width for the main window"},
 		cb_premium {ytdlp, "[YouTube] For 1080p, prefer the \"premium\" format with enhanced bitrate"},
-		cb_save_errors {queuing, "Save queue items with \"error\" status to the settings file"};
+		cb_save_errors {queuing, "Save queue items with \"error\" status to the settings file"},
+		cb_ratelim_global {queuing, "Global download rate limit, shared by all running items:"},
+		cb_adaptive {queuing, "Adapt the number of concurrent downloads to the throughput, between"},
+		cb_domain_limits {queuing, "Max concurrent downloads from the same website:"},
+		cb_load_info_json {queuing, "Start single-video downloads from the media info that was already extracted"},
+		cb_playlist_sync {queuing, "Sync playlists and channel tabs by fetching only the entries added since last time"},
+		cb_lowprio {queuing, "Run yt-dlp and ffmpeg at low priority"},
+		cb_fragments {queuing, "Fragment connections in total:"},
+		cb_shards {queuing, "Split playlists across free slots"};
 	widgets::Separator sep1 {ytdlp}, sep2 {ytdlp}, sep3 {gui}, sep4 {fm};
 	widgets::Button btn_close {fm, " Close"}, btn_default {ytdlp, "Reset to default", true},
 		btn_playlist_default {ytdlp, "Reset to default", true}, btn_info {ytdlp};
-	widgets::Spinbox sb_maxdl {queuing};
+	widgets::Spinbox sb_maxdl {queuing}, sb_adapt_min {queuing}, sb_adapt_max {queuing};
+	widgets::Label l_adapt_and {queuing, "and"}, l_domain_spacing {queuing, "Seconds between starts on the same website:"},
+		l_prefetch {queuing, "Keep items ready:"};
+	widgets::Spinbox sb_domain_max {queuing}, sb_domain_spacing {queuing}, sb_fragments {queuing}, sb_prefetch {queuing};
+	widgets::Textbox tb_ratelim_global {queuing};
+	widgets::Combox com_ratelim_global {queuing};
 	widgets::Slider slider {gui};
 	widgets::sblock_listbox lbmark {sblock}, lbremove {sblock};
 	widgets::Infobox l_info {sblock};
@@ -364,10 +376,17 @@ void GUI::fm_settings()
 
 	queuing.div(R"(vert		
 		<weight=25 <l_maxdl weight=216> <weight=10> <sb_maxdl weight=40> <> <cb_lengthyproc weight=318>> <weight=20>
+		<weight=25 <cb_adaptive weight=500> <weight=10> <sb_adapt_min weight=40> <weight=10> <l_adapt_and weight=28> 
+			<weight=10> <sb_adapt_max weight=40> <>> <weight=20>
+		<weight=25 <cb_domain_limits weight=360> <weight=10> <sb_domain_max weight=40> <> 
+			<l_domain_spacing weight=305> <weight=10> <sb_domain_spacing weight=40>> <weight=20>
 		<weight=25 <cb_autostart weight=508>> <weight=20>
-		<weight=25 <cb_common weight=408>> <weight=20>
-		<weight=25 <cb_queue_autostart>> <weight=20>
-		<weight=25 <cb_save_errors>> <weight=20>
+		<weight=25 <cb_common weight=408> <> <cb_fragments weight=230> <weight=10> <sb_fragments weight=40>> <weight=20>
+		<weight=25 <cb_queue_autostart weight=470> <> <cb_shards weight=250>> <weight=20>
+		<weight=25 <cb_save_errors weight=460> <> <cb_lowprio weight=270>> <weight=20>
+		<weight=25 <cb_load_info_json weight=540> <> <l_prefetch weight=120> <weight=10> <sb_prefetch weight=40>> <weight=20>
+		<weight=25 <cb_playlist_sync>> <weight=20>
+		<weight=25 <cb_ratelim_global weight=430> <weight=10> <tb_ratelim_global weight=45> <weight=15> <com_ratelim_global weight=55> <>>
 	)");
 
 	l_maxdl.text_align(nana::align::left, nana::align_v::center);
@@ -375,6 +394,10 @@ void GUI::fm_settings()
 	{
 		change_field_attr(queuing.get_place(), "l_maxdl", "weight", 196);
 		change_field_attr(queuing.get_place(), "cb_lengthyproc", "weight", 290);
+		change_field_attr(queuing.get_place(), "cb_ratelim_global", "weight", 400);
+		change_field_attr(queuing.get_place(), "cb_adaptive", "weight", 460);
+		change_field_attr(queuing.get_place(), "cb_domain_limits", "weight", 330);
+		change_field_attr(queuing.get_place(), "l_domain_spacing", "weight", 280);
 	}
 
 	queuing["l_maxdl"] << l_maxdl;
@@ -384,6 +407,47 @@ void GUI::fm_settings()
 	queuing["cb_common"] << cb_common;
 	queuing["cb_queue_autostart"] << cb_queue_autostart;
 	queuing["cb_save_errors"] << cb_save_errors;
+	queuing["cb_lowprio"] << cb_lowprio;
+	queuing["cb_fragments"] << cb_fragments;
+	queuing["cb_shards"] << cb_shards;
+	queuing["sb_fragments"] << sb_fragments;
+	queuing["cb_load_info_json"] << cb_load_info_json;
+	queuing["l_prefetch"] << l_prefetch;
+	queuing["sb_prefetch"] << sb_prefetch;
+	queuing["cb_playlist_sync"] << cb_playlist_sync;
+	queuing["cb_ratelim_global"] << cb_ratelim_global;
+	queuing["cb_adaptive"] << cb_adaptive;
+	queuing["sb_adapt_min"] << sb_adapt_min;
+	queuing["l_adapt_and"] << l_adapt_and;
+	queuing["sb_adapt_max"] << sb_adapt_max;
+
+	queuing["cb_domain_limits"] << cb_domain_limits;
+	queuing["sb_domain_max"] << sb_domain_max;
+	queuing["l_domain_spacing"] << l_domain_spacing;
+	queuing["sb_domain_spacing"] << sb_domain_spacing;
+
+	l_adapt_and.text_align(nana::align::center, nana::align_v::center);
+	l_domain_spacing.text_align(nana::align::left, nana::align_v::center);
+	l_prefetch.text_align(nana::align::left, nana::align_v::center);
+	cb_domain_limits.check(conf.cb_domain_limits);
+	cb_adaptive.check(conf.cb_adaptive_concurrency);
+	queuing["tb_ratelim_global"] << tb_ratelim_global;
+	queuing["com_ratelim_global"] << com_ratelim_global;
+
+	cb_ratelim_global.check(conf.cb_ratelim_global);
+	tb_ratelim_global.multi_lines(false);
+	tb_ratelim_global.padding(0, 5, 0, 5);
+	if(conf.ratelim_global)
+		tb_ratelim_global.caption(util::format_float(conf.ratelim_global, 1));
+	tb_ratelim_global.set_accept([&](wchar_t wc)->bool
+	{
+		return wc == nana::keyboard::backspace || wc == nana::keyboard::del ||
+			((isdigit(wc) || wc == '.') && tb_ratelim_global.text().size() < 5);
+	});
+	com_ratelim_global.editable(false);
+	com_ratelim_global.push_back(" KB/s");
+	com_ratelim_global.push_back(" MB/s");
+	com_ratelim_global.option(conf.ratelim_global_unit);
 
 	gui.div(R"(vert		
 		<weight=25 <l_theme weight=100> <weight=20> <cbtheme_dark weight=65> <weight=20> 
@@ -416,6 +480,11 @@ void GUI::fm_settings()
 	gui["cb_origin_curdir"] << cb_origin_curdir;
 
 	cb_save_errors.check(conf.cb_save_errors);
+	cb_load_info_json.check(conf.cb_load_info_json);
+	cb_playlist_sync.check(conf.cb_playlist_sync);
+	cb_lowprio.check(conf.cb_lowprio);
+	cb_fragments.check(conf.cb_auto_fragments);
+	cb_shards.check(conf.cb_playlist_shards);
 
 	cbminw.check(conf.cbminw);
 	cbminw.events().checked([&, this]
@@ -481,6 +550,18 @@ void GUI::fm_settings()
 
 	sb_maxdl.range(1, 10, 1);
 	sb_maxdl.value(std::to_string(conf.max_concurrent_downloads));
+	sb_adapt_min.range(1, 10, 1);
+	sb_adapt_min.value(std::to_string(conf.adaptive_min));
+	sb_adapt_max.range(1, 10, 1);
+	sb_adapt_max.value(std::to_string(conf.adaptive_max));
+	sb_domain_max.range(1, 10, 1);
+	sb_domain_max.value(std::to_string(conf.domain_max));
+	sb_domain_spacing.range(0, 60, 1);
+	sb_domain_spacing.value(std::to_string(conf.domain_spacing / 1000));
+	sb_prefetch.range(0, 10, 1);
+	sb_prefetch.value(std::to_string(conf.prefetch_depth));
+	sb_fragments.range(2, 64, 1);
+	sb_fragments.value(std::to_string(conf.fragment_budget));
 
 	slider.maximum(30);
 	slider.value(conf.contrast * 100);
@@ -490,7 +571,7 @@ void GUI::fm_settings()
 		theme::contrast(conf.contrast);
 		fm.bgcolor(theme::fmbg);
 		apply_theme(theme::is_dark());
-		nana::api::refresh_window(bottoms.current().gpopt);
+		nana::api::refresh_window(bottoms.current().view->gpopt);
 		tb_template.refresh_theme();
 		tb_playlist.refresh_theme();
 		com_audio.refresh_theme();
@@ -499,6 +580,14 @@ void GUI::fm_settings()
 		cb_autostart.refresh_theme();
 		cb_common.refresh_theme();
 		sb_maxdl.refresh_theme();
+		sb_adapt_min.refresh_theme();
+		sb_adapt_max.refresh_theme();
+		sb_domain_max.refresh_theme();
+		sb_domain_spacing.refresh_theme();
+		sb_fragments.refresh_theme();
+		sb_prefetch.refresh_theme();
+		tb_ratelim_global.refresh_theme();
+		com_ratelim_global.refresh_theme();
 		cbfps.refresh_theme();
 		cb_queue_autostart.refresh_theme();
 		btn_save.refresh_theme();
@@ -552,6 +641,60 @@ void GUI::fm_settings()
 		cb_origin_curdir.check(true);
 	else cb_origin_progdir.check(true);
 
+	const auto domain_tip {"Queue items from the same website (as shown in the website column) are limited\n"
+		"to this many concurrent downloads, and are started with at least the given number of\nseconds between them. When "
+		"a website is at its limit, the queue starts items from other\nwebsites first, instead of waiting.\n\n"
+		"Individual websites can be given their own limit in the settings file, under\n<bold>\"domain_limits\"</> -> "
+		"<bold>\"overrides\"</> (for example <bold>\"youtube.com\": 3</>)."};
+	cb_domain_limits.tooltip(domain_tip);
+	l_domain_spacing.tooltip(domain_tip);
+	sb_domain_spacing.tooltip(domain_tip);
+
+	cb_adaptive.tooltip("Instead of always running the number of downloads set above, let the program find\n"
+		"the number that gives the best combined download rate. Some websites limit the speed\nof each connection, "
+		"so running more downloads at the same time helps; others limit the\ntotal speed per IP address, and more downloads "
+		"only lead to errors.\n\nEvery 10 seconds, the program adds another concurrent download while the combined\nrate "
+		"keeps rising, and removes one when the rate stops improving or when downloads\nstart failing (HTTP errors 403/429). "
+		"The number above is where it starts from.\nThe decisions are logged in the output of the running queue items.");
+
+	cb_ratelim_global.tooltip("Caps the combined download rate of all the queue items that are running at the same\n"
+		"time. The program routes yt-dlp through a small proxy of its own (on this computer only),\nwhich divides the limit "
+		"evenly between the running items, and redistributes it whenever\nan item starts or finishes.\n\nWhen this is enabled, "
+		"the rate limit in the download options is ignored. If a proxy is\nset on the yt-dlp page (or with <bold>--proxy</> in "
+		"the custom arguments), yt-dlp can't be\nrouted through the program's proxy, so each item is limited to an equal fixed "
+		"part of\nthe global limit instead (the limit divided by the max number of concurrent downloads).");
+
+	cb_load_info_json.tooltip("When a URL is added, the program has yt-dlp extract the media info to show it. Normally,\n"
+		"yt-dlp extracts it again when the download starts. With this option, the info that was\nalready extracted is "
+		"passed to yt-dlp (<bold>--load-info-json</>), which saves the time of a second\nextraction.\n\n"
+		"The URL is used as usual if the info is older than 30 minutes, if the format URLs\nin it are about to expire, if the "
+		"proxy setting has changed, or if the custom arguments\ncontain options that affect the extraction (cookies, login, "
+		"headers, geo-bypass, etc).\nDoesn't apply to playlists, channels, and live streams.");
+	const auto prefetch_tip {"How many of the next queue items to keep ready to start. While the queue is running, the\n"
+		"media info of these items is extracted again shortly before it would be too old to be\nreused (one item at a time), "
+		"so that when a download slot frees up, the next item starts\nfrom fresh info right away. 0 turns this off.\n\n"
+		"Works together with the option on the left. The time each item saves is shown in its\noutput when it starts."};
+	l_prefetch.tooltip(prefetch_tip);
+	sb_prefetch.tooltip(prefetch_tip);
+	cb_playlist_sync.tooltip("The program keeps a copy of the entries of each playlist and channel tab it has listed. When\n"
+		"the same list is listed again, it asks yt-dlp only for its newest entries, until it meets one it\nalready knows, "
+		"and only the new entries are selected for download. For a channel with\nthousands of videos, this usually takes a "
+		"single small request instead of listing them all.\n\nIf the list has changed in some other way (entries removed "
+		"or reordered), it's listed whole.");
+	cb_fragments.tooltip("Videos in HLS or DASH formats are downloaded as many small fragments. yt-dlp\n"
+		"fetches them one at a time, unless it's told how many to fetch at once (<bold>-N</>).\n\n"
+		"With this option, the items with such formats get <bold>-N</> automatically. The number of\nconnections set here "
+		"is shared by all the running items: each item that starts gets\nan equal share, or twice that if the running items "
+		"are slow (under 1 MB/s each),\nas far as what's left of the total allows.\n\n"
+		"If the custom arguments contain <bold>-N</> or <bold>--concurrent-fragments</>, those are used\ninstead.");
+	cb_shards.tooltip("A playlist is normally downloaded by a single yt-dlp process, one video after another.\n"
+		"With this option, when a playlist item is started and there are free download slots,\nthe selected videos are "
+		"split between several yt-dlp processes, one for each free slot\n(at least 10 videos per process). Each process "
+		"takes a slot, and gives it back when\nits part of the playlist is done.\n\n"
+		"The files are named the same way as when the playlist is downloaded by one process.");
+	cb_lowprio.tooltip("Starts yt-dlp with \"below normal\" priority, which the ffmpeg processes it runs\n"
+		"for post-processing inherit. Merging and converting then yield the CPU to the\nother programs, so the system "
+		"stays responsive while several items are being\npost-processed.");
 	cb_save_errors.tooltip("When the settings are saved, any incomplete queue items are also saved,\nexcept for those with the "
 		"\"error\" status. This option lets you also save the\nitems with the \"error\" status, which can be useful when a "
 		"download fails\ndue to connection issues, but can be resumed later.");
@@ -565,8 +708,11 @@ void GUI::fm_settings()
 
 	cb_lengthyproc.tooltip("When yt-dlp finishes downloading all the files associated with a queue item,\n"
 		"it performs actions on the files referred to as \"post-processing\". These actions\ncan be a number of things, depending "
-		"on the context, and on the options used.\n\nSometimes this post-processing phase can take a long time, so this setting\n"
-		"makes the program automatically start the next queue item when processing\ntakes longer that 3 seconds.");
+		"on the context, and on the options used.\n\nPost-processing is done by ffmpeg, and it can take a long time. With this setting,\n"
+		"a queue item that's being post-processed doesn't count towards the limit of\nconcurrent downloads, so the next queue item "
+		"is started right away.\n\nThe number of items that can be post-processed at the same time follows the\nnumber of CPU "
+		"cores (one for every two cores). When that many items are being\npost-processed, the next one keeps its download slot "
+		"until one of them is done.");
 
 	cb_zeropadding.tooltip("This option pads the index numbers in the filenames of playlist videos\nwith zeroes, when the playlist "
 		"contains more than 9 videos. This allows\nthe filenames to be sorted properly when viewed in a file manager (for\nexample, "
@@ -733,6 +879,28 @@ void GUI::fm_settings()
 		conf.update_self_only = cb_selfonly.checked();
 		conf.cb_premium = cb_premium.checked();
 		conf.cb_save_errors = cb_save_errors.checked();
+		conf.cb_load_info_json = cb_load_info_json.checked();
+		conf.cb_playlist_sync = cb_playlist_sync.checked();
+		conf.cb_lowprio = cb_lowprio.checked();
+		conf.cb_auto_fragments = cb_fragments.checked();
+		conf.cb_playlist_shards = cb_shards.checked();
+		conf.prefetch_depth = sb_prefetch.to_int();
+		conf.fragment_budget = sb_fragments.to_int();
+		conf.cb_ratelim_global = cb_ratelim_global.checked();
+		conf.adaptive_min = sb_adapt_min.to_int();
+		conf.adaptive_max = std::max(conf.adaptive_min, static_cast<unsigned>(sb_adapt_max.to_int()));
+		if(conf.cb_adaptive_concurrency != cb_adaptive.checked())
+			adaptive.slots = 0;
+		else if(adaptive.slots)
+			adaptive.slots = std::clamp(adaptive.slots, conf.adaptive_min, conf.adaptive_max);
+		conf.cb_adaptive_concurrency = cb_adaptive.checked();
+		conf.cb_domain_limits = cb_domain_limits.checked();
+		conf.domain_max = sb_domain_max.to_int();
+		conf.domain_spacing = sb_domain_spacing.to_int() * 1000;
+		conf.ratelim_global = tb_ratelim_global.to_double();
+		conf.ratelim_global_unit = com_ratelim_global.option();
+		if(conf.cb_ratelim_global && conf.ratelim_global)
+			bwproxy.budget(static_cast<unsigned long long>(conf.ratelim_global * (conf.ratelim_global_unit ? 1024 * 1024 : 1024)));
 
 		conf.sblock_mark.clear();
 		for(auto ip : lbmark.at(0))
@@ -753,32 +921,19 @@ void GUI::fm_settings()
 				bottoms.propagate_args_options(curbot);
 				bottoms.propagate_misc_options(curbot);
 			}
-			std::string cap {"Download options"};
+			item_caption(bottoms.visible()); // the others get theirs when they're shown
 			for(auto &pbot : bottoms)
-			{
 				if(pbot.second->index)
-				{
-					pbot.second->gpopt.caption(conf.common_dl_options ? cap : cap + " for queue item #" + std::to_string(pbot.second->index));
 					pbot.second->show_btncopy(!conf.common_dl_options);
-					nana::api::refresh_window(pbot.second->gpopt);
-				}
-			}
 		}
 
 		updater_working = false;
 		conf.get_releases_at_startup = cb_startup.checked();
 		conf.cb_ffplay = cb_ffplay.checked();
 
-		if(thr.joinable())
-			thr.join();
-		if(thr_releases.joinable())
-			thr_releases.detach();
-		if(thr_releases_ffmpeg.joinable())
-			thr_releases_ffmpeg.detach();
-		if(thr_releases_ytdlp.joinable())
-			thr_releases_ytdlp.detach();
-		if(thr_versions.joinable())
-			thr_versions.detach();
+		// the update downloads write to the form's widgets; the release checks only to GUI members, so they can go on
+		update_task.cancel();
+		update_task.wait();
 	});
 
 	fm.theme_callback([&, this](bool dark)
@@ -1051,7 +1206,7 @@ void GUI::make_updater_page(themed_form &parent)
 	updater_t0.interval(std::chrono::milliseconds {100});
 	updater_t0.elapse([this]
 	{
-		if(!thr_releases.joinable())
+		if(!releases_task.running())
 		{
 			updater_display_version();
 			updater_t0.stop();
@@ -1061,7 +1216,7 @@ void GUI::make_updater_page(themed_form &parent)
 	updater_t1.interval(std::chrono::milliseconds {300});
 	updater_t1.elapse([this]
 	{
-		if(!thr_releases_ffmpeg.joinable())
+		if(!releases_ffmpeg_task.running())
 		{
 			updater_display_version_ffmpeg();
 			updater_t1.stop();
@@ -1071,7 +1226,7 @@ void GUI::make_updater_page(themed_form &parent)
 	updater_t2.interval(std::chrono::milliseconds {300});
 	updater_t2.elapse([this]
 	{
-		if(!thr_releases_ytdlp.joinable())
+		if(!releases_ytdlp_task.running())
 		{
 			if(!url_latest_ytdlp_relnotes.empty())
 			{
@@ -1100,8 +1255,6 @@ void GUI::make_updater_page(themed_form &parent)
 	{
 		if(arg.widget->checked())
 		{
-			if(thr_releases_ytdlp.joinable())
-				thr_releases_ytdlp.detach();
 			cb_chan_stable.enabled(false);
 			cb_chan_nightly.enabled(false);
 			l_ytdlp_text.caption("checking...");
@@ -1206,9 +1359,11 @@ void GUI::updater_update_self(themed_form &parent)
 		btnytdlp_state = btn_update_ytdlp.enabled();
 		btn_update_ffmpeg.enabled(false);
 		btn_update_ytdlp.enabled(false);
-		thr = std::thread {[&parent, this]
+		updater_working = true;
+		update_task = tasks.submit(executor::pool::io, [&parent, this](std::stop_token stop)
 		{
-			updater_working = true;
+			// cancel() is tied to the flag that dl_inet_res checks
+			std::stop_callback on_stop {stop, [this] { updater_working = false; }};
 			if(!X64 && releases[0]["assets"].size() < 2)
 			{
 				nana::msgbox mbox {*this, "ytdlp-interface update error"};
@@ -1216,11 +1371,12 @@ void GUI::updater_update_self(themed_form &parent)
 				(mbox << "The latest release on GitHub doesn't seem to contain a 32-bit build!")();
 				btn_update.caption("Update");
 				btn_update.cancel_mode(false);
-				thr.detach();
 				return;
 			}
 			unsigned arc_size {releases[0]["assets"][X64 ? 0 : 1]["size"]}, progval {0};
 			std::string arc_url {releases[0]["assets"][X64 ? 0 : 1]["browser_download_url"]};
+			const auto arc_sha256 {asset_sha256(releases[0]["assets"], arc_url.substr(arc_url.rfind('/') + 1), "", stop)};
+			std::string dl_sha256;
 			prog_updater.amount(arc_size);
 			prog_updater.value(0);
 			auto cb_progress = [&, this](unsigned prog_chunk)
@@ -1231,7 +1387,14 @@ void GUI::updater_update_self(themed_form &parent)
 				prog_updater.caption("downloading archive: " + pct + " of " + total);
 				prog_updater.value(progval);
 			};
-			auto dl_error {util::dl_inet_res(arc_url, arc_path, &updater_working, cb_progress)};
+			auto dl_error {util::dl_inet_res(arc_url, arc_path, &updater_working, cb_progress, &dl_sha256)};
+			if(dl_error.empty() && updater_working && !arc_sha256.empty() && dl_sha256 != arc_sha256)
+			{
+				dl_error = "SHA-256 mismatch, the downloaded archive is corrupt (expected " + arc_sha256.substr(0, 12) +
+					"..., got " + (dl_sha256.empty() ? "nothing" : dl_sha256.substr(0, 12) + "...") + ")";
+				std::error_code ec;
+				fs::remove(arc_path, ec);
+			}
 
 			if(updater_working)
 			{
@@ -1253,8 +1416,12 @@ void GUI::updater_update_self(themed_form &parent)
 							params += L" self_only";
 						ShellExecuteW(NULL, L"runas", tempself.wstring().data(), params.data(), NULL, SW_SHOW);
 						updater_working = false;
-						parent.close();
-						close();
+						// closing the main form shuts down the executor, which waits for this task to end
+						ui_update(ui_queue::kind::other, L"", [this, fm = parent.handle()]
+						{
+							nana::API::close_window(fm); // does nothing if the settings have been closed since
+							close();
+						});
 					}
 					catch(fs::filesystem_error const &e) {
 						nana::msgbox mbox {parent, "File copy error"};
@@ -1268,9 +1435,8 @@ void GUI::updater_update_self(themed_form &parent)
 				btn_update_ffmpeg.enabled(btnffmpeg_state);
 				btn_update_ytdlp.enabled(btnytdlp_state);
 				updater_working = false;
-				thr.detach();
 			}
-		}};
+		});
 	}
 	else
 	{
@@ -1280,8 +1446,7 @@ void GUI::updater_update_self(themed_form &parent)
 		prog_updater.value(0);
 		btn_update_ffmpeg.enabled(btnffmpeg_state);
 		btn_update_ytdlp.enabled(btnytdlp_state);
-		updater_working = false;
-		thr.detach();
+		update_task.cancel();
 	}
 };
 
@@ -1305,9 +1470,10 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 		btnupdate_state = btn_update.enabled();
 		btn->caption("Cancel");
 		btn->cancel_mode(true);
-		thr = std::thread {[ytdlp, target, this]
+		updater_working = true;
+		update_task = tasks.submit(executor::pool::io, [ytdlp, target, this](std::stop_token stop)
 		{
-			updater_working = true;
+			std::stop_callback on_stop {stop, [this] { updater_working = false; }};
 			unsigned progval {0};
 			const auto arc_size {ytdlp ? size_latest_ytdlp : size_latest_ffmpeg};
 			const auto arc_url {ytdlp ? url_latest_ytdlp : url_latest_ffmpeg};
@@ -1322,17 +1488,80 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 				prog_updater_misc.caption((ytdlp ? fname : arc_path.filename().string()) + "  :  " + pct + " of " + total);
 				prog_updater_misc.value(progval);
 			};
-			std::string download_result;
+			const auto arc_sha256 {ytdlp ? sha256_latest_ytdlp : sha256_latest_ffmpeg};
+			// yt-dlp is downloaded next to the target and only moved into place after its hash checks out
+			const auto dl_path {ytdlp ? target / (fname + ".part") : arc_path};
+			std::string download_result, dl_sha256;
 			btn_update.enabled(false);
 			if(ytdlp)
-			{
 				btn_update_ffmpeg.enabled(false);
-				download_result = util::dl_inet_res(arc_url, target / fname, &updater_working, cb_progress);
+			else btn_update_ytdlp.enabled(false);
+
+			// FFmpeg members are pulled out of the zip while it downloads, into a temp folder that's only
+			// copied to the target after the archive's hash has been verified
+			std::unique_ptr<util::unzip_stream> unzipper;
+			fs::path tempdir;
+			if(!ytdlp)
+			{
+				std::error_code ec;
+				tempdir = fs::temp_directory_path() / std::tmpnam(nullptr);
+				fs::create_directory(tempdir, ec);
+				if(fs::exists(tempdir))
+				{
+					std::vector<std::string> members {"bin/ffmpeg.exe", "bin/ffprobe.exe"};
+					if(cb_ffplay.checked())
+						members.push_back("bin/ffplay.exe");
+					unzipper = std::make_unique<util::unzip_stream>(tempdir, members);
+				}
 			}
-			else
+			auto cb_data = [&](const std::string &chunk) { if(unzipper) unzipper->feed(chunk); };
+
+			using namespace std::chrono;
+			auto t0 {steady_clock::now()};
+			download_result = util::dl_inet_res(arc_url, dl_path, &updater_working, cb_progress, &dl_sha256, cb_data);
+			const double secs_net {duration_cast<milliseconds>(steady_clock::now() - t0).count() / 1000.0};
+			double secs_decompress {0}, secs_write {0};
+			bool streamed {unzipper && unzipper->finish()};
+			if(unzipper)
+			{
+				secs_decompress = unzipper->secs_decompress();
+				secs_write = unzipper->secs_write();
+			}
+			auto timings = [&]
+			{
+				std::string str {"  (network " + util::format_float(secs_net, 1) + " s"};
+				if(!ytdlp)
+				{
+					str += ", decompress " + util::format_float(secs_decompress, 1) + " s, write " +
+						util::format_float(secs_write, 1) + " s";
+					if(streamed) str += ", extracted during download";
+				}
+				return str + ')';
+			};
+			if(download_result.empty() && updater_working)
+			{
+				std::error_code ec;
+				if(!arc_sha256.empty() && dl_sha256 != arc_sha256)
+				{
+					download_result = "SHA-256 mismatch, the download is corrupt (expected " + arc_sha256.substr(0, 12) +
+						"..., got " + (dl_sha256.empty() ? "nothing" : dl_sha256.substr(0, 12) + "...") + ")";
+					fs::remove(dl_path, ec);
+				}
+				else if(ytdlp)
+				{
+					fs::rename(dl_path, target / fname, ec);
+					if(ec)
+					{
+						download_result = "Failed to replace " + fname + ": " + ec.message();
+						fs::remove(dl_path, ec);
+					}
+				}
+			}
+
+			if(!tempdir.empty() && (!download_result.empty() || !updater_working))
 			{
-				btn_update_ytdlp.enabled(false);
-				download_result = util::dl_inet_res(arc_url, arc_path, &updater_working, cb_progress);
+				std::error_code ec;
+				fs::remove_all(tempdir, ec);
 			}
 
 			if(updater_working)
@@ -1341,17 +1570,24 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 				{
 					if(!ytdlp) // FFmpeg downloaded
 					{
-						fs::path tempdir {fs::temp_directory_path() / std::tmpnam(nullptr)};
 						std::error_code ec;
-						fs::create_directory(tempdir, ec);
-						if(fs::exists(tempdir))
+						if(!tempdir.empty() && fs::exists(tempdir))
 						{
-							prog_updater_misc.caption("Extracting files to temporary folder...");
-							auto error {util::extract_7z(arc_path, tempdir, cb_ffplay.checked() + 1)};
+							std::string error;
+							if(!streamed)
+							{
+								prog_updater_misc.caption("Extracting files to temporary folder...");
+								fs::remove_all(tempdir, ec); // whatever the stream managed to extract before giving up
+								fs::create_directory(tempdir, ec);
+								auto t0 {steady_clock::now()};
+								error = util::extract_7z(arc_path, tempdir, cb_ffplay.checked() + 1);
+								secs_decompress += duration_cast<milliseconds>(steady_clock::now() - t0).count() / 1000.0;
+							}
 							if(error.empty())
 							{
 								prog_updater_misc.caption(std::string {"Copying files to "} + (target == appdir ?
 																					   "program folder..." : "yt-dlp folder..."));
+								auto t0 {steady_clock::now()};
 								for(auto const &dir_entry : fs::recursive_directory_iterator {tempdir})
 								{
 									if(dir_entry.is_regular_file())
@@ -1367,12 +1603,13 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 										}
 									}
 								}
+								secs_write += duration_cast<milliseconds>(steady_clock::now() - t0).count() / 1000.0;
 								if(!ec)
 								{
 									ffmpeg_loc = target / "ffmpeg.exe";
 									ver_ffmpeg = ver_ffmpeg_latest;
 									btnffmpeg_state = false;
-									prog_updater_misc.caption("FFmpeg update complete");
+									prog_updater_misc.caption("FFmpeg update complete" + timings());
 									l_ffmpeg_text.caption(ver_ffmpeg_latest.string() + "  (current)");
 									btn_update_ffmpeg.tooltip("");
 								}
@@ -1389,7 +1626,7 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 						conf.ytdlp_path = target / fname;
 						ver_ytdlp = ver_ytdlp_latest;
 						btnytdlp_state = false;
-						prog_updater_misc.caption("yt-dlp update complete");
+						prog_updater_misc.caption("yt-dlp update complete" + timings());
 						l_ytdlp_text.caption(ver_ytdlp_latest.string() + "  (current)  [click to see changelog]");
 						btn_update_ytdlp.tooltip("");
 					}
@@ -1403,20 +1640,18 @@ void GUI::updater_update_misc(bool ytdlp, fs::path target)
 				btn_update_ytdlp.enabled(btnytdlp_state);
 				btn_update.enabled(btnupdate_state);
 				updater_working = false;
-				thr.detach();
 			}
-		}};
+		});
 	}
 	else
 	{
-		updater_working = false;
+		update_task.cancel();
 		btn_update_ytdlp.caption(btntext_ytdlp);
 		btn_update_ffmpeg.caption(btntext_ffmpeg);
 		btn->cancel_mode(false);
 		btn_update_ffmpeg.enabled(btnffmpeg_state);
 		btn_update_ytdlp.enabled(btnytdlp_state);
 		btn_update.enabled(btnupdate_state);
-		thr.detach();
 	}
 };
 
@@ -1435,7 +1670,7 @@ void GUI::updater_init_page()
 
 	if(conf.get_releases_at_startup)
 	{
-		if(thr_releases.joinable())
+		if(releases_task.running())
 			updater_t0.start();
 		else updater_display_version();
 	}
@@ -1462,7 +1697,7 @@ void GUI::updater_init_page()
 			updater_t2.start();
 		}
 	}
-	else if(!thr_releases_ytdlp.joinable())
+	else if(!releases_ytdlp_task.running())
 	{
 		cb_chan_stable.enabled(false);
 		cb_chan_nightly.enabled(false);
@@ -7,6 +7,8 @@
 #include <nana/gui/filebox.hpp>
 
 GUI::settings_t GUI::conf;
+media_library GUI::library;
+playlist_cache GUI::playlists;
 
 
 GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::_1)}
@@ -34,43 +36,7 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 	{
 		auto pcds {reinterpret_cast<PCOPYDATASTRUCT>(lparam)};
 		std::wstring url {reinterpret_cast<LPCWSTR>(pcds->lpData), pcds->cbData / 2};
-		auto item {lbq.item_from_value(url)};
-		if(!item.empty())
-		{
-			switch(pcds->dwData)
-			{
-			case YTDLP_POSTPROCESS:
-				if(bottoms.at(url).started())
-					item.text(3, "processing");
-				else return true;
-				if(conf.cb_lengthyproc && bottoms.contains(url))
-				{
-					auto &bottom {bottoms.at(url)};
-					if(!bottom.received_procmsg)
-					{
-						bottom.received_procmsg = true;
-						bottom.timer_proc.interval(conf.max_proc_dur);
-						bottom.timer_proc.elapse([&, url, this]
-						{
-							if(bottoms.contains(url))
-							{
-								bottom.timer_proc.stop();
-								auto next_url {next_startable_url(url)};
-								if(!next_url.empty())
-									on_btn_dl(next_url);
-							}
-						});
-						bottom.timer_proc.start();
-					}
-				}
-				break;
-
-			case YTDLP_DOWNLOAD:
-				item.text(3, "downloading");
-				break;
-			}
-		}
-		else if(pcds->dwData == ADD_URL)
+		if(pcds->dwData == ADD_URL && !queue_items.find(url))
 			add_url(url);
 		return true;
 	});
@@ -81,7 +47,7 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 		{
 			restore();
 			bring_top(true);
-			center(1000, 703 - bottoms.current().expcol.collapsed() * 240);
+			center(1000, 703 - bottoms.current().view->expcol.collapsed() * 240);
 		}
 		return true;
 	});
@@ -111,7 +77,7 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 		{
 			if(GetAsyncKeyState(VK_CONTROL) & 0xff00)
 			{
-				if(api::focus_window() != bottoms.current().com_args)
+				if(api::focus_window() != bottoms.current().view->com_args)
 				{
 					l_url.events().mouse_up.emit({}, l_url);
 					if(!queue_panel.visible())
@@ -124,7 +90,7 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 			if(GetAsyncKeyState(VK_CONTROL) & 0xff00)
 			{
 				if(is_zoomed(true)) restore();
-				center(1000, 703 - bottoms.current().expcol.collapsed() * 240);
+				center(1000, 703 - bottoms.current().view->expcol.collapsed() * 240);
 			}
 		}
 		else if(wparam == VK_DELETE)
@@ -138,7 +104,7 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 					{
 						auto fwnd {api::focus_window()};
 						auto &bottom {bottoms.current()};
-						if(fwnd != bottom.com_args && fwnd != bottom.tbrate)
+						if(fwnd != bottom.view->com_args && fwnd != bottom.view->tbrate)
 						{
 							outbox.clear(bottom.url);
 							remove_queue_item(bottom.url);
@@ -219,10 +185,6 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 	if(langid == 2052 || langid == 3076 || langid == 5124 || langid == 4100 || langid == 1028)
 		cnlang = true;
 
-	SYSTEM_INFO sysinfo;
-	GetSystemInfo(&sysinfo);
-	number_of_processors = sysinfo.dwNumberOfProcessors;
-
 	std::wstring modpath(4096, '\0');
 	modpath.resize(GetModuleFileNameW(0, &modpath.front(), modpath.size()));
 	self_path = modpath;
@@ -261,51 +223,67 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 	else apply_theme(dark_theme());
 
 	get_versions();
+
+	adaptive.timer.interval(std::chrono::seconds {1});
+	adaptive.timer.elapse([this]
+	{
+		adaptive_concurrency_tick();
+		update_queue_totals();
+		prefetch_tick();
+	});
+	adaptive.timer.start();
+
+	domain_timer.elapse([this]
+	{
+		domain_timer.stop();
+		auto next_url {next_startable_url(L"")};
+		if(!next_url.empty())
+			on_btn_dl(next_url);
+	});
+
+	ui_timer.interval(std::chrono::milliseconds {25});
+	ui_timer.elapse([this] { drain_ui(); });
+	ui_timer.start();
 	
 	events().unload([&]
 	{
+		adaptive.timer.stop();
+		domain_timer.stop();
+		ui_timer.stop();
+		stop_prefetch(L"");
 		RevokeDragDrop(hwnd);
 		conf.zoomed = is_zoomed(true);
 		if(conf.zoomed || is_zoomed(false)) restore();
 		conf.winrect = nana::rectangle {pos(), size()};
+		// the menu's job starts and stops queue items, so it has to end before they're stopped; the other jobs are
+		// only asked to stop here, and tasks.shutdown() below waits for them
 		menu_working = false;
-		if(thr_menu.joinable())
-			thr_menu.join();
-		if(thr.joinable())
-			thr.join();
-		if(thr_releases.joinable())
-			thr_releases.detach();
-		if(thr_releases_ffmpeg.joinable())
-			thr_releases_ffmpeg.detach();
-		if(thr_releases_ytdlp.joinable())
-			thr_releases_ytdlp.detach();
-		if(thr_versions.joinable())
-			thr_versions.detach();
+		menu_task.cancel();
+		menu_task.wait();
+		for(auto task : {&update_task, &releases_task, &releases_ffmpeg_task, &releases_ytdlp_task, &versions_ffmpeg_task,
+			&versions_ytdlp_task, &thumb_task})
+			task->cancel();
 		for(auto &bottom : bottoms)
 		{
 			auto &bot {*bottom.second};
-			if(bot.info_thread.joinable())
-			{
-				bot.working_info = false;
-				bot.info_thread.join();
-			}
+			bot.stop_info();
 			if(bot.dl_thread.joinable())
 			{
 				bot.working = false;
 				bot.dl_thread.join();
 			}
 		}
+		tasks.shutdown();
 		if(i_taskbar)
 			i_taskbar.Release();
 
-		conf.argset = bottoms.current().com_args.caption();
+		conf.argset = bottoms.current().opts.argset;
 
 		conf.unfinished_queue_items.clear();
-		for(auto item : lbq.at(0))
+		for(auto &item : queue_items)
 		{
-			auto text {item.text(3)};
-			if(text != "done" && (text != "error" || text == "error" && conf.cb_save_errors))
-				conf.unfinished_queue_items.push_back(to_utf8(item.value<lbqval_t>().url));
+			if(item->state != queue_model::status::done && (item->state != queue_model::status::error || conf.cb_save_errors))
+				conf.unfinished_queue_items.push_back(to_utf8(item->url));
 		}
 	});
 
@@ -314,14 +292,14 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 	if(!conf.url_passed_as_arg.empty())
 		add_url(conf.url_passed_as_arg);
 
-	if(conf.cb_queue_autostart && lbq.at(0).size())
-		on_btn_dl(lbq.at(0).at(0).value<lbqval_t>());
+	if(conf.cb_queue_autostart && !queue_items.empty())
+		on_btn_dl(queue_items.at(0).url);
 
 	center(MINW, MINH);
 	show_queue(false);
 	if(conf.gpopt_hidden)
 	{
-		auto &expcol {bottoms.current().expcol};
+		auto &expcol {bottoms.current().view->expcol};
 		expcol.events().click.emit({}, expcol);
 		if(conf.winrect.empty())
 			center();
@@ -372,52 +350,49 @@ GUI::GUI() : themed_form {std::bind(&GUI::apply_theme, this, std::placeholders::
 bool GUI::process_queue_item(std::wstring url)
 {
 	using widgets::theme;
+	trace::span span {"process_queue_item", url};
 	auto &bottom {bottoms.at(url)};
 	auto &tbpipe {outbox};
 	auto &tbpipe_overlay {overlay};
-	auto &com_args {bottom.com_args};
-	auto &com_rate {bottom.com_rate};
-	auto &tbrate {bottom.tbrate};
-	auto &btn_ytfmtlist {bottom.btn_ytfmtlist};
-	auto &cbmp3 {bottom.cbmp3};
-	auto &cbsplit {bottom.cbsplit};
-	auto &cbkeyframes {bottom.cbkeyframes};
-	auto &btndl {bottom.btndl};
-	auto &prog {bottom.prog};
+	auto &opts {bottom.opts};
 	auto &working {bottom.working};
 	auto &graceful_exit {bottom.graceful_exit};
-	const auto argset {com_args.caption_wstring()};
+	const auto argset {nana::to_wstring(opts.argset)};
 
 	if(!bottom.started())
 	{
-		bottom.btndl.caption("Stop download");
-		bottom.btndl.cancel_mode(true);
+		trace::complete("queued", url, bottom.queued_at);
+		stop_prefetch(url);
+		bottom.handoff_at = std::exchange(prefetch.slot_freed, {});
+		bottom.handoff_prefetched = false;
+		// the item's previous download thread has ended, or is about to: started() is the last thing it sets
+		if(bottom.dl_thread.joinable())
+			bottom.dl_thread.join();
+		domain_last_start[bottom.domain_key()] = std::chrono::steady_clock::now();
+		bottom.started(true);
+		// claimed right away (the download thread sets the status again), so that an item that's being started isn't
+		// picked as the next startable one before its thread gets going
+		queue_status(url, queue_model::status::started);
 		if(tbpipe.current() == url)
 		{
 			tbpipe.clear();
-			if(tbpipe_overlay.visible() && bottom.btnq.caption().find("queue") != -1)
+			if(tbpipe_overlay.visible() && !queue_panel.visible())
 			{
 				tbpipe.show(url);
 			}
 		}
 		else tbpipe.clear(url);
-		if(bottom.cbargs.checked())
+		if(opts.cbargs)
 		{
-			const auto args {bottom.com_args.caption()};
-			auto idx {com_args.caption_index()};
-			if(idx == -1)
+			const auto args {opts.argset};
+			if(std::find(conf.argsets.begin(), conf.argsets.end(), args) == conf.argsets.end())
 			{
-				const auto size {com_args.the_number_of_options()};
-				com_args.push_back(args);
-				com_args.option(size);
-				if(size >= 10)
-				{
-					com_args.erase(0);
+				if(conf.argsets.size() >= 10)
 					conf.argsets.erase(conf.argsets.begin());
-				}
 				conf.argsets.push_back(args);
+				for(auto &pbot : bottoms)
+					pbot.second->reload_argsets();
 			}
-			com_args.option(idx);
 			if(conf.common_dl_options)
 				bottoms.propagate_args_options(bottom);
 		}
@@ -443,32 +418,14 @@ bool GUI::process_queue_item(std::wstring url)
 					}
 					else
 					{
-						std::string fmtid_premium;
-						const auto &formats {bottom.vidinfo["formats"]};
-						for(auto &el : formats)
-						{
-							if(el.contains("format_note") && el["format_note"] != nullptr && el["format_note"] == "Premium")
-							{
-								fmtid_premium = el["format_id"];
-								break;
-							}
-						}
-						if(!fmtid_premium.empty())
+						const auto &formats {bottom.formats};
+						if(formats.premium != -1)
 						{
+							const auto &fmtid_premium {formats.formats[formats.premium].id};
 							int maxres {1080};
 							if(conf.pref_res < 4)
-							{
-								for(auto &el : formats)
-								{
-									if(el.contains("height") && el["height"] != nullptr)
-									{
-										int height {el["height"]};
-										if(height > maxres)
-											maxres = height;
-									}
-								}
-							}
-							if(maxres == 1080 && !fmtid_premium.empty())
+								maxres = std::max(maxres, formats.max_height);
+							if(maxres == 1080)
 								cmd += L" -f " + nana::to_wstring(fmtid_premium) + L"+ba";
 						}
 					}
@@ -527,17 +484,46 @@ bool GUI::process_queue_item(std::wstring url)
 		if(!ffmpeg_loc.empty() && ffmpeg_loc.parent_path() != self_path.parent_path())
 			if(argset.find(L"--ffmpeg-location") == -1)
 				cmd += L"--ffmpeg-location \"" + ffmpeg_loc.wstring() + L"\" ";
-		if(tbrate.to_double() && argset.find(L"-r ") == -1)
-			cmd += L"-r " + tbrate.caption_wstring() + (com_rate.option() ? L"M " : L"K ");
-		if(cbmp3.checked() && argset.find(L"--audio-format") == -1)
+		bool bwshared {false};
+		if(conf.cb_ratelim_global && conf.ratelim_global && argset.find(L"-r ") == -1)
+		{
+			const auto budget {static_cast<unsigned long long>(conf.ratelim_global * (conf.ratelim_global_unit ? 1024 * 1024 : 1024))};
+			std::wstring proxy_url;
+			if((!conf.cb_proxy || conf.proxy.empty()) && argset.find(L"--proxy ") == -1)
+			{
+				bwproxy.budget(budget);
+				proxy_url = bwproxy.proxy_url(url);
+				if(proxy_url.empty())
+					tbpipe.append(url, "[GUI] failed to start the local bandwidth limiting proxy: " + bwproxy.error() + "\n");
+			}
+			if(!proxy_url.empty())
+			{
+				cmd += L"--proxy " + proxy_url + L' ';
+				bwshared = true;
+			}
+			else // traffic can't go through the local proxy, so each item gets a fixed slice of the budget instead
+				cmd += L"-r " + std::to_wstring(std::max(1ull, budget / 1024 / conf.max_concurrent_downloads)) + L"K ";
+		}
+		else if(std::atof(opts.ratelim.data()) && argset.find(L"-r ") == -1)
+			cmd += L"-r " + nana::to_wstring(opts.ratelim) + (opts.ratelim_unit ? L"M " : L"K ");
+		if(opts.cbmp3 && argset.find(L"--audio-format") == -1)
 		{
 			cmd += L"-x --audio-format mp3 ";
 			if(argset.find(L"--audio-quality") == -1) 
 				L"--audio-quality 0 ";
 		}
-		if(cbsplit.checked() && argset.find(L"--split-chapters") == -1)
+		bottom.fragments = 0;
+		if(conf.cb_auto_fragments && argset.find(L"-N ") == -1 && argset.find(L"--concurrent-fragments") == -1 && bottom.fragmented())
+		{
+			bottom.fragments = concurrent_fragments(url);
+			if(bottom.fragments > 1)
+				cmd += L"-N " + std::to_wstring(bottom.fragments) + L' ';
+		}
+		if(argset.find(L"--ppa ") == -1 && argset.find(L"--postprocessor-args") == -1)
+			cmd += L"--ppa \"ffmpeg:-threads " + std::to_wstring(ffmpeg_threads()) + L"\" ";
+		if(opts.cbsplit && argset.find(L"--split-chapters") == -1)
 			cmd += L"--split-chapters -o chapter:\"" + bottom.outpath.wstring() + L"\\%(title)s - %(section_number)s -%(section_title)s.%(ext)s\" ";
-		if(bottom.cbargs.checked() && !argset.empty())
+		if(opts.cbargs && !argset.empty())
 			cmd += argset + L" ";
 		for(auto &section : bottom.sections)
 		{
@@ -598,42 +584,36 @@ bool GUI::process_queue_item(std::wstring url)
 				}
 			}
 
-			if(!mark.empty() && bottom.com_args.caption().find("--sponsorblock-mark ") == -1)
+			if(!mark.empty() && opts.argset.find("--sponsorblock-mark ") == -1)
 				cmd += L"--sponsorblock-mark " + mark + L' ';
-			if(!remove.empty() && bottom.com_args.caption().find("--sponsorblock-remove ") == -1)
+			if(!remove.empty() && opts.argset.find("--sponsorblock-remove ") == -1)
 				cmd += L"--sponsorblock-remove " + remove + L' ';
 		}
 
-		if(conf.cb_proxy && !conf.proxy.empty() && bottom.com_args.caption().find("--proxy ") == -1)
+		if(conf.cb_proxy && !conf.proxy.empty() && opts.argset.find("--proxy ") == -1)
 			cmd += L"--proxy " + conf.proxy + L' ';
 
 		auto display_cmd {cmd};
 
 		cmd += L"--encoding UTF-8 ";
 
-		std::wstringstream ss;
-		ss << hwnd;
-		auto strhwnd {ss.str()};
-		strhwnd.erase(0, strhwnd.find_first_not_of('0'));
-		cmd += L"--exec \"after_video:\\\"" + self_path.wstring() + L"\\\" ytdlp_status " + std::to_wstring(YTDLP_POSTPROCESS)
-			+ L" " + strhwnd + L" \\\"" + url + L"\\\"\" ";
-		cmd += L"--exec \"before_dl:\\\"" + self_path.wstring() + L"\\\" ytdlp_status " + std::to_wstring(YTDLP_DOWNLOAD)
-			+ L" " + strhwnd + L" \\\"" + url + L"\\\"\" ";
-		fs::path tempfile;
+		// the stages of the item are printed to stdout as marked lines, which run_piped_process passes to cb_status
+		// (--print implies --quiet, which --no-quiet takes back); "post_process" is printed when a video's download is
+		// done and its post-processing (merging included) is about to start
+		const auto marker {nana::to_wstring(util::status_marker)};
+		cmd += L"--print \"before_dl:" + marker + L"before_dl\" --print \"post_process:" + marker + L"post_process\" ";
 		if(!bottom.is_ytplaylist && !bottom.is_ytchan && !bottom.is_bcplaylist)
-		{
-			tempfile = fs::temp_directory_path() / std::tmpnam(nullptr);
-			cmd += L"--print-to-file after_move:filepath " + tempfile.wstring();
-		}
+			cmd += L"--print \"after_move:" + marker + L"after_move %(filepath)s\" ";
+		cmd += L"--no-quiet ";
 		std::wstring cmd2;
-		if(!bottom.cbargs.checked() || argset.find(L"-P ") == -1)
+		if(!opts.cbargs || argset.find(L"-P ") == -1)
 		{
 			auto wstr {bottom.outpath.wstring()};
 			if(wstr.find(' ') == -1)
 				cmd2 += L" -P " + wstr;
 			else cmd2 += L" -P \"" + wstr + L"\"";
 		}
-		if((!bottom.cbargs.checked() || argset.find(L"-o ") == -1) && !conf.output_template.empty())
+		if((!opts.cbargs || argset.find(L"-o ") == -1) && !conf.output_template.empty())
 		{
 			std::wstring folder;
 			if(bottom.is_ytplaylist)
@@ -679,73 +659,150 @@ bool GUI::process_queue_item(std::wstring url)
 			}
 			else cmd2 += L" -o \"" + conf.output_template + L'\"';
 		}
+		/* a large selection can be split into shards, each downloaded by a yt-dlp process of its own; the shard commands
+		   are the item's command with the "-I" of their part of the selection in place of the item's own */
+		std::vector<std::wstring> shard_cmds;
+		auto items_pos {cmd.size() + cmd2.size()}, items_len {cmd2.size()};
 		if((bottom.is_ytplaylist || bottom.is_bcplaylist) && !bottom.playsel_string.empty())
 			cmd2 += L" -I " + bottom.playsel_string + L" --compat-options no-youtube-unavailable-videos";
-		cmd2 += L" \"" + url + L'\"';
+		items_len = cmd2.size() - items_len;
+		if(bottom.is_ytplaylist || bottom.is_bcplaylist)
+			for(const auto &items : playlist_shards(bottom))
+				shard_cmds.push_back(L" -I " + items + L" --compat-options no-youtube-unavailable-videos");
+		/* reusing the media info that add_url already extracted saves yt-dlp from extracting it a second time; the URL is
+		   still used if the info is stale or the download is set up differently from how the info was extracted */
+		fs::path infojson;
+		std::string reuse_info;
+		const auto cmd_url {cmd + cmd2 + L" \"" + url + L'\"'};
+		if(conf.cb_load_info_json)
+		{
+			std::string reason;
+			if(info_json_usable(bottom, opts.cbargs ? argset : L"", reason))
+			{
+				infojson = fs::temp_directory_path() / std::tmpnam(nullptr);
+				infojson.replace_extension(".info.json");
+				if((std::ofstream {infojson, std::ios::binary} << bottom.vidinfo_full.unpack()).good())
+				{
+					cmd2 += L" --load-info-json \"" + infojson.wstring() + L'\"';
+					const auto age {std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now() - bottom.vidinfo_time)};
+					reuse_info = "[GUI] reusing the media info extracted " + std::to_string(age.count()) +
+						" seconds ago (--load-info-json), skipping the extraction";
+					if(bottom.vidinfo_secs > 0)
+						reuse_info += " (which took " + util::format_float(bottom.vidinfo_secs, 1) + " seconds)";
+					reuse_info += "\n\n";
+					if(bottom.prefetched)
+					{
+						bottom.handoff_prefetched = true;
+						reuse_info += "[GUI] the media info was refreshed ahead of the item's turn\n\n";
+					}
+				}
+				else
+				{
+					std::error_code ec;
+					fs::remove(infojson, ec);
+					infojson.clear();
+				}
+			}
+			else if(!reason.empty())
+				reuse_info = "[GUI] not reusing the extracted media info: " + reason + "\n\n";
+		}
+		if(infojson.empty())
+			cmd2 += L" \"" + url + L'\"';
 		display_cmd += cmd2;
 		cmd += cmd2;
+		std::wstring shard_info;
+		for(auto &shard : shard_cmds)
+		{
+			shard_info += (shard_info.empty() ? L"" : L" | ") + shard.substr(1, shard.find(L" --compat") - 1);
+			shard = cmd.substr(0, items_pos) + shard + cmd.substr(items_pos + items_len);
+		}
+		if(shard_cmds.size() > 1)
+			shard_info = L"[GUI] the selection is split between " + std::to_wstring(shard_cmds.size()) +
+				L" yt-dlp processes, which get these arguments in place of the item's own: " + shard_info + L"\n\n";
 		//display_cmd = cmd;
 
 		if(tbpipe.current() == url)
 			tbpipe.clear();
 
-		bottom.dl_thread = std::thread([&, this, tempfile, display_cmd, cmd, url]
+		bottom.dl_thread = std::thread([&, this, display_cmd, cmd, url, bwshared, infojson, cmd_url, reuse_info, shard_cmds, shard_info]
 		{
 			working = true;
-			auto ca {tbpipe.colored_area_access()};
-			bool ca_change {false};
-			if(outbox.current() == url)
-			{
-				ca->clear();
-				ca_change = true;
-			}
-			if(fs::exists(conf.ytdlp_path))
-				tbpipe.append(url, L"[GUI] executing command line: " + display_cmd + L"\n\n");
-			else tbpipe.append(url, L"ytdlp.exe not found: " + conf.ytdlp_path.wstring());
-			auto p {ca_change ? ca->get(0) : nullptr};
-			if(ca_change)
-				p->count = 1;
-			if(!fs::exists(conf.ytdlp_path))
+			trace::span span {"download thread", url};
+			trace::phases phases {url}; // the stages of the item, as yt-dlp reports them
+			phases.enter("yt-dlp startup");
+			const bool ytdlp_found {fs::exists(conf.ytdlp_path)};
+			ui_update(ui_queue::kind::other, url, [this, url, display_cmd, reuse_info, shard_info, ytdlp_found]
 			{
+				auto &tbpipe {outbox};
+				auto ca {tbpipe.colored_area_access()};
+				bool ca_change {false};
+				if(outbox.current() == url)
+				{
+					ca->clear();
+					ca_change = true;
+				}
+				if(ytdlp_found)
+				{
+					tbpipe.append(url, L"[GUI] executing command line: " + display_cmd + L"\n\n");
+					if(!reuse_info.empty())
+						tbpipe.append(url, reuse_info);
+					if(!shard_info.empty())
+						tbpipe.append(url, shard_info);
+				}
+				else tbpipe.append(url, L"ytdlp.exe not found: " + conf.ytdlp_path.wstring());
 				if(ca_change)
-					p->fgcolor = theme::is_dark() ? nana::color {"#f99"} : nana::color {"#832"};
+				{
+					auto p {ca->get(0)};
+					p->count = 1;
+					if(ytdlp_found)
+						p->fgcolor = theme::is_dark() ? theme::path_link_fg : nana::color {"#569"};
+					else p->fgcolor = theme::is_dark() ? nana::color {"#f99"} : nana::color {"#832"};
+				}
 				nana::API::refresh_window(tbpipe);
-				btndl.caption("Start download");
-				btndl.cancel_mode(false);
-				if(bottom.dl_thread.joinable())
-					bottom.dl_thread.detach();
+			});
+			if(!ytdlp_found)
+			{
+				bottom.started(false);
 				return;
 			}
-			if(ca_change)
-				p->fgcolor = theme::is_dark() ? theme::path_link_fg : nana::color {"#569"};
-			nana::API::refresh_window(tbpipe);
 			ULONGLONG prev_val {0};
 			bool playlist_progress {false};
 
+			// posted, not sent: the GUI thread can be waiting for this thread to end (stop, remove, close)
+			auto notify = [&, this](int stage) { ui_update(ui_queue::kind::other, url, [this, url, stage] { stage_changed(url, stage); }); };
+
 			auto cb_progress = [&, this, url](ULONGLONG completed, ULONGLONG total, std::string text, int playlist_completed, int playlist_total)
 			{
 				if(playlist_total && !playlist_progress)
 				{
 					playlist_progress = true;
-					prog.amount(playlist_total);
+					bottom.progress_amount(playlist_total);
 				}
 				while(text.find_last_of("\r\n") != -1)
 					text.pop_back();
-				auto item {lbq.item_from_value(url)};
+				const auto speed {util::parse_speed(text)};
+				if(speed >= 0)
+					bottom.dl_speed = speed;
+				if(total != -1 || speed >= 0)
+				{
+					// the size in a playlist's progress line is that of the current entry, which says nothing about the whole
+					const auto fsize {total != -1 && !playlist_progress ? util::parse_size(text) : -1};
+					queue_items.progress(url, fsize > 0 ? static_cast<unsigned long long>(fsize) : 0, completed, speed);
+				}
 				if(total != -1)
 				{
 					auto strpct {(std::stringstream {} << static_cast<double>(completed) / 10).str() + '%'};
 					if(playlist_progress)
 					{
 						auto strprog {"[" + std::to_string(playlist_completed + 1) + "/" + std::to_string(playlist_total) + "] "};
-						item.text(3, strprog + strpct);
-						if(i_taskbar && lbq.at(0).size() == 1)
+						queue_status(url, queue_model::status::downloading, strprog + strpct);
+						if(i_taskbar && queue_items.size() == 1)
 							i_taskbar->SetProgressValue(hwnd, playlist_completed, playlist_total);
 					}
 					else 
 					{
-						item.text(3, strpct);
-						if(i_taskbar && lbq.at(0).size() == 1)
+						queue_status(url, queue_model::status::downloading, strpct);
+						if(i_taskbar && queue_items.size() == 1)
 							i_taskbar->SetProgressValue(hwnd, completed, total);
 					}
 				}
@@ -753,7 +810,7 @@ bool GUI::process_queue_item(std::wstring url)
 				{
 					if(playlist_progress)
 						text = "[" + std::to_string(playlist_completed + 1) + " of " + std::to_string(playlist_total) + "]\t" + text;
-					prog.caption(text);
+					bottom.progress_caption(text);
 				}
 				else
 				{
@@ -761,11 +818,8 @@ bool GUI::process_queue_item(std::wstring url)
 					{
 						if(text == "[ExtractAudio]" || text.find("[Merger]") == 0 || text.find("[Fixup") == 0)
 						{
-							COPYDATASTRUCT cds;
-							cds.dwData = YTDLP_POSTPROCESS;
-							cds.cbData = url.size() * 2;
-							cds.lpData = const_cast<std::wstring&>(url).data();
-							SendMessageW(hwnd, WM_COPYDATA, NULL, reinterpret_cast<LPARAM>(&cds));
+							notify(YTDLP_POSTPROCESS);
+							phases.enter("post-processing");
 
 							if(text.find("[Merger]") == 0)
 							{
@@ -788,12 +842,12 @@ bool GUI::process_queue_item(std::wstring url)
 								text.erase(pos + 1);
 							if(playlist_progress)
 							{
-								prog.shadow_progress(1000, completed);
-								prog.value(playlist_completed + 1);
+								bottom.progress_shadow(completed);
+								bottom.progress_value(playlist_completed + 1);
 								auto strprog {"[" + std::to_string(playlist_completed + 1) + " of " + std::to_string(playlist_total) + "]\t"};
-								prog.caption(strprog + text);
+								bottom.progress_caption(strprog + text);
 							}
-							else prog.caption(text);
+							else bottom.progress_caption(text);
 						}
 					}
 					if(total == -1 && text.find("[download]") == 0)
@@ -811,6 +865,7 @@ bool GUI::process_queue_item(std::wstring url)
 							{
 								try { bottom.download_path = fs::u8path(text.substr(24)); }
 								catch(...) { bottom.download_path.clear(); }
+								queue_items.next_file(url);
 							}
 							else bottom.download_path.clear();
 						}
@@ -818,112 +873,192 @@ bool GUI::process_queue_item(std::wstring url)
 					}
 				}
 				if(playlist_progress)
-					prog.shadow_progress(1000, completed);
-				else if(completed <= 1000 && (completed > prog.value() || completed == 0 || prog.value() - completed > 50))
-					prog.value(completed);
+					bottom.progress_shadow(completed);
+				else if(completed <= 1000 && (completed > bottom.progress_value() || completed == 0 || bottom.progress_value() - completed > 50))
+					bottom.progress_value(completed);
 				prev_val = completed;
 			};
 
-			auto item {lbq.item_from_value(url)};
-			prog.value(0);
-			prog.caption("");
-			if(i_taskbar && lbq.at(0).size() == 1) 
+			bottom.progress_value(0);
+			bottom.progress_caption("");
+			if(i_taskbar && queue_items.size() == 1) 
 				i_taskbar->SetProgressState(hwnd, TBPF_NORMAL);
-			if(!item.empty())
-				item.text(3, "started");
+			queue_status(url, queue_model::status::started);
 			auto cb_append = [url, this](std::string text, bool keyword)
 			{
 				if(keyword)
-					outbox.set_keyword(text);
-				else outbox.append(url, text);
+					ui_update(ui_queue::kind::other, url, [this, text] { outbox.set_keyword(text); });
+				else
+				{
+					if(text.find("HTTP Error 403") != -1 || text.find("HTTP Error 429") != -1)
+						adaptive.errors++;
+					outbox.append(url, text);
+				}
+			};
+			auto cb_status = [&, this](const std::string &record)
+			{
+				if(record == "before_dl")
+				{
+					notify(YTDLP_DOWNLOAD);
+					phases.enter("downloading");
+				}
+				else if(record == "post_process")
+				{
+					notify(YTDLP_POSTPROCESS);
+					phases.enter("post-processing");
+				}
+				else if(record.starts_with("after_move "))
+				{
+					try { bottom.printed_path = fs::u8path(record.substr(11)); }
+					catch(...) { bottom.printed_path.clear(); }
+				}
 			};
 			bottom.printed_path.clear();
 			bottom.merger_path.clear();
 			bottom.download_path.clear();
 			auto outpath {bottom.outpath};
-			auto res {util::run_piped_process(cmd, &working, cb_append, cb_progress, &graceful_exit, tempfile.filename().string())};
-			bottom.received_procmsg = false;
-			if(!tempfile.empty() && fs::exists(tempfile))
+			std::string res;
+			if(shard_cmds.size() > 1)
 			{
-				if(std::ifstream is {tempfile, std::ios::binary | std::ios::ate})
-				{
-					auto size {is.tellg()};
-					std::string str (size, '\0');
-					is.seekg(0);
-					if(is.read(&str.front(), size))
+				// the callbacks of the shards are serialized, and the entries they've finished are added up, so that the
+				// item's row and progress bar show the selection as a whole
+				std::mutex mtx;
+				std::vector<int> shard_done(shard_cmds.size(), 0), shard_total(shard_cmds.size(), 0);
+				const auto selected {bottom.playlist_selected()};
+				bool failed {false};
+				bottom.shards = static_cast<unsigned>(shard_cmds.size());
+				std::vector<std::thread> shard_threads;
+				for(size_t n {0}; n < shard_cmds.size(); n++)
+					shard_threads.emplace_back([&, n]
 					{
-						while(str.find_last_of("\r\n") != -1)
-							str.pop_back();
-						bottom.printed_path = fs::u8path(str);
-					}
+						auto shard_append = [&](std::string text, bool keyword)
+						{
+							std::lock_guard lock {mtx};
+							cb_append(std::move(text), keyword);
+						};
+						auto shard_progress = [&, n](ULONGLONG completed, ULONGLONG total, std::string text, int playlist_completed, int playlist_total)
+						{
+							std::lock_guard lock {mtx};
+							if(playlist_total)
+							{
+								// playlist_completed is the number of the shard's entries before the current one, which
+								// counts as finished when its download is complete
+								shard_total[n] = playlist_total;
+								shard_done[n] = std::max(shard_done[n], playlist_completed + (completed == 1000));
+								playlist_completed = 0;
+								for(auto done : shard_done)
+									playlist_completed += done;
+								playlist_completed = std::min(playlist_completed, selected - 1); // shown as the current one + 1
+								playlist_total = selected;
+							}
+							cb_progress(completed, total, std::move(text), playlist_completed, playlist_total);
+						};
+						auto shard_status = [&](const std::string &record)
+						{
+							std::lock_guard lock {mtx};
+							cb_status(record);
+						};
+						auto shard_res {util::run_piped_process(shard_cmds[n], &working, shard_append, shard_progress, &graceful_exit,
+							shard_status, conf.cb_lowprio)};
+						std::lock_guard lock {mtx};
+						if(shard_res == "failed")
+							failed = true;
+						else shard_done[n] = shard_total[n];
+						if(--bottom.shards && working)
+						{
+							// the shard's download slot is free for the next item while the other shards go on; the GUI
+							// thread hands it over, so that shards that end together start one item each, and not the
+							// same one (which would stop it)
+							ui_update(ui_queue::kind::other, url, [this, url] { hand_off_slot(url); });
+						}
+					});
+				for(auto &thr : shard_threads)
+					thr.join();
+				bottom.shards = 0;
+				if(failed)
+					res = "failed";
+			}
+			else res = util::run_piped_process(cmd, &working, cb_append, cb_progress, &graceful_exit, cb_status, conf.cb_lowprio);
+			if(!infojson.empty())
+			{
+				// the format URLs can be revoked before their stated expiry time, so a failure gets one more try the regular way
+				if(res == "failed" && working && !graceful_exit)
+				{
+					tbpipe.append(url, "\n[GUI] the download from the reused media info failed, retrying with the URL\n\n");
+					res = util::run_piped_process(cmd_url, &working, cb_append, cb_progress, &graceful_exit, cb_status, conf.cb_lowprio);
 				}
 				std::error_code ec;
-				fs::remove(tempfile, ec);
+				fs::remove(infojson, ec);
 			}
-			else if(bottom.is_ytplaylist && bottom.playlist_info.contains("title") && bottom.playlist_info["title"] != nullptr)
+			bottom.dl_speed = 0;
+			bottom.fragments = 0;
+			if(res == "failed")
+				adaptive.errors++;
+			if(bwshared)
 			{
-				bottom.printed_path = bottom.outpath / bottom.playlist_info["title"].get<std::string>();
+				auto stats {bwproxy.release(url)};
+				if(stats.secs > 0)
+				{
+					tbpipe.append(url, "\n[GUI] global bandwidth limit: " + util::format_float(stats.bytes / 1048576.0) +
+						" MB transferred through the local proxy at an average of " + util::format_float(stats.bytes / stats.secs / 1048576.0) +
+						" MB/s (the limit of " + util::format_float(bwproxy.budget() / 1048576.0) + " MB/s is shared by all running items; "
+						"combined rate during the last second: " + util::format_float(bwproxy.total_rate() / 1048576.0) + " MB/s)\n");
+				}
 			}
-			else if(bottom.is_bcplaylist)
+			if(bottom.printed_path.empty())
 			{
-				// todo
+				if(bottom.is_ytplaylist && bottom.playlist_info.contains("title") && bottom.playlist_info["title"] != nullptr)
+				{
+					bottom.printed_path = bottom.outpath / bottom.playlist_info["title"].get<std::string>();
+				}
+				else if(bottom.is_bcplaylist)
+				{
+					// todo
+				}
 			}
 
 			if(working && bottom.index > 0)
 			{
-				if(bottom.timer_proc.started())
-					bottom.timer_proc.stop();
-				item = lbq.item_from_value(url);
-				if(res == "failed")
-					item.text(3, "error");
-				else item.text(3, "done");
+				queue_status(url, res == "failed" ? queue_model::status::error : queue_model::status::done);
+				if(res != "failed")
+					library_add(bottom);
 				taskbar_overall_progress();
-				if(i_taskbar && lbq.at(0).size() == 1)
+				if(i_taskbar && queue_items.size() == 1)
 					i_taskbar->SetProgressState(hwnd, TBPF_NOPROGRESS);
-				btndl.enabled(true);
+				bottom.enable_btndl(true);
 				tbpipe.append(url, "\n[GUI] " + conf.ytdlp_path.filename().string() + " process has exited\n");
-				if(tbpipe.current() == url)
+				ui_update(ui_queue::kind::other, url, [this, url]
 				{
-					ca = tbpipe.colored_area_access();
-					p = ca->get(tbpipe.text_line_count() - 2);
-					p->count = 1;
-					p->fgcolor = theme::is_dark() ? theme::path_link_fg : nana::color {"#569"};
-					nana::API::refresh_window(tbpipe);
-				}
-				btndl.caption("Start download");
-				btndl.cancel_mode(false);
-				auto next_url {next_startable_url(url)};
-				if(!next_url.empty())
-					on_btn_dl(next_url);
-				if(working && bottom.dl_thread.joinable())
-					bottom.dl_thread.detach();
+					if(outbox.current() == url)
+					{
+						auto ca {outbox.colored_area_access()};
+						auto p {ca->get(outbox.text_line_count() - 2)};
+						p->count = 1;
+						p->fgcolor = theme::is_dark() ? theme::path_link_fg : nana::color {"#569"};
+						nana::API::refresh_window(outbox);
+					}
+				});
+				bottom.started(false);
+				// the slot is handed over on the GUI thread, like a finished shard's (by then the item may be gone)
+				ui_update(ui_queue::kind::other, L"", [this, url] { hand_off_slot(url); });
 			}
 		});
 		return true; // started
 	}
 	else
 	{
-		btndl.enabled(false);
-		if(bottom.timer_proc.started())
-			bottom.timer_proc.stop();
+		bottom.enable_btndl(false);
 		if(bottom.dl_thread.joinable())
 		{
 			working = false;
 			bottom.dl_thread.join();
 		}
-		bottom.received_procmsg = false;
+		bottom.queued_at = trace::now();
 		const auto fname {conf.ytdlp_path.filename().string()};
 		if(graceful_exit)
 			tbpipe.append(url, "\n[GUI] " + fname + " process was ended gracefully via Ctrl+C signal\n");
 		else tbpipe.append(url, "\n[GUI] " + fname + " process was ended forcefully via WM_CLOSE message\n");
-		auto item {lbq.item_from_value(url)};
-		auto text {item.text(3)};
-		auto pos {text.find(']')};
-		if(pos != -1)
-			item.text(3, "stopped (" + text.substr(1, pos-1) + ")");
-		else if(text.find('%') != -1)
-			item.text(3, "stopped (" + text + ")");
-		else item.text(3, "stopped");
+		queue_status(url, queue_model::status::stopped);
 		if(tbpipe.current() == url)
 		{
 			auto ca {tbpipe.colored_area_access()};
@@ -934,9 +1069,8 @@ bool GUI::process_queue_item(std::wstring url)
 			else p->fgcolor = theme::is_dark() ? nana::color {"#f99"} : nana::color {"#832"};
 		}
 		nana::API::refresh_window(tbpipe);
-		btndl.enabled(true);
-		btndl.caption("Start download");
-		btndl.cancel_mode(false);
+		bottom.enable_btndl(true);
+		bottom.started(false);
 		if(conf.cb_autostart)
 		{
 			auto next_url {next_startable_url(url)};
@@ -952,69 +1086,48 @@ void GUI::add_url(std::wstring url, bool refresh)
 {
 	using namespace nana;
 
-	auto item {lbq.item_from_value(url)};
+	auto pqi {queue_items.find(url)};
 
-	if(item == lbq.at(0).end() || refresh)
+	if(!pqi || refresh)
 	{
-		auto stridx {std::to_string(lbq.at(0).size() + 1)};
 		if(refresh)
 		{
-			auto status_text {item.text(3)};
-			for(int n {1}; n < item.columns(); n++)
-				item.text(n, "...");
-			item.text(3, status_text);
-			stridx = item.text(0);
+			if(!pqi) return;
+			pqi->reset_info();
+			lbq_update(url);
 		}
 		else 
 		{
-			lbq.at(0).append({stridx, "...", "...", "queued", "...", "...", "...", "..."});
+			queue_items.append(url);
+			lbq.at(0).model().container<lbq_rows>().push_back(queue_items.find(url));
 			lbq.at(0).back().value(lbqval_t {url, nullptr});
 			adjust_lbq_headers();
 		}
 
 		auto &bottom {bottoms.add(url)};
+		bottom.queued_at = trace::now();
 		if(!refresh)
 		{
-			if(conf.common_dl_options)
-				bottom.gpopt.caption("Download options");
-			else bottom.gpopt.caption("Download options for queue item #" + stridx);
+			item_caption(url);
 			bottom.show_btncopy(!conf.common_dl_options);
-			if(lbq.at(0).size() == 1)
-				lbq.item_from_value(url).select(true);
+			if(queue_items.size() == 1)
+				lbq_item(url).select(true);
 			else if(!conf.common_dl_options)
 				bottom.show_btncopy(true);
+			if(library_lookup(bottom))
+				return;
 		}
+		bottom.from_library = false;
 
-		bottom.info_thread = std::thread([&, this, url, refresh]
+		bottom.working_info = true;
+		bottom.info_task = tasks.submit(executor::pool::io, [&, this, url, refresh](std::stop_token stop)
 		{
-			bottom.working_info = true;
-			static std::atomic_int active_threads {0};
-			while(active_threads >= number_of_processors)
-			{
-				Sleep(100);
-				if(!bottom.working_info)
-				{
-					if(bottom.info_thread.joinable())
-						bottom.info_thread.detach();
-					return;
-				}
-			}
-			active_threads++;
+			std::stop_callback on_stop {stop, [&] { bottom.working_info = false; }}; // kills the yt-dlp process, if any
+			if(!bottom.working_info)
+				return; // the item was removed (or the program closed) while the task was waiting in the queue
+			trace::span span {"info extraction", url};
 
-			auto favicon_url {lbq.favicon_url_from_value(url)};
-			if(!favicon_url.empty())
-			{
-				auto item {lbq.item_from_value(url)};
-				std::function<void(paint::image &)> cbfn = [favicon_url, url, this](paint::image &img)
-				{
-					auto item {lbq.item_from_value(url)};
-					if(item != lbq.at(0).end())
-					{
-						item.value<lbqval_t>().pimg = &img;
-					}
-				};
-				favicons[favicon_url].add(favicon_url, cbfn);
-			}
+			fetch_favicon(url);
 
 			std::wstring fmt_sort {' '}, strpref {L" -S \""};
 			if(conf.pref_res)
@@ -1047,23 +1160,28 @@ void GUI::add_url(std::wstring url, bool refresh)
 				fmt_sort = strpref + L"\" ";
 
 			std::string media_info, media_website {"---"}, media_title, format_id {"---"}, format_note {"---"}, ext {"---"}, filesize {"---"};
+			unsigned long long size_bytes {0};
+			bool size_approx {false};
 			auto json_error = [&](const nlohmann::detail::exception &e)
 			{
 				media_title = "Can't parse the JSON data produced by yt-dlp! See output for details.";
-				lbq.item_from_value(url).text(3, "error");
-				outbox.caption(e.what() + std::string {"\n\n"} + media_info, url);
-				if(outbox.current() == url)
-				{
-					auto ca {outbox.colored_area_access()};
-					ca->clear();
-					auto p {ca->get(0)};
-					p->fgcolor = ::widgets::theme::is_dark() ? ::widgets::theme::path_link_fg : color {"#569"};
-				}
-				if(!queue_panel.visible() && overlay.visible())
+				queue_status(url, queue_model::status::error);
+				ui_update(ui_queue::kind::other, url, [this, url, text = e.what() + std::string {"\n\n"} + media_info]
 				{
-					outbox.widget::show();
-					overlay.hide();
-				}
+					outbox.caption(text, url);
+					if(outbox.current() == url)
+					{
+						auto ca {outbox.colored_area_access()};
+						ca->clear();
+						auto p {ca->get(0)};
+						p->fgcolor = ::widgets::theme::is_dark() ? ::widgets::theme::path_link_fg : color {"#569"};
+					}
+					if(!queue_panel.visible() && overlay.visible())
+					{
+						outbox.widget::show();
+						overlay.hide();
+					}
+				});
 			};
 
 			if(bottom.is_ytlink && !bottom.is_ytchan || bottom.is_bcplaylist)
@@ -1075,50 +1193,61 @@ void GUI::add_url(std::wstring url, bool refresh)
 					if(conf.cb_proxy && !conf.proxy.empty())
 						cmd = L" --proxy " + conf.proxy + cmd;
 					bottom.cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
-					media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
-					bool incomplete_data_received {false};
-					if(media_info.starts_with("ERROR: Incomplete data received"))
-					{
-						auto pos {media_info.find('{')};
-						if(pos != -1)
-						{
-							media_info.erase(0, pos);
-							incomplete_data_received = true;
-						}
-					}
-					if(!media_info.empty() && media_info.front() == '{')
+					bottom.playlist_new = -1;
+					const bool synced {bottom.is_ytplaylist && sync_playlist(bottom, compat_options)};
+					if(!synced)
 					{
-						try { bottom.playlist_info = nlohmann::json::parse(media_info); }
-						catch(nlohmann::detail::exception e)
+						media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
+						bool incomplete_data_received {false};
+						if(media_info.starts_with("ERROR: Incomplete data received"))
 						{
-							bottom.playlist_info.clear();
-							if(lbq.item_from_value(url) != lbq.at(0).end())
-								json_error(e);
+							auto pos {media_info.find('{')};
+							if(pos != -1)
+							{
+								media_info.erase(0, pos);
+								incomplete_data_received = true;
+							}
 						}
-						if(!bottom.playlist_info.empty())
+						if(!media_info.empty() && media_info.front() == '{')
 						{
-							if(incomplete_data_received)
+							try { bottom.playlist_info = nlohmann::json::parse(media_info); }
+							catch(nlohmann::detail::exception e)
 							{
-								auto it {bottom.playlist_info["entries"].end()};
-								bottom.playlist_info["entries"].erase(--it);
+								bottom.playlist_info.clear();
+								if(queue_items.find(url))
+									json_error(e);
 							}
-							std::string URL {bottom.playlist_info["entries"][0]["url"]};
-							cmd = L" --no-warnings -j " + fmt_sort + to_wstring(URL);
-							media_info = {util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info)};
-							if(!media_info.empty() && media_info.front() == '{')
+							if(!bottom.playlist_info.empty())
 							{
-								try { bottom.vidinfo = nlohmann::json::parse(media_info); }
-								catch(nlohmann::detail::exception e)
+								if(incomplete_data_received)
 								{
-									bottom.vidinfo.clear();
-									if(lbq.item_from_value(url) != lbq.at(0).end())
-										json_error(e);
+									auto it {bottom.playlist_info["entries"].end()};
+									bottom.playlist_info["entries"].erase(--it);
 								}
-								if(!bottom.vidinfo.empty())
-									bottom.show_btnfmt(true);
+								else if(bottom.is_ytplaylist && conf.cb_playlist_sync)
+									playlists.save(url, bottom.playlist_info);
+							}
+						}
+					}
+					if(!bottom.playlist_info.empty() && (synced || !media_info.empty() && media_info.front() == '{'))
+					{
+						std::string URL {bottom.playlist_info["entries"][0]["url"]};
+						cmd = L" --no-warnings -j " + fmt_sort + to_wstring(URL);
+						media_info = {util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info)};
+						if(!media_info.empty() && media_info.front() == '{')
+						{
+							try { bottom.vidinfo = nlohmann::json::parse(media_info); }
+							catch(nlohmann::detail::exception e)
+							{
+								bottom.vidinfo.clear();
+								if(queue_items.find(url))
+									json_error(e);
 							}
-							else bottom.playlist_vid_cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
+							bottom.store_vidinfo();
+							if(!bottom.vidinfo.empty())
+								bottom.show_btnfmt(true);
 						}
+						else bottom.playlist_vid_cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
 					}
 				}
 				else // YouTube video
@@ -1128,6 +1257,7 @@ void GUI::add_url(std::wstring url, bool refresh)
 					if(conf.cb_proxy && !conf.proxy.empty())
 						cmd = L" --proxy " + conf.proxy + cmd;
 					bottom.cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
+					const auto t0 {std::chrono::steady_clock::now()};
 					media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
 					if(media_info.find("ERROR:") == 0)
 					{
@@ -1135,16 +1265,15 @@ void GUI::add_url(std::wstring url, bool refresh)
 						if(pos != -1)
 						{
 							auto strtime {media_info.substr(pos + 30, media_info.rfind('.') - pos - 30)};
-							lbq.item_from_value(url).text(1, "youtube.com");
-							lbq.item_from_value(url).text(2, "[live event scheduled to begin in " + strtime + ']');
-							lbq.item_from_value(url).text(4, "---");
-							lbq.item_from_value(url).text(5, "---");
-							lbq.item_from_value(url).text(6, "---");
-							lbq.item_from_value(url).text(7, "---");
-							bottom.vidinfo.clear();
-							active_threads--;
-							if(bottom.working_info)
-								bottom.info_thread.detach();
+							bottom.site("youtube.com");
+							if(auto pqi {queue_items.find(url)})
+							{
+								pqi->website = "youtube.com";
+								pqi->title = "[live event scheduled to begin in " + strtime + ']';
+								pqi->format = pqi->format_note = pqi->ext = pqi->filesize = "---";
+								lbq_update(url);
+							}
+							bottom.clear_vidinfo();
 							return;
 						}
 					}
@@ -1161,9 +1290,14 @@ void GUI::add_url(std::wstring url, bool refresh)
 							catch(nlohmann::detail::exception e)
 							{
 								bottom.vidinfo.clear();
-								if(lbq.item_from_value(url) != lbq.at(0).end())
+								if(queue_items.find(url))
 									json_error(e);
 							}
+							bottom.store_vidinfo();
+							bottom.vidinfo_time = std::chrono::system_clock::now();
+							bottom.vidinfo_secs = std::chrono::duration<double> {std::chrono::steady_clock::now() - t0}.count();
+							bottom.prefetched = false;
+							bottom.vidinfo_proxy = conf.cb_proxy ? conf.proxy : L"";
 						}
 					}
 				}
@@ -1176,13 +1310,19 @@ void GUI::add_url(std::wstring url, bool refresh)
 				if(conf.cb_proxy && !conf.proxy.empty())
 					cmd = L" --proxy " + conf.proxy + cmd;
 				bottom.cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
-				media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
-				try { bottom.playlist_info = nlohmann::json::parse(media_info); }
-				catch(nlohmann::detail::exception e)
+				bottom.playlist_new = -1;
+				if(!refresh || !sync_playlist(bottom, L""))
 				{
-					bottom.playlist_info.clear();
-					if(lbq.item_from_value(url) != lbq.at(0).end())
-						json_error(e);
+					media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
+					try { bottom.playlist_info = nlohmann::json::parse(media_info); }
+					catch(nlohmann::detail::exception e)
+					{
+						bottom.playlist_info.clear();
+						if(queue_items.find(url))
+							json_error(e);
+					}
+					if(refresh && !bottom.playlist_info.empty() && conf.cb_playlist_sync)
+						playlists.save(url, bottom.playlist_info);
 				}
 				if(!bottom.playlist_info.empty())
 				{
@@ -1220,9 +1360,10 @@ void GUI::add_url(std::wstring url, bool refresh)
 							catch(nlohmann::detail::exception e)
 							{
 								bottom.vidinfo.clear();
-								if(lbq.item_from_value(url) != lbq.at(0).end())
+								if(queue_items.find(url))
 									json_error(e);
 							}
+							bottom.store_vidinfo();
 							if(!bottom.vidinfo.empty())
 								bottom.show_btnfmt(true);
 						}
@@ -1230,14 +1371,16 @@ void GUI::add_url(std::wstring url, bool refresh)
 					}
 					else
 					{
-						lbq.item_from_value(url).text(1, bottom.is_bcchan ? "bandcamp.com" : "youtube.com");
-						lbq.item_from_value(url).text(2, tab + media_title);
-						lbq.item_from_value(url).text(4, "---");
-						lbq.item_from_value(url).text(5, "---");
-						lbq.item_from_value(url).text(6, "---");
-						lbq.item_from_value(url).text(7, "---");
-						bottom.vidinfo.clear();
-						if(vidsel_item.m && lbq.item_from_value(url).selected())
+						bottom.site(bottom.is_bcchan ? "bandcamp.com" : "youtube.com");
+						if(auto pqi {queue_items.find(url)})
+						{
+							pqi->website = bottom.site();
+							pqi->title = tab + media_title;
+							pqi->format = pqi->format_note = pqi->ext = pqi->filesize = "---";
+							lbq_update(url);
+						}
+						bottom.clear_vidinfo();
+						if(vidsel_item.m && lbq_item(url).selected())
 						{
 							auto &m {*vidsel_item.m};
 							for(int n {0}; n < m.size(); n++)
@@ -1250,9 +1393,6 @@ void GUI::add_url(std::wstring url, bool refresh)
 							vidsel_item.m = nullptr;
 						}
 
-						active_threads--;
-						if(bottom.working_info)
-							bottom.info_thread.detach();
 						return;
 					}
 				}
@@ -1264,6 +1404,7 @@ void GUI::add_url(std::wstring url, bool refresh)
 				if(conf.cb_proxy && !conf.proxy.empty())
 					cmd = L" --proxy " + conf.proxy + cmd;
 				bottom.cmdinfo = conf.ytdlp_path.filename().wstring() + cmd;
+				const auto t0 {std::chrono::steady_clock::now()};
 				media_info = util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info);
 				auto pos {media_info.rfind('}')};
 				if(pos != -1)
@@ -1278,9 +1419,14 @@ void GUI::add_url(std::wstring url, bool refresh)
 						catch(nlohmann::detail::exception e)
 						{
 							bottom.vidinfo.clear();
-							if(lbq.item_from_value(url) != lbq.at(0).end())
+							if(queue_items.find(url))
 								json_error(e);
 						}
+						bottom.store_vidinfo();
+						bottom.vidinfo_time = std::chrono::system_clock::now();
+						bottom.vidinfo_secs = std::chrono::duration<double> {std::chrono::steady_clock::now() - t0}.count();
+						bottom.prefetched = false;
+						bottom.vidinfo_proxy = conf.cb_proxy ? conf.proxy : L"";
 					}
 				}
 			}
@@ -1295,6 +1441,11 @@ void GUI::add_url(std::wstring url, bool refresh)
 							auto playlist_size {bottom.playlist_info["entries"].size()};
 							if(bottom.playsel_string.size())
 								bottom.apply_playsel_string();
+							else if(bottom.playlist_new >= 0) // synced: only the new entries are selected
+							{
+								bottom.playlist_selection.assign(playlist_size, false);
+								std::fill_n(bottom.playlist_selection.begin(), std::min<size_t>(bottom.playlist_new, playlist_size), true);
+							}
 							else bottom.playlist_selection.assign(playlist_size, true);
 							if(bottom.is_bcplaylist)
 								media_website = "bandcamp.com";
@@ -1302,7 +1453,7 @@ void GUI::add_url(std::wstring url, bool refresh)
 							if(bottom.is_yttab)
 								media_title = "[channel tab] " + std::string {bottom.playlist_info["title"]};
 							else media_title = "[playlist] " + std::string {bottom.playlist_info["title"]};
-							if(vidsel_item.m && lbq.item_from_value(url).selected())
+							if(vidsel_item.m && lbq_item(url).selected())
 							{
 								auto &m {*vidsel_item.m};
 								auto pos {vidsel_item.pos};
@@ -1314,11 +1465,17 @@ void GUI::add_url(std::wstring url, bool refresh)
 								api::refresh_window(m.handle());
 								vidsel_item.m = nullptr;
 							}
+							std::vector<std::string> ids;
 							for(const auto &entry : bottom.playlist_info["entries"])
 							{
 								if(entry.contains("id") && entry["id"] != nullptr)
-									outbox.set_keyword(entry["id"].get<std::string>() + ':', "id");
+									ids.push_back(entry["id"].get<std::string>() + ':');
 							}
+							ui_update(ui_queue::kind::other, url, [this, ids = std::move(ids)]
+							{
+								for(const auto &id : ids)
+									outbox.set_keyword(id, "id");
+							});
 						}
 					}
 					else if(!bottom.vidinfo.empty())
@@ -1340,12 +1497,15 @@ void GUI::add_url(std::wstring url, bool refresh)
 							ext = bottom.vidinfo["ext"];
 						if(bottom.vidinfo_contains("filesize"))
 						{
-							unsigned fsize {bottom.vidinfo["filesize"]};
+							unsigned long long fsize {bottom.vidinfo["filesize"].get<unsigned long long>()};
 							filesize = util::int_to_filesize(fsize, false);
+							size_bytes = fsize;
 						}
 						else if(bottom.vidinfo_contains("filesize_approx"))
 						{
-							unsigned fsize {bottom.vidinfo["filesize_approx"]};
+							unsigned long long fsize {bottom.vidinfo["filesize_approx"].get<unsigned long long>()};
+							size_bytes = fsize;
+							size_approx = true;
 							if(bottom.vidinfo_contains("requested_formats"))
 							{
 								auto &reqfmt {bottom.vidinfo["requested_formats"]};
@@ -1359,7 +1519,7 @@ void GUI::add_url(std::wstring url, bool refresh)
 							else filesize = '~' + util::int_to_filesize(fsize, false);
 						}
 
-						if(bottom.vidinfo_contains("formats"))
+						if(!bottom.formats.empty())
 							bottom.show_btnfmt(true);
 					}
 					//if(!refresh)
@@ -1373,49 +1533,64 @@ void GUI::add_url(std::wstring url, bool refresh)
 							std::wstring_convert<std::codecvt_utf8<wchar_t>> u8conv;
 							media_title = u8conv.to_bytes(wstr);
 						}
-						lbq.item_from_value(url).text(1, media_website);
-						lbq.item_from_value(url).text(2, media_title);
-						lbq.item_from_value(url).text(4, format_id);
-						lbq.item_from_value(url).text(5, format_note);
-						lbq.item_from_value(url).text(6, ext);
-						lbq.item_from_value(url).text(7, filesize);
-
-						if(!bottom.file_path().empty())
-							lbq.item_from_value(url).text(3, "done");
+						if(media_website != "---")
+							bottom.site(media_website);
+						if(auto pqi {queue_items.find(url)})
+						{
+							pqi->website = media_website;
+							pqi->title = media_title;
+							pqi->format = format_id;
+							pqi->format_note = format_note;
+							pqi->ext = ext;
+							pqi->filesize = filesize;
+							pqi->size = size_bytes;
+							pqi->size_approx = size_approx;
+							if(!bottom.file_path().empty())
+							{
+								pqi->state = queue_model::status::done;
+								pqi->progress.clear();
+								library_add(bottom); // downloaded before the library existed, or by another program
+							}
+							lbq_update(url);
+						}
 
 						if(bottom.vidinfo_contains("id"))
 						{
 							std::string idstr {bottom.vidinfo["id"]};
-							outbox.set_keyword(idstr + ':', "id");
+							ui_update(ui_queue::kind::other, url, [this, idstr] { outbox.set_keyword(idstr + ':', "id"); });
 						}
 					//}
 				}
 				else
 				{
-					auto stridx {lbq.item_from_value(url).text(0)};
-					lbq.item_from_value(url).text(1, "");
-					lbq.item_from_value(url).text(2, "yt-dlp failed to get info (see output)");
-					lbq.item_from_value(url).text(3, "error");
-					lbq.item_from_value(url).text(4, "");
-					lbq.item_from_value(url).text(5, "");
-					lbq.item_from_value(url).text(6, "");
-					lbq.item_from_value(url).text(7, "");
-
-					auto cmdline {bottom.playlist_vid_cmdinfo.empty() ? to_utf8(bottom.cmdinfo) : to_utf8(bottom.playlist_vid_cmdinfo)};
-					outbox.caption("[GUI] got error executing command line: " + cmdline + "\n\n" + media_info + "\n", url);
-					if(outbox.current() == url)
+					if(auto pqi {queue_items.find(url)})
 					{
-						auto ca {outbox.colored_area_access()};
-						ca->clear();
-						auto p {ca->get(0)};
-						p->fgcolor = ::widgets::theme::is_dark() ? ::widgets::theme::path_link_fg : color {"#569"};
+						pqi->website = pqi->format = pqi->format_note = pqi->ext = pqi->filesize = "";
+						pqi->title = "yt-dlp failed to get info (see output)";
+						pqi->state = queue_model::status::error;
+						pqi->progress.clear();
+						lbq_update(url);
 					}
-					if(!queue_panel.visible() && overlay.visible())
+
+					auto cmdline {bottom.playlist_vid_cmdinfo.empty() ? to_utf8(bottom.cmdinfo) : to_utf8(bottom.playlist_vid_cmdinfo)};
+					ui_update(ui_queue::kind::other, url,
+						[this, url, text = "[GUI] got error executing command line: " + cmdline + "\n\n" + media_info + "\n"]
 					{
-						outbox.widget::show();
-						overlay.hide();
-					}
-					if(vidsel_item.m && lbq.item_from_value(url).selected())
+						outbox.caption(text, url);
+						if(outbox.current() == url)
+						{
+							auto ca {outbox.colored_area_access()};
+							ca->clear();
+							auto p {ca->get(0)};
+							p->fgcolor = ::widgets::theme::is_dark() ? ::widgets::theme::path_link_fg : color {"#569"};
+						}
+						if(!queue_panel.visible() && overlay.visible())
+						{
+							outbox.widget::show();
+							overlay.hide();
+						}
+					});
+					if(vidsel_item.m && lbq_item(url).selected())
 					{
 						auto &m {*vidsel_item.m};
 						for(int n {0}; n < m.size(); n++)
@@ -1436,7 +1611,7 @@ void GUI::add_url(std::wstring url, bool refresh)
 					}
 				}
 			}
-			if(!refresh && vidsel_item.m && lbq.item_from_value(url).selected())
+			if(!refresh && vidsel_item.m && lbq_item(url).selected())
 			{
 				auto &m {*vidsel_item.m};
 				for(int n {0}; n < m.size(); n++)
@@ -1448,9 +1623,6 @@ void GUI::add_url(std::wstring url, bool refresh)
 				api::refresh_window(m.handle());
 				vidsel_item.m = nullptr;
 			}
-			active_threads--;
-			if(bottom.working_info && bottom.info_thread.joinable())
-				bottom.info_thread.detach();
 		});
 	}
 }
@@ -1466,7 +1638,7 @@ void GUI::make_form()
 	auto &plc {get_place()};
 	plc["Top"].fasten(queue_panel).fasten(outbox).fasten(overlay);
 	auto &bottom {bottoms.add(L"", true)};
-	bottom.btndl.enabled(false);
+	bottom.enable_btndl(false);
 	auto &tbpipe {outbox};
 	auto &tbpipe_overlay {overlay};
 	overlay.events().dbl_click([&, this] { show_queue(); queue_panel.focus(); });
@@ -1505,8 +1677,8 @@ void GUI::make_form()
 			l_url.caption("* multiple lines of text, make sure they're URLs *");
 		else 
 		{
-			auto item {lbq.item_from_value(text)};
-			if(item == lbq.at(0).end())
+			auto pos {queue_items.pos(text)};
+			if(pos == -1)
 			{
 				if(text.size() > 300)
 					text.erase(0, text.size() - 300);
@@ -1515,7 +1687,7 @@ void GUI::make_form()
 			}
 			else
 			{
-				qurl = text + L" (queue item #" + to_wstring(item.text(0)) + L")";
+				qurl = text + L" (queue item #" + std::to_wstring(pos + 1) + L")";
 				l_url.update_caption();
 			}
 		}
@@ -1556,13 +1728,13 @@ void GUI::make_form()
 			if(text.starts_with(LR"(https://www.youtube.com/watch?v=)"))
 				if(text.find(L"&list=") == 43)
 					text.erase(43);
-			auto item {lbq.item_from_value(text)};
-			if(item == lbq.at(0).end())
+			auto pos {queue_items.pos(text)};
+			if(pos == -1)
 			{
 				l_url.update_caption();
 				add_url(text);
 			}
-			else l_url.caption("The URL in the clipboard is already added (queue item #" + item.text(0) + ").");
+			else l_url.caption("The URL in the clipboard is already added (queue item #" + std::to_string(pos + 1) + ").");
 
 			if(theme::is_dark())
 				l_url.fgcolor(theme::path_link_fg);
@@ -1618,7 +1790,8 @@ bool GUI::apply_theme(bool dark)
 	refresh_widgets();
 
 	for(auto &bot : bottoms)
-		bot.second->bgcolor(theme::fmbg);
+		if(!bot.second->empty())
+			bot.second->bgcolor(theme::fmbg);
 
 	return false; // don't refresh widgets a second time, already done once in this function
 }
@@ -1629,11 +1802,13 @@ void GUI::show_queue(bool freeze_redraw)
 	if(freeze_redraw)
 		SendMessageA(hwnd, WM_SETREDRAW, FALSE, 0);
 	const auto px {nana::API::screen_dpi(true) >= 144};
-	change_field_attr(get_place(), "Bottom", "weight", 298 - 240 * bottoms.current().expcol.collapsed() - px);
+	change_field_attr(get_place(), "Bottom", "weight", 298 - 240 * bottoms.current().view->expcol.collapsed() - px);
 	for(auto &bot : bottoms)
 	{
-		auto &plc {bot.second->plc};
-		bot.second->btnq.caption("Show output");
+		if(!bot.second->materialized())
+			continue;
+		auto &plc {bot.second->view->plc};
+		bot.second->view->btnq.caption("Show output");
 		plc.field_display("prog", false);
 		plc.field_display("separator", true);
 		plc.collocate();
@@ -1651,11 +1826,12 @@ void GUI::show_queue(bool freeze_redraw)
 void GUI::show_output()
 {
 	SendMessageA(hwnd, WM_SETREDRAW, FALSE, 0);
-	change_field_attr(get_place(), "Bottom", "weight", 325 - 240 * bottoms.current().expcol.collapsed());
+	change_field_attr(get_place(), "Bottom", "weight", 325 - 240 * bottoms.current().view->expcol.collapsed());
 	for(auto &bot : bottoms)
-		bot.second->btnq.caption("Show queue");
+		if(bot.second->materialized())
+			bot.second->view->btnq.caption("Show queue");
 	auto &curbot {bottoms.current()};
-	auto &plc {curbot.plc};
+	auto &plc {curbot.view->plc};
 	plc.field_display("prog", true);
 	plc.field_display("separator", false);
 	plc.collocate();
@@ -1668,79 +1844,63 @@ void GUI::show_output()
 
 void GUI::get_releases()
 {
-	thr_releases = std::thread {[this]
+	releases_task = tasks.submit(executor::pool::io, [this](std::stop_token stop)
 	{
 		using json = nlohmann::json;
-		auto jtext {util::get_inet_res("https://api.github.com/repos/ErrorFlynn/ytdlp-interface/releases", &inet_error)};
-		if(!jtext.empty())
+		auto jtext {util::get_inet_res("https://api.github.com/repos/ErrorFlynn/ytdlp-interface/releases", &inet_error, stop)};
+		if(jtext.empty() || stop.stop_requested())
+			return;
+
+		auto show_error = [this](std::string mbox_title, std::string text)
 		{
-			try { releases = json::parse(jtext); }
-			catch(nlohmann::detail::exception e)
+			ui_update(ui_queue::kind::other, L"", [this, mbox_title, text]
 			{
-				releases.clear();
-				nana::msgbox mbox {*this, "ytdlp-interface JSON error"};
+				nana::msgbox mbox {*this, mbox_title};
 				mbox.icon(nana::msgbox::icon_error);
-				std::string str;
-				if(jtext.size() > 600)
-				{
-					jtext.erase(600);
-					str = " (showing the first 600 characters)";
-				}
-				(mbox << "Got an unexpected response when checking GitHub for a new version" + str + ":\n\n" << jtext
-					<< "\n\nError from the JSON parser:\n\n" << e.what())();
-				thr_releases.detach();
-				return;
-			}
-			if(releases.is_array())
+				(mbox << text)();
+			});
+		};
+
+		std::string str {"Got an unexpected response when checking GitHub for a new version"};
+		if(jtext.size() > 600)
+			str += " (showing the first 600 characters):\n\n" + jtext.substr(0, 600);
+		else str += ":\n\n" + jtext;
+
+		try { releases = json::parse(jtext); }
+		catch(nlohmann::detail::exception e)
+		{
+			releases.clear();
+			show_error("ytdlp-interface JSON error", str + "\n\nError from the JSON parser:\n\n" + e.what());
+			return;
+		}
+		if(releases.is_array())
+		{
+			if(releases[0].contains("tag_name"))
 			{
-				if(releases[0].contains("tag_name"))
-				{
-					std::string tag_name {releases[0]["tag_name"]};
-					if(tag_name.size() < 4)
-					{
-						nana::msgbox mbox {*this, "ytdlp-interface error"};
-						mbox.icon(nana::msgbox::icon_error);
-						(mbox << "Got an unexpected response when checking GitHub for a new version. "
-							<< "The response is valid JSON and is properly formatted, but the value of the key \"tag_name\" "
-							<< "for the latest release is less that 4 characters in length: \"" << tag_name << "\"")();
-						releases.clear();
-					}
-					else if(is_tag_a_new_version(tag_name) && conf.get_releases_at_startup)
-						caption(title + "   (" + tag_name + " is available)");
-				}
-				else
+				std::string tag_name {releases[0]["tag_name"]};
+				if(tag_name.size() < 4)
 				{
-					nana::msgbox mbox {*this, "ytdlp-interface error"};
-					mbox.icon(nana::msgbox::icon_error);
-					std::string str;
-					if(jtext.size() > 600)
-					{
-						jtext.erase(600);
-						str = " (showing the first 600 characters)";
-					}
-					(mbox << "Got an unexpected response when checking GitHub for a new version" + str + ":\n\n" << jtext
-						<< "\n\nThe response is valid JSON and is formatted as an array (as expected), but the first element "
-						<< "does not contain the key \"tag_name\".")();
 					releases.clear();
+					show_error("ytdlp-interface error", "Got an unexpected response when checking GitHub for a new version. "
+						"The response is valid JSON and is properly formatted, but the value of the key \"tag_name\" "
+						"for the latest release is less that 4 characters in length: \"" + tag_name + "\"");
 				}
+				else if(is_tag_a_new_version(tag_name) && conf.get_releases_at_startup)
+					ui_update(ui_queue::kind::other, L"", [this, tag_name] { caption(title + "   (" + tag_name + " is available)"); });
 			}
 			else
 			{
-				nana::msgbox mbox {*this, "ytdlp-interface error"};
-				mbox.icon(nana::msgbox::icon_error);
-				std::string str;
-				if(jtext.size() > 600)
-				{
-					jtext.erase(600);
-					str = " (showing the first 600 characters)";
-				}
-				(mbox << "Got an unexpected response when checking GitHub for a new version" + str +":\n\n" << jtext
-					<< "\n\nThe response is valid JSON, but is not formatted as an array.")();
 				releases.clear();
+				show_error("ytdlp-interface error", str + "\n\nThe response is valid JSON and is formatted as an array (as "
+					"expected), but the first element does not contain the key \"tag_name\".");
 			}
 		}
-		thr_releases.detach();
-	}};
+		else
+		{
+			releases.clear();
+			show_error("ytdlp-interface error", str + "\n\nThe response is valid JSON, but is not formatted as an array.");
+		}
+	});
 }
 
 
@@ -1748,46 +1908,47 @@ void GUI::get_latest_ffmpeg()
 {
 	using json = nlohmann::json;
 
-	thr_releases_ffmpeg = std::thread {[this]
+	releases_ffmpeg_task = tasks.submit(executor::pool::io, [this](std::stop_token stop)
 	{
-		auto jtext {util::get_inet_res("https://api.github.com/repos/yt-dlp/FFmpeg-Builds/releases", &inet_error)};
-		if(!jtext.empty())
+		auto jtext {util::get_inet_res("https://api.github.com/repos/yt-dlp/FFmpeg-Builds/releases", &inet_error, stop)};
+		if(jtext.empty() || stop.stop_requested())
+			return;
+
+		json json_ffmpeg;
+		try { json_ffmpeg = json::parse(jtext); }
+		catch(nlohmann::detail::exception e)
 		{
-			json json_ffmpeg;
-			try { json_ffmpeg = json::parse(jtext); }
-			catch(nlohmann::detail::exception e)
+			if(jtext.size() > 700)
+				jtext.erase(700);
+			std::string text {"Got an unexpected response when checking GitHub for a new FFmpeg version:\n\n" + jtext +
+				"\n\nError from the JSON parser:\n\n" + e.what()};
+			ui_update(ui_queue::kind::other, L"", [this, text]
 			{
 				nana::msgbox mbox {*this, "ytdlp-interface JSON error"};
 				mbox.icon(nana::msgbox::icon_error);
-				if(jtext.size() > 700)
-					jtext.erase(700);
-				(mbox << "Got an unexpected response when checking GitHub for a new FFmpeg version:\n\n" << jtext
-					<< "\n\nError from the JSON parser:\n\n" << e.what())();
-				if(thr_releases_ffmpeg.joinable())
-					thr_releases_ffmpeg.detach();
-				return;
-			}
-			if(!json_ffmpeg.empty())
+				(mbox << text)();
+			});
+			return;
+		}
+		if(!json_ffmpeg.empty())
+		{
+			for(auto &el : json_ffmpeg[0]["assets"])
 			{
-				for(auto &el : json_ffmpeg[0]["assets"])
+				std::string url {el["browser_download_url"]};
+				if(url.find(X64 ? "win64-gpl.zip" : "win32-gpl.zip") != -1)
 				{
-					std::string url {el["browser_download_url"]};
-					if(url.find(X64 ? "win64-gpl.zip" : "win32-gpl.zip") != -1)
-					{
-						url_latest_ffmpeg = url;
-						size_latest_ffmpeg = el["size"];
-						std::string date {json_ffmpeg[0]["published_at"]};
-						ver_ffmpeg_latest.year = stoi(date.substr(0, 4));
-						ver_ffmpeg_latest.month = stoi(date.substr(5, 2));
-						ver_ffmpeg_latest.day = stoi(date.substr(8, 2));
-						break;
-					}
+					url_latest_ffmpeg = url;
+					size_latest_ffmpeg = el["size"];
+					sha256_latest_ffmpeg = asset_sha256(json_ffmpeg[0]["assets"], url.substr(url.rfind('/') + 1), "checksums.sha256", stop);
+					std::string date {json_ffmpeg[0]["published_at"]};
+					ver_ffmpeg_latest.year = stoi(date.substr(0, 4));
+					ver_ffmpeg_latest.month = stoi(date.substr(5, 2));
+					ver_ffmpeg_latest.day = stoi(date.substr(8, 2));
+					break;
 				}
 			}
 		}
-		if(thr_releases_ffmpeg.joinable())
-			thr_releases_ffmpeg.detach();
-	}};
+	});
 }
 
 
@@ -1795,7 +1956,9 @@ void GUI::get_latest_ytdlp()
 {
 	using json = nlohmann::json;
 
-	thr_releases_ytdlp = std::thread {[this]
+	// a check that's still going on is for the other channel (see the channel radio buttons in the settings)
+	releases_ytdlp_task.cancel();
+	releases_ytdlp_task = tasks.submit(executor::pool::io, [this](std::stop_token stop)
 	{
 		std::string jtext;
 		auto fname {conf.ytdlp_path.filename().string()};
@@ -1804,73 +1967,99 @@ void GUI::get_latest_ytdlp()
 		if(fname == "yt-dlp.exe" || fname == "yt-dlp_x86.exe")
 		{
 			if(conf.ytdlp_nightly)
-				jtext = util::get_inet_res("https://api.github.com/repos/yt-dlp/yt-dlp-nightly-builds/releases/latest", &inet_error);
-			else jtext = util::get_inet_res("https://api.github.com/repos/yt-dlp/yt-dlp/releases/latest", &inet_error);
+				jtext = util::get_inet_res("https://api.github.com/repos/yt-dlp/yt-dlp-nightly-builds/releases/latest", &inet_error, stop);
+			else jtext = util::get_inet_res("https://api.github.com/repos/yt-dlp/yt-dlp/releases/latest", &inet_error, stop);
 		}
-		else jtext = util::get_inet_res("https://api.github.com/repos/ytdl-patched/ytdl-patched/releases/latest", &inet_error);
-		if(!jtext.empty() && thr_releases_ytdlp.joinable())
+		else jtext = util::get_inet_res("https://api.github.com/repos/ytdl-patched/ytdl-patched/releases/latest", &inet_error, stop);
+		if(jtext.empty() || stop.stop_requested())
+			return;
+
+		json json_ytdlp;
+		try { json_ytdlp = json::parse(jtext); }
+		catch(nlohmann::detail::exception e)
 		{
-			json json_ytdlp;
-			try { json_ytdlp = json::parse(jtext); }
-			catch(nlohmann::detail::exception e)
+			if(jtext.size() > 700)
+				jtext.erase(700);
+			std::string text {"Got an unexpected response when checking GitHub for a new yt-dlp version:\n\n" + jtext +
+				"\n\nError from the JSON parser:\n\n" + e.what()};
+			ui_update(ui_queue::kind::other, L"", [this, text]
 			{
 				nana::msgbox mbox {*this, "ytdlp-interface JSON error"};
 				mbox.icon(nana::msgbox::icon_error);
-				if(jtext.size() > 700)
-					jtext.erase(700);
-				(mbox << "Got an unexpected response when checking GitHub for a new yt-dlp version:\n\n" << jtext
-					<< "\n\nError from the JSON parser:\n\n" << e.what())();
-				if(thr_releases_ytdlp.joinable())
-					thr_releases_ytdlp.detach();
-				return;
-			}
-			if(!json_ytdlp.empty() && thr_releases_ytdlp.joinable())
+				(mbox << text)();
+			});
+			return;
+		}
+		if(!json_ytdlp.empty())
+		{
+			for(auto &el : json_ytdlp["assets"])
 			{
-				for(auto &el : json_ytdlp["assets"])
+				std::string url {el["browser_download_url"]};
+				if(url.find(fname) != -1)
 				{
-					std::string url {el["browser_download_url"]};
-					if(url.find(fname) != -1)
-					{
-						url_latest_ytdlp = url;
-						size_latest_ytdlp = el["size"];
-						url_latest_ytdlp_relnotes = json_ytdlp["html_url"];
-						std::string date {json_ytdlp["published_at"]};
-						ver_ytdlp_latest.year = stoi(date.substr(0, 4));
-						ver_ytdlp_latest.month = stoi(date.substr(5, 2));
-						ver_ytdlp_latest.day = stoi(date.substr(8, 2));
+					const auto sha256 {asset_sha256(json_ytdlp["assets"], fname, "SHA2-256SUMS", stop)};
+					if(stop.stop_requested())
 						break;
-					}
+					url_latest_ytdlp = url;
+					size_latest_ytdlp = el["size"];
+					sha256_latest_ytdlp = sha256;
+					url_latest_ytdlp_relnotes = json_ytdlp["html_url"];
+					std::string date {json_ytdlp["published_at"]};
+					ver_ytdlp_latest.year = stoi(date.substr(0, 4));
+					ver_ytdlp_latest.month = stoi(date.substr(5, 2));
+					ver_ytdlp_latest.day = stoi(date.substr(8, 2));
+					break;
 				}
 			}
 		}
-		if(thr_releases_ytdlp.joinable())
-			thr_releases_ytdlp.detach();
-	}};
+	});
+}
+
+
+std::string GUI::asset_sha256(const nlohmann::json &assets, std::string fname, std::string sums_name, std::stop_token stop)
+{
+	// GitHub publishes a "digest" for every asset uploaded since mid-2025; older releases only have the checksum file
+	std::string sums_url;
+	for(auto &el : assets)
+	{
+		if(el["name"] == fname && el.contains("digest") && el["digest"].is_string())
+		{
+			std::string digest {el["digest"]};
+			if(digest.find("sha256:") == 0)
+				return digest.substr(7);
+		}
+		if(!sums_name.empty() && el["name"] == sums_name)
+			sums_url = el["browser_download_url"];
+	}
+	if(!sums_url.empty())
+		return util::sha256_from_sums(util::get_inet_res(sums_url, nullptr, stop), fname);
+	return "";
 }
 
 
 void GUI::get_versions()
 {
-	thr_versions = std::thread {[this]
+	// ffmpeg -version and yt-dlp --version run side by side
+	versions_ffmpeg_task = tasks.submit(executor::pool::io, [this](std::stop_token stop)
 	{
-		std::thread thr_ffmpeg([this]
+		if(!ffmpeg_loc.empty() && !stop.stop_requested())
 		{
-			if(!ffmpeg_loc.empty())
+			std::wstring cmd {L'\"' + ffmpeg_loc.wstring() + L"\" -version"};
+			auto ver {util::run_piped_process(cmd)};
+			auto pos {ver.find("--extra-version=")};
+			if(pos != -1)
 			{
-				std::wstring cmd {L'\"' + ffmpeg_loc.wstring() + L"\" -version"};
-				auto ver {util::run_piped_process(cmd)};
-				auto pos {ver.find("--extra-version=")};
-				if(pos != -1)
-				{
-					auto rawver {ver.substr(pos + 16, 8)};
-					ver_ffmpeg.year = stoi(rawver.substr(0, 4));
-					ver_ffmpeg.month = stoi(rawver.substr(4, 2));
-					ver_ffmpeg.day = stoi(rawver.substr(6, 2));
-				}
+				auto rawver {ver.substr(pos + 16, 8)};
+				ver_ffmpeg.year = stoi(rawver.substr(0, 4));
+				ver_ffmpeg.month = stoi(rawver.substr(4, 2));
+				ver_ffmpeg.day = stoi(rawver.substr(6, 2));
 			}
-		});
+		}
+	});
 
-		if(!conf.ytdlp_path.empty())
+	versions_ytdlp_task = tasks.submit(executor::pool::io, [this](std::stop_token stop)
+	{
+		if(!conf.ytdlp_path.empty() && !stop.stop_requested())
 		{
 			if(fs::exists(conf.ytdlp_path))
 			{
@@ -1879,27 +2068,18 @@ void GUI::get_versions()
 				{
 					auto rawver {ver.substr(0, 10)};
 					try { ver_ytdlp.year = stoi(rawver.substr(0, 4)); }
-					catch(const std::invalid_argument&)
-					{
-						thr_versions.detach();
-						if(thr_ffmpeg.joinable())
-							thr_ffmpeg.join();
-						return;
-					}
+					catch(const std::invalid_argument&) { return; }
 					ver_ytdlp.month = stoi(rawver.substr(5, 2));
 					ver_ytdlp.day = stoi(rawver.substr(8, 2));
 				}
 			}
 			else conf.ytdlp_path.clear();
 		}
-		if(thr_ffmpeg.joinable())
-			thr_ffmpeg.join();
-		if(thr_versions.joinable())
-			thr_versions.detach();
-	}};
+	});
 }
 
 
+
 void GUI::get_version_ytdlp()
 {
 	if(!conf.ytdlp_path.empty())
@@ -1972,12 +2152,9 @@ void GUI::change_field_attr(nana::place &plc, std::string field, std::string att
 
 void GUI::taskbar_overall_progress()
 {
-	if(i_taskbar && lbq.at(0).size() > 1)
+	if(i_taskbar && queue_items.size() > 1)
 	{
-		ULONGLONG completed {0}, total {lbq.at(0).size()};
-		for(auto &item : lbq.at(0))
-			if(item.text(3) == "done")
-				completed++;
+		ULONGLONG completed {queue_items.count(queue_model::status::done)}, total {queue_items.size()};
 		if(completed)
 			if(completed == total)
 				i_taskbar->SetProgressState(hwnd, TBPF_NOPROGRESS);
@@ -1987,31 +2164,54 @@ void GUI::taskbar_overall_progress()
 }
 
 
+void GUI::update_queue_totals()
+{
+	const auto t {queue_items.totals(max_concurrent(), autostart_next_item)};
+	std::string text;
+	if(t.running)
+	{
+		text = util::int_to_filesize(t.remaining, false) + " left";
+		if(t.unknown)
+			text += " (+" + std::to_string(t.unknown) + (t.unknown == 1 ? " item" : " items") + " of unknown size)";
+		if(t.eta >= 0)
+			text += ", ETA " + util::format_duration(static_cast<unsigned long long>(t.eta + 0.5)) + (t.unknown ? "+" : "");
+	}
+	if(text != queue_totals_text)
+	{
+		queue_totals_text = text;
+		lbq.column_at(2).text(text.empty() ? "Media title" : "Media title   -   " + text);
+		if(i_taskbar)
+			i_taskbar->SetThumbnailTooltip(hwnd, text.empty() ? nullptr : nana::to_wstring(title + "\n" + text).data());
+	}
+	// with more than one item, the taskbar button shows the progress of the whole queue by bytes when they're all known
+	if(i_taskbar && t.running && !t.unknown && t.size && queue_items.size() > 1)
+		i_taskbar->SetProgressValue(hwnd, t.finished + t.downloaded, t.finished + t.size);
+}
+
+
 void GUI::on_btn_dl(std::wstring url)
 {
 	taskbar_overall_progress();
 	if(!process_queue_item(url))
 		return; // the queue item was stopped, not started
 
-	auto items_currently_downloading {0};
-	
-	for(auto &bottom : bottoms)
-		if(bottom.second->started())
-			items_currently_downloading++;
-
-	auto item_total {lbq.at(0).size()};
+	auto items_currently_downloading {network_load()};
+	auto item_total {queue_items.size()};
 	if(item_total > 1)
 	{
-		auto pos {std::stoi(lbq.item_from_value(url).text(0)) - 1};
-		while(++pos < item_total && items_currently_downloading < conf.max_concurrent_downloads)
+		auto domain_running {running_per_domain()};
+		auto pos {queue_items.pos(url)};
+		while(++pos < item_total && items_currently_downloading < max_concurrent())
 		{
-			auto next_item {lbq.at(0).at(pos)};
-			std::wstring next_url {next_item.value<lbqval_t>()};
-			auto text {next_item.text(3)};
-			if(text == "queued" || text.find("stopped") == 0)
+			if(queue_items.at(pos).startable())
 			{
+				const auto next_url {queue_items.at(pos).url};
+				auto domain {bottoms.at(next_url).domain_key()};
+				if(!domain_allows(domain, domain_running))
+					continue;
 				process_queue_item(next_url);
 				items_currently_downloading++;
+				domain_running[domain]++;
 			}
 		}
 	}
@@ -2020,55 +2220,45 @@ void GUI::on_btn_dl(std::wstring url)
 
 void GUI::remove_queue_item(std::wstring url)
 {
-	auto item {lbq.item_from_value(url)};
+	const auto pos {queue_items.pos(url)};
 	auto next_url {next_startable_url()};
-	if(item != lbq.at(0).end())
+	if(pos != -1)
 	{
 		auto &bottom {bottoms.at(url)};
-		if(lbq.at(0).size() > 1)
-			for(auto it {item}; it != lbq.at(0).end(); it++)
-			{
-				const auto stridx {std::to_string(std::stoi(it.text(0)) - 1)};
-				it.text(0, stridx);
-				if(!conf.common_dl_options)
-					bottoms.at(it.value<lbqval_t>()).gpopt.caption("Download options for queue item #" + stridx);
-			}
-
-		auto prev_idx {std::stoi(item.text(0)) - 1};
-		auto next_item {lbq.erase(item)};
-		nana::api::refresh_window(lbq);
+		queue_items.erase(url);
+		auto next_item {lbq.erase(lbq.at(0).at(pos))};
+		nana::api::refresh_window(lbq); // the items after it are numbered from their new positions when drawn
 		taskbar_overall_progress();
 		adjust_lbq_headers();
 		if(next_item != lbq.at(0).end())
 			next_item.select(true);
-		else if(lbq.at(0).size() != 0)
-			lbq.at(0).at(prev_idx > -1 ? prev_idx : 0).select(true);
+		else if(!queue_items.empty())
+			lbq.at(0).at(pos ? pos - 1 : 0).select(true);
 		else
 		{
 			bottoms.show(L"");
 			qurl = L"";
 			l_url.update_caption();
 		}
-		if(bottom.timer_proc.started())
-			bottom.timer_proc.stop();
-		if(bottom.info_thread.joinable())
-		{
-			bottom.working_info = false;
-			bottom.info_thread.join();
-		}
+		stop_prefetch(url);
+		bottom.stop_info();
 		if(bottom.dl_thread.joinable())
 		{
+			// a thread that has finished its download has handed its slot over already
+			const bool downloading {bottom.started()};
 			bottom.working = false;
 			bottom.dl_thread.join();
-			if(!next_url.empty())
+			if(downloading && !next_url.empty())
 				on_btn_dl(next_url);
 		}
+		ui.discard(url);
 		bottoms.erase(url);
 		outbox.erase(url);
+		item_caption(bottoms.visible());
 		if(bottoms.size() == 2)
 		{
 			SendMessageA(hwnd, WM_SETREDRAW, FALSE, 0);
-			if(bottoms.at(1).plc.field_display("btncopy"))
+			if(bottoms.at(1).btncopy_visible())
 				bottoms.at(1).show_btncopy(false);
 			SendMessageA(hwnd, WM_SETREDRAW, TRUE, 0);
 			nana::api::refresh_window(*this);
@@ -2077,33 +2267,42 @@ void GUI::remove_queue_item(std::wstring url)
 }
 
 
+void GUI::hand_off_slot(const std::wstring &url)
+{
+	auto next_url {next_startable_url(url)};
+	if(!next_url.empty())
+	{
+		prefetch.slot_freed = std::chrono::steady_clock::now();
+		on_btn_dl(next_url);
+		prefetch.slot_freed = {}; // in case the item wasn't started after all
+	}
+}
+
+
 std::wstring GUI::next_startable_url(std::wstring current_url)
 {
 	if(autostart_next_item)
 	{
-		auto item_total {lbq.at(0).size()};
+		auto item_total {queue_items.size()};
 		if(item_total > 1)
 		{
-			auto items_currently_downloading {0};
+			auto items_currently_downloading {network_load()};
 			if(current_url == L"current")
 				current_url = bottoms.current().url;
-			for(auto item : lbq.at(0))
-			{
-				const auto text {item.text(3)};
-				if(text == "downloading" || (text.find('%') != -1 && text.find("stopped") == -1) || text == "started")
-					items_currently_downloading++;
-			}
 
-			auto pos {current_url.empty() ? -1 : stoi(lbq.item_from_value(current_url).text(0)) - 1};
+			const auto domain_running {running_per_domain()};
+			auto pos {current_url.empty() ? -1 : queue_items.pos(current_url)};
 			if(pos == item_total - 1)
 				pos = -1;
-			while(++pos < item_total && items_currently_downloading < conf.max_concurrent_downloads)
+			while(++pos < item_total && items_currently_downloading < max_concurrent())
 			{
-				auto next_item {lbq.at(0).at(pos)};
-				const auto &next_url {next_item.value<lbqval_t>().url};
-				auto text {next_item.text(3)};
-				if(text == "queued" || text.starts_with("stopped"))
-					return next_url;
+				const auto &next_url {queue_items.at(pos).url};
+				if(queue_items.at(pos).startable())
+				{
+					// items from a website that's at its limit are passed over in favor of the ones from other websites
+					if(domain_allows(bottoms.at(next_url).domain_key(), domain_running))
+						return next_url;
+				}
 			}
 		}
 	}
@@ -2111,6 +2310,800 @@ std::wstring GUI::next_startable_url(std::wstring current_url)
 }
 
 
+std::map<std::string, unsigned> GUI::running_per_domain()
+{
+	std::map<std::string, unsigned> running;
+	if(conf.cb_domain_limits)
+		for(auto &pbot : bottoms)
+			if(pbot.second->index && pbot.second->started())
+				running[pbot.second->domain_key()]++;
+	return running;
+}
+
+
+bool GUI::domain_allows(const std::string &domain, const std::map<std::string, unsigned> &running)
+{
+	using namespace std::chrono;
+
+	if(!conf.cb_domain_limits || domain.empty())
+		return true;
+
+	const auto cap {conf.domain_caps.contains(domain) ? conf.domain_caps[domain] : conf.domain_max};
+	if(running.contains(domain) && running.at(domain) >= cap)
+		return false;
+
+	if(conf.domain_spacing && domain_last_start.contains(domain))
+	{
+		const auto wait {milliseconds {conf.domain_spacing} - duration_cast<milliseconds>(steady_clock::now() - domain_last_start[domain])};
+		if(wait.count() > 0)
+		{
+			// check again once the wait is over; the timer is only re-armed if this wait ends sooner
+			if(!domain_timer.started() || wait < domain_timer_due - steady_clock::now())
+			{
+				domain_timer.stop();
+				domain_timer.interval(wait + milliseconds {50});
+				domain_timer_due = steady_clock::now() + wait;
+				domain_timer.start();
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+
+unsigned GUI::max_concurrent()
+{
+	// queue.cpp sets the limit to -1 while looking for the first startable item, which has to win over the controller
+	if(conf.cb_adaptive_concurrency && adaptive.slots && conf.max_concurrent_downloads != -1)
+		return adaptive.slots;
+	return conf.max_concurrent_downloads;
+}
+
+
+unsigned GUI::postproc_slots()
+{
+	// ffmpeg uses several threads per job when it has to re-encode, so the pool gets one slot for every two cores
+	return std::max(1u, std::thread::hardware_concurrency() / 2);
+}
+
+
+std::vector<std::wstring> GUI::playlist_shards(gui_bottom &bottom)
+{
+	/* The selected entries are split into as many shards as there are free download slots (the item's own slot
+	   included), in runs of consecutive playlist indexes, so the shards get about the same number of entries each.
+	   A shard is returned as the argument of "-I"; the playlist_index of the entries is the same as with one process,
+	   so the output template names the files the same way. Fewer than two shards means the item isn't split. */
+
+	const unsigned min_entries {10}; // per shard, so that the extraction each process does first pays off
+	std::vector<std::wstring> shards;
+	if(!conf.cb_playlist_shards || bottom.playlist_selection.empty())
+		return shards;
+
+	std::vector<unsigned> indexes;
+	for(size_t n {0}; n < bottom.playlist_selection.size(); n++)
+		if(bottom.playlist_selection[n])
+			indexes.push_back(static_cast<unsigned>(n + 1));
+	const auto load {network_load()}, slots {max_concurrent()};
+	const auto free_slots {slots > load ? slots - load + 1 : 1};
+	const auto count {std::min<size_t>(free_slots, indexes.size() / min_entries)};
+	if(count < 2)
+		return shards;
+
+	for(size_t n {0}, first {0}; n < count; n++)
+	{
+		const auto last {(n + 1) * indexes.size() / count};
+		std::wstring items;
+		for(auto i {first}; i < last; i++)
+		{
+			auto run_end {i};
+			while(run_end + 1 < last && indexes[run_end + 1] == indexes[run_end] + 1)
+				run_end++;
+			if(!items.empty())
+				items += L',';
+			items += std::to_wstring(indexes[i]);
+			if(run_end > i)
+				items += L':' + std::to_wstring(indexes[run_end]);
+			i = run_end;
+		}
+		shards.push_back(std::move(items));
+		first = last;
+	}
+	return shards;
+}
+
+
+void GUI::prefetch_tick()
+{
+	/* The info of the next few startable items is extracted again shortly before it would be too old to be reused at the
+	   start of their download (see info_json_usable), one item at a time, so that when a download slot frees up, the
+	   next item starts from fresh info (fresh signed URLs included) instead of extracting it first. */
+
+	using namespace std::chrono;
+
+	if(prefetch.task.valid())
+	{
+		if(prefetch.task.running())
+			return;
+		prefetch.task.get();
+	}
+	if(!conf.cb_load_info_json || !conf.prefetch_depth)
+		return;
+
+	const auto now {system_clock::now()};
+	const long long horizon {600}; // seconds
+	unsigned depth {0};
+	for(auto &item : queue_items)
+	{
+		if(!item->startable())
+			continue;
+		if(depth++ == conf.prefetch_depth)
+			break;
+		auto &bottom {bottoms.at(item->url)};
+		if(bottom.started() || bottom.info_task.running() || bottom.vidinfo.empty() || bottom.cmdinfo.empty() ||
+			bottom.is_ytplaylist || bottom.is_ytchan || bottom.is_bcplaylist || bottom.is_bcchan)
+			continue;
+		if(bottom.prefetch_time.time_since_epoch().count() && steady_clock::now() - bottom.prefetch_time < minutes {5})
+			continue;
+		// how long the info can still be reused: it must be less than 30 minutes old, with 10 minutes left on the URLs
+		auto fresh_for {30 * 60 - duration_cast<seconds>(now - bottom.vidinfo_time).count()};
+		if(bottom.vidinfo_expire)
+			fresh_for = std::min(fresh_for, bottom.vidinfo_expire - duration_cast<seconds>(now.time_since_epoch()).count() - 600);
+		if(fresh_for > horizon)
+			continue;
+
+		const auto fname {conf.ytdlp_path.filename().wstring()};
+		if(bottom.cmdinfo.find(fname) != 0)
+			continue;
+		const auto cmd {L'\"' + conf.ytdlp_path.wstring() + L'\"' + bottom.cmdinfo.substr(fname.size())};
+		const auto proxy {conf.cb_proxy ? conf.proxy : L""};
+		prefetch.url = item->url;
+		prefetch.working = true;
+		bottom.prefetch_time = steady_clock::now();
+		prefetch.task = tasks.submit(executor::pool::io, [this, url = item->url, cmd, proxy](std::stop_token stop)
+		{
+			std::stop_callback on_stop {stop, [this] { prefetch.working = false; }};
+			const auto t0 {steady_clock::now()};
+			auto media_info {util::run_piped_process(cmd, &prefetch.working)};
+			const auto secs {duration<double> {steady_clock::now() - t0}.count()};
+			const auto pos {media_info.find("{\"id\":")}, end {media_info.rfind('}')};
+			if(!prefetch.working || pos == -1 || end == -1 || end < pos)
+				return;
+			// parsing a big info dict keeps a core busy, so it's done on the CPU pool, while this waits for it; the item's
+			// info is read by the GUI thread all the time, so the parsed info is swapped in there
+			auto info {std::make_shared<nlohmann::json>()};
+			tasks.submit(executor::pool::cpu, [&](std::stop_token)
+			{
+				try { *info = nlohmann::json::parse(media_info.substr(pos, end - pos + 1)); }
+				catch(nlohmann::detail::exception) {} // the info that was there is kept
+			}).wait();
+			if(!prefetch.working || info->empty())
+				return;
+			const auto time {system_clock::now()};
+			ui_update(ui_queue::kind::other, url, [this, url, info, time, secs, proxy]
+			{
+				if(!bottoms.contains(url))
+					return;
+				auto &bottom {bottoms.at(url)};
+				if(bottom.started() || bottom.info_task.running())
+					return; // the info has been replaced, or is being used, since the refresh began
+				bottom.vidinfo = std::move(*info);
+				bottom.store_vidinfo();
+				bottom.vidinfo_time = time;
+				bottom.vidinfo_proxy = proxy;
+				bottom.vidinfo_secs = secs;
+				bottom.prefetched = true;
+				bottom.predict_path();
+			});
+		});
+		break;
+	}
+}
+
+
+void GUI::stop_prefetch(const std::wstring &url)
+{
+	if(prefetch.task.valid() && (url.empty() || url == prefetch.url))
+	{
+		prefetch.working = false;
+		prefetch.task.cancel();
+		prefetch.task.get();
+	}
+}
+
+
+unsigned GUI::ffmpeg_threads()
+{
+	// Every ffmpeg process uses all the cores by default, so when several items are post-processed at once, the CPU
+	// is oversubscribed. The value goes on yt-dlp's command line when the item is started, long before its ffmpeg runs,
+	// so the cores are divided between the jobs that can be running by then: any of the running items (this one
+	// included) can reach post-processing at the same time as the others, up to the size of the post-processing pool
+	// when it's used. Items that are started later don't change the value of the ones already running.
+	// (tests/ffmpeg_threads_bench.py times concurrent jobs with and without the split)
+
+	const auto cores {std::max(1u, std::thread::hardware_concurrency())};
+	unsigned jobs {0};
+	for(auto &pbot : bottoms)
+		if(pbot.second->index && pbot.second->started())
+			jobs++;
+	if(conf.cb_lengthyproc)
+		jobs = std::min(jobs, postproc_slots());
+	return std::max(1u, cores / std::max(1u, jobs));
+}
+
+
+unsigned GUI::concurrent_fragments(const std::wstring &url)
+{
+	/* The connection budget is shared by the items on the download slots: a new item gets an equal share of it, but no
+	   more than what the running items have left. When the running items are slow, the server is most likely limiting
+	   the rate per connection, so the new item gets twice its share, as far as what's left allows. The value of a running
+	   item can't be changed, so the shares are evened out as items finish and new ones start. */
+
+	const double slow {1024 * 1024}; // bytes/s per item
+	unsigned used {0}, running {0};
+	double speed {0};
+	for(auto &pbot : bottoms)
+	{
+		auto &bot {*pbot.second};
+		if(bot.index && bot.started() && bot.url != url)
+		{
+			if(auto pqi {queue_items.find(bot.url)}; pqi && pqi->state == queue_model::status::processing)
+				continue;
+			used += bot.fragments ? bot.fragments : 1;
+			speed += bot.dl_speed;
+			running++;
+		}
+	}
+	const auto budget {std::max(1u, conf.fragment_budget)};
+	const auto left {budget > used ? budget - used : 1};
+	auto share {std::max(1u, budget / (running + 1))};
+	if(running && speed / running < slow)
+		share *= 2;
+	return std::clamp(share, 1u, left);
+}
+
+
+unsigned GUI::network_load()
+{
+	// The queue is a two-stage pipeline: an item takes a download slot while yt-dlp downloads, and a post-processing slot
+	// while ffmpeg works on the files (merging, extracting audio, embedding, cutting). When every post-processing slot is
+	// taken, the items that are waiting for one keep holding their download slot, so that ffmpeg jobs don't pile up.
+
+	unsigned downloading {0}, processing {0};
+	for(auto &pbot : bottoms)
+	{
+		// the bottom is marked as started right away, while the item's status is set from the download thread
+		if(pbot.second->index && pbot.second->started())
+		{
+			// a playlist keeps its download slot while a video of it is post-processed, as it needs it again for the
+			// next one, and taking it back then could go over the limit
+			auto pqi {queue_items.find(pbot.first)};
+			if(pqi && pqi->state == queue_model::status::processing && !pbot.second->multi_video())
+				processing++;
+			else downloading += std::max(1u, pbot.second->shards.load()); // a sharded playlist takes a slot per shard
+		}
+	}
+	if(!conf.cb_lengthyproc)
+		return downloading + processing;
+	const auto slots {postproc_slots()};
+	return downloading + (processing > slots ? processing - slots : 0);
+}
+
+
+void GUI::adaptive_concurrency_tick()
+{
+	// Hill climbing on the combined download rate, sampled once a second and averaged over 10 second windows:
+	// a slot is added while the average keeps rising, and dropped again when it flattens out or errors show up.
+
+	const unsigned window {10}, cooldown_after_error {3}, cooldown_after_revert {6};
+
+	if(!conf.cb_adaptive_concurrency)
+	{
+		adaptive.slots = 0;
+		return;
+	}
+	if(!adaptive.slots)
+		adaptive.slots = std::clamp(conf.max_concurrent_downloads, conf.adaptive_min, conf.adaptive_max);
+
+	unsigned running {0};
+	double total {0};
+	for(auto &pbot : bottoms)
+	{
+		if(pbot.second->index && pbot.second->started())
+		{
+			running++;
+			total += pbot.second->dl_speed;
+		}
+	}
+	if(!running)
+	{
+		adaptive.sum = adaptive.prev_avg = 0;
+		adaptive.samples = adaptive.cooldown = 0;
+		adaptive.last_step = 0;
+		adaptive.prev_errors = adaptive.errors;
+		return;
+	}
+
+	adaptive.sum += total;
+	if(++adaptive.samples < window)
+		return;
+
+	const double avg {adaptive.sum / adaptive.samples};
+	const unsigned errors {adaptive.errors - adaptive.prev_errors}, old_slots {adaptive.slots};
+	adaptive.prev_errors = adaptive.errors;
+	adaptive.sum = adaptive.samples = 0;
+
+	auto rate_str = [](double rate) { return util::format_float(rate / 1048576, 2) + " MB/s"; };
+	std::string reason;
+	if(errors)
+	{
+		if(adaptive.slots > conf.adaptive_min)
+		{
+			adaptive.slots--;
+			reason = std::to_string(errors) + " error(s) (HTTP 403/429 or failed items) during the last " +
+				std::to_string(window) + " seconds";
+		}
+		adaptive.cooldown = cooldown_after_error;
+	}
+	else if(adaptive.cooldown)
+		adaptive.cooldown--;
+	else if(adaptive.last_step > 0 && avg < adaptive.prev_avg * 1.1)
+	{
+		adaptive.slots--;
+		reason = "throughput flattened after adding a slot (" + rate_str(adaptive.prev_avg) + " -> " + rate_str(avg) + ")";
+		adaptive.cooldown = cooldown_after_revert;
+	}
+	else if(running >= adaptive.slots && adaptive.slots < conf.adaptive_max)
+	{
+		adaptive.slots++;
+		reason = adaptive.last_step > 0 ? "throughput is still rising (" + rate_str(adaptive.prev_avg) + " -> " + rate_str(avg) + ")" :
+			"all slots are busy at " + rate_str(avg) + ", probing for more throughput";
+	}
+
+	adaptive.last_step = adaptive.slots > old_slots ? 1 : adaptive.slots < old_slots ? -1 : 0;
+	adaptive.prev_avg = avg;
+
+	if(adaptive.slots != old_slots)
+	{
+		const auto text {"\n[GUI] adaptive concurrency: " + std::to_string(old_slots) + " -> " + std::to_string(adaptive.slots) +
+			" concurrent downloads, " + reason + "\n"};
+		for(auto &pbot : bottoms)
+			if(pbot.second->index && pbot.second->started())
+				outbox.append(pbot.first, text);
+		if(adaptive.slots > old_slots)
+		{
+			auto next_url {next_startable_url(L"")};
+			if(!next_url.empty())
+				on_btn_dl(next_url);
+		}
+	}
+}
+
+bool GUI::info_json_usable(gui_bottom &bottom, const std::wstring &args, std::string &reason)
+{
+	using namespace std::chrono;
+
+	if(bottom.is_ytplaylist || bottom.is_ytchan || bottom.is_bcplaylist || bottom.is_bcchan || bottom.vidinfo.empty())
+		return false;
+	if(bottom.vidinfo_contains("is_live") && bottom.vidinfo["is_live"] ||
+		bottom.vidinfo_contains("live_status") && bottom.vidinfo["live_status"] != "not_live" && bottom.vidinfo["live_status"] != "was_live")
+	{
+		reason = "live or upcoming stream";
+		return false;
+	}
+
+	const auto age {duration_cast<minutes>(system_clock::now() - bottom.vidinfo_time).count()};
+	if(age >= 30)
+	{
+		reason = "the media info is " + std::to_string(age) + " minutes old";
+		return false;
+	}
+
+	if(bottom.vidinfo_proxy != (conf.cb_proxy ? conf.proxy : L""))
+	{
+		reason = "the proxy setting has changed since the media info was extracted";
+		return false;
+	}
+
+	// options that change what the extractor sees (identity, location, request headers)
+	static const std::vector<std::wstring> extraction_args {L"--cookies", L"--username", L"--password", L"-u ", L"-p ", L"--netrc",
+		L"--video-password", L"--extractor-args", L"--proxy", L"--geo-", L"--xff", L"--user-agent", L"--referer", L"--add-header",
+		L"--impersonate", L"--source-address", L"--force-ipv", L"-4 ", L"-6 ", L"--ap-", L"--client-certificate", L"--compat-options",
+		L"--load-info-json", L"-a ", L"--batch-file", L"--ignore-config", L"--config-location"};
+	for(const auto &arg : extraction_args)
+		if(args.find(arg) != -1)
+		{
+			reason = "the custom arguments contain " + std::string {arg.begin(), arg.end()};
+			while(reason.back() == ' ') reason.pop_back();
+			return false;
+		}
+
+	if(bottom.vidinfo_expire)
+	{
+		const auto left {bottom.vidinfo_expire - duration_cast<seconds>(system_clock::now().time_since_epoch()).count()};
+		if(left < 600)
+		{
+			reason = left > 0 ? "the format URLs expire in " + std::to_string(left) + " seconds" : "the format URLs have expired";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool GUI::library_lookup(gui_bottom &bottom)
+{
+	using nana::to_utf8;
+
+	if(bottom.is_ytplaylist || bottom.is_ytchan || bottom.is_bcplaylist || bottom.is_bcchan)
+		return false;
+	auto rec {library.find_url(to_utf8(bottom.url))};
+	if(!rec)
+		if(auto id {media_library::youtube_id(bottom.url)}; !id.empty())
+			rec = library.find_id("Youtube", id);
+	if(!rec)
+		return false;
+	std::error_code ec;
+	const auto file {fs::u8path(rec->path)};
+	if(!fs::is_regular_file(file, ec))
+		return false; // moved or deleted since, so it's new again
+
+	bottom.from_library = true;
+	bottom.printed_path = file;
+	bottom.site(rec->website);
+	if(auto pqi {queue_items.find(bottom.url)})
+	{
+		pqi->website = rec->website.empty() ? "---" : rec->website;
+		pqi->title = rec->title.empty() ? to_utf8(file.filename().wstring()) : rec->title;
+		pqi->format = pqi->format_note = "---";
+		pqi->ext = file.has_extension() ? file.extension().string().substr(1) : "---";
+		pqi->filesize = util::int_to_filesize(rec->size, false);
+		pqi->size = rec->size;
+		pqi->state = queue_model::status::done;
+		pqi->progress.clear();
+		lbq_update(bottom.url);
+	}
+	fetch_favicon(bottom.url);
+
+	std::stringstream date;
+	time_t t {rec->time};
+	tm tm_local {};
+	localtime_s(&tm_local, &t);
+	date << std::put_time(&tm_local, "%Y-%m-%d %H:%M");
+	outbox.caption("[GUI] already downloaded on " + date.str() + " to:\n" + rec->path + "\n\nThis was found in the media library, so "
+		"yt-dlp wasn't run to extract the media info. Choose \"Get media info\" from the queue's context menu to extract it "
+		"anyway, for example to download the item again.\n", bottom.url);
+	return true;
+}
+
+
+void GUI::library_add(gui_bottom &bottom)
+{
+	using nana::to_utf8;
+
+	if(bottom.is_ytplaylist || bottom.is_ytchan || bottom.is_bcplaylist || bottom.is_bcchan || bottom.vidinfo.empty())
+		return; // a playlist is a folder of files, which yt-dlp's own --download-archive keeps track of
+	const auto file {bottom.file_path()};
+	std::error_code ec;
+	if(file.empty() || !fs::is_regular_file(file, ec))
+		return;
+	auto str = [&](const char *key)
+	{
+		return bottom.vidinfo_contains(key) && bottom.vidinfo[key].is_string() ? bottom.vidinfo[key].get<std::string>() : "";
+	};
+	media_library::record_t rec;
+	rec.extractor = str("extractor_key");
+	rec.id = str("id");
+	rec.url = to_utf8(bottom.url);
+	rec.title = str("title");
+	rec.website = bottom.site();
+	rec.path = to_utf8(file.wstring());
+	rec.size = fs::file_size(file, ec);
+	if(ec) rec.size = 0;
+	if(library.find_path(file, rec.size) && library.find_id(rec.extractor, rec.id))
+		return; // nothing new
+	rec.time = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	library.add(std::move(rec));
+}
+
+
+bool GUI::sync_playlist(gui_bottom &bottom, const std::wstring &options)
+{
+	/* Channel tabs list the newest entries first, so the entries added since the last sync are the ones before the
+	   first entry that's already known. They're requested in pages that grow 5x, starting small, which makes the
+	   usual case (a few new videos) a single request for the first page. Playlists that report their size are only
+	   trusted if the new entries account for the whole difference; if the list changed some other way (entries
+	   removed, added at the end, reordered), the caller fetches it whole. */
+
+	if(!conf.cb_playlist_sync)
+		return false;
+	const auto &url {bottom.url};
+	auto cached {playlists.load(url)};
+	if(cached.is_null() || cached["entries"].empty())
+		return false;
+	std::unordered_set<std::string> known;
+	for(const auto &entry : cached["entries"])
+		if(entry.contains("id") && entry["id"].is_string())
+			known.insert(entry["id"].get<std::string>());
+	if(known.empty())
+		return false;
+
+	nlohmann::json info, fresh = nlohmann::json::array();
+	size_t first {1}, page {20};
+	bool found_known {false};
+	int requests {0};
+	while(!found_known && bottom.working_info)
+	{
+		std::wstring cmd {L" --no-warnings --flat-playlist -J -I " + std::to_wstring(first) + L':' +
+			std::to_wstring(first + page - 1) + options + L" \"" + url + L'\"'};
+		if(conf.cb_proxy && !conf.proxy.empty())
+			cmd = L" --proxy " + conf.proxy + cmd;
+		auto media_info {util::run_piped_process(L'\"' + conf.ytdlp_path.wstring() + L'\"' + cmd, &bottom.working_info)};
+		requests++;
+		auto pos {media_info.find('{')};
+		if(pos == -1)
+			return false;
+		info = nlohmann::json::parse(media_info.substr(pos), nullptr, false);
+		if(info.is_discarded() || !info.contains("entries") || !info["entries"].is_array())
+			return false;
+		auto &entries {info["entries"]};
+		for(auto &entry : entries)
+		{
+			if(entry.contains("id") && entry["id"].is_string() && known.contains(entry["id"].get<std::string>()))
+			{
+				found_known = true;
+				break;
+			}
+			fresh.push_back(std::move(entry));
+		}
+		if(entries.size() < page)
+			break; // the end of the list
+		first += page;
+		page *= 5;
+	}
+	if(!bottom.working_info)
+		return false;
+
+	auto &entries {info["entries"]};
+	entries = fresh;
+	if(found_known)
+		for(auto &entry : cached["entries"])
+			entries.push_back(std::move(entry));
+	// else: none of the known entries is in the list anymore, and the pages fetched above are the whole list
+
+	if(entries.empty() || info.contains("playlist_count") && info["playlist_count"].is_number() && info["playlist_count"] != entries.size())
+		return false;
+	info.erase("requested_entries");
+	info["playlist_count"] = entries.size();
+	bottom.playlist_info = std::move(info);
+	bottom.playlist_new = fresh.size();
+	playlists.save(url, bottom.playlist_info);
+	outbox.append(url, "[GUI] synced the list with its cached copy: " + std::to_string(fresh.size()) + " new entries (" +
+		std::to_string(requests) + (requests == 1 ? " request" : " requests") + "), " +
+		std::to_string(bottom.playlist_info["entries"].size()) + " in total\n");
+	return true;
+}
+
+
+void GUI::fetch_favicon(std::wstring url)
+{
+	auto favicon_url {lbq.favicon_url_from_value(url)};
+	if(!favicon_url.empty())
+	{
+		std::function<void(nana::paint::image &)> cbfn = [favicon_url, url, this](nana::paint::image &img)
+		{
+			ui_update(ui_queue::kind::other, url, [this, url, &img]
+			{
+				auto item {lbq_item(url)};
+				if(item != lbq.at(0).end())
+				{
+					item.value<lbqval_t>().pimg = &img;
+				}
+			});
+		};
+		favicons[favicon_url].add(favicon_url, cbfn, tasks);
+	}
+}
+
+
+nlohmann::json GUI::memory_report()
+{
+	/* estimates of what each queue item holds, by category; "widgets" is the size of the gui_bottom object itself
+	   (the native resources of its widgets show up in the process-wide GDI/USER object counts) */
+	using json = nlohmann::json;
+	json report, &items {report["items"] = json::array()}, &totals {report["totals"]};
+	for(auto key : {"vidinfo", "vidinfo_packed", "formats", "playlist_info", "output", "widgets", "total"})
+		totals[key] = 0;
+
+	for(size_t pos {0}; pos < queue_items.size(); pos++)
+	{
+		const auto url {queue_items.at(pos).url};
+		if(!bottoms.contains(url))
+			continue;
+		auto &bottom {bottoms.at(url)};
+		json jitem;
+		jitem["index"] = std::to_string(pos + 1);
+		jitem["url"] = nana::to_utf8(url);
+		jitem["website"] = bottom.site();
+		jitem["vidinfo"] = util::json_mem_size(bottom.vidinfo);
+		jitem["vidinfo_packed"] = bottom.vidinfo_full.packed_size();
+		jitem["vidinfo_unpacked"] = bottom.vidinfo_full.unpacked_size();
+		jitem["formats"] = bottom.formats.mem_size();
+		jitem["playlist_info"] = util::json_mem_size(bottom.playlist_info);
+		jitem["output"] = outbox.mem_size(url);
+		jitem["widgets"] = sizeof(gui_bottom);
+		jitem["materialized"] = bottom.materialized(); // whether the item's panel (and its native windows) exists yet
+		size_t total {0};
+		for(auto key : {"vidinfo", "vidinfo_packed", "formats", "playlist_info", "output", "widgets"})
+		{
+			const auto val {jitem[key].get<size_t>()};
+			total += val;
+			totals[key] = totals[key].get<size_t>() + val;
+		}
+		jitem["total"] = total;
+		totals["total"] = totals["total"].get<size_t>() + total;
+		items.push_back(std::move(jitem));
+	}
+
+	size_t favicon_bytes {0};
+	for(const auto &[favicon_url, favicon] : favicons)
+		favicon_bytes += favicon.mem_size();
+	report["favicons"] = {{"count", favicons.size()}, {"bytes", favicon_bytes}};
+	report["output_shared"] = outbox.mem_size(L"");
+
+	const auto stats {util::get_process_stats()};
+	report["process"] = {{"working_set", stats.working_set}, {"peak_working_set", stats.peak_working_set},
+		{"private_bytes", stats.private_bytes}, {"threads", stats.threads}, {"handles", stats.handles},
+		{"gdi_objects", stats.gdi_objects}, {"user_objects", stats.user_objects}};
+	for(auto [name, which] : {std::pair {"io", executor::pool::io}, std::pair {"cpu", executor::pool::cpu}})
+	{
+		const auto m {tasks.metrics(which)};
+		report["tasks"][name] = {{"threads", m.threads}, {"queued", m.queued}, {"active", m.active}, {"completed", m.completed}};
+	}
+	const auto ui_stats {ui.stats()};
+	report["ui_updates"] = {{"posted", ui_stats.posted}, {"coalesced", ui_stats.coalesced}, {"applied", ui_stats.applied},
+		{"batches", ui_stats.batches}, {"last_batch", ui_stats.last_batch}, {"max_batch", ui_stats.max_batch},
+		{"avg_latency_ms", ui_stats.applied ? ui_stats.total_latency / 1000.0 / ui_stats.applied : 0.0},
+		{"max_latency_ms", ui_stats.max_latency / 1000.0}};
+	return report;
+}
+
+
+nana::drawerbase::listbox::item_proxy GUI::lbq_item(const std::wstring &url)
+{
+	const auto pos {queue_items.pos(url)};
+	if(pos == -1 || pos >= lbq.at(0).size())
+		return lbq.at(0).end();
+	return lbq.at(0).at(pos);
+}
+
+
+void GUI::lbq_update(const std::wstring &url)
+{
+	if(!on_gui_thread())
+	{
+		ui.post(ui_queue::kind::row, url, [this, url] { lbq_update(url); });
+		return;
+	}
+
+	// the row's text is made from the model when it's drawn (see make_queue_listbox), so it only has to be redrawn;
+	// the updates that are drained together get one redraw
+	if(ui_draining)
+		lbq_dirty = true;
+	else if(lbq_item(url) != lbq.at(0).end())
+		nana::api::refresh_window(lbq);
+}
+
+
+void GUI::ui_update(ui_queue::kind kind, const std::wstring &url, std::function<void()> fn)
+{
+	if(on_gui_thread())
+	{
+		drain_ui(); // the updates the worker threads posted before this one go first
+		fn();
+	}
+	else ui.post(kind, url, std::move(fn));
+}
+
+
+void GUI::drain_ui()
+{
+	// the listbox is redrawn once for the whole batch, instead of once for each cell that's written
+	if(ui_draining || !ui.pending())
+		return;
+	trace::span span {"UI updates"};
+	ui_draining = true;
+	lbq.auto_draw(false);
+	ui.drain();
+	lbq.auto_draw(true);
+	if(std::exchange(lbq_dirty, false))
+		nana::api::refresh_window(lbq);
+	ui_draining = false;
+}
+
+
+void GUI::item_caption(const std::wstring &url)
+{
+	// only the displayed item has the widget, so the captions of the others are made when they're shown (see
+	// gui_bottoms::show), instead of being rewritten whenever items are removed or moved
+	const auto pos {queue_items.pos(url)};
+	if(pos == -1 || !bottoms.contains(url))
+		return;
+	const std::string cap {"Download options"};
+	bottoms.at(url).options_caption(conf.common_dl_options ? cap : cap + " for queue item #" + std::to_string(pos + 1));
+}
+
+
+void GUI::stage_changed(const std::wstring &url, int stage)
+{
+	trace::span span {"stage change", url};
+	if(!queue_items.find(url))
+		return;
+	switch(stage)
+	{
+	case YTDLP_POSTPROCESS:
+		if(!bottoms.at(url).started())
+			return;
+		if(queue_items.find(url)->state != queue_model::status::processing)
+		{
+			queue_status(url, queue_model::status::processing);
+			// the item has moved on to the post-processing pool, so its download slot may be free for the next item;
+			// not so for a playlist, which goes back to downloading with its next video (see network_load)
+			if(conf.cb_lengthyproc && !bottoms.at(url).multi_video())
+				hand_off_slot(url);
+		}
+		break;
+
+	case YTDLP_DOWNLOAD:
+		queue_status(url, queue_model::status::downloading);
+		if(auto &bottom {bottoms.at(url)}; bottom.handoff_at.time_since_epoch().count())
+		{
+			/* the handoff latency is the time from the freeing of a download slot to the start of the download of the
+			   item that was started in it, which is what prefetching is meant to shorten: without prefetched info,
+			   yt-dlp has to extract the media info first */
+			using namespace std::chrono;
+			const auto secs {duration<double> {steady_clock::now() - bottom.handoff_at}.count()};
+			bottom.handoff_at = {};
+			auto &stats {bottom.handoff_prefetched ? prefetch.with : prefetch.without};
+			stats.count++;
+			stats.secs += secs;
+			auto average = [](const auto &stats, std::string what)
+			{
+				if(!stats.count)
+					return "no handoffs " + what;
+				return util::format_float(stats.secs / stats.count, 1) + " seconds over " + std::to_string(stats.count) +
+					" handoffs " + what;
+			};
+			outbox.append(url, "[GUI] the download started " + util::format_float(secs, 1) + " seconds after its slot was "
+				"freed; average handoff latency: " + average(prefetch.with, "with prefetched info") + ", " +
+				average(prefetch.without, "without") + "\n");
+		}
+		break;
+	}
+}
+
+
+void GUI::queue_status(const std::wstring &url, queue_model::status status, std::string progress)
+{
+	auto pqi {queue_items.find(url)};
+	if(!pqi)
+		return;
+	if(status == queue_model::status::stopped)
+		pqi->stop();
+	else
+	{
+		if(status == queue_model::status::started)
+			pqi->file_base = pqi->file_size = 0; // yt-dlp goes through the files again, resuming the partial ones
+		pqi->state = status;
+		pqi->progress = std::move(progress);
+	}
+	if(!pqi->running())
+		pqi->speed = 0;
+	lbq_update(url); // the row is redrawn by the GUI thread, from the model as it is then
+}
+
+
 bool GUI::lbq_has_scrollbar()
 {
 	nana::paint::graphics g {{100, 100}};
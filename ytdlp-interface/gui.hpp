@@ -1,6 +1,7 @@
 #pragma once
 
 #include <thread>
+#include <atomic>
 #include <sstream>
 #include <algorithm>
 #include <unordered_set>
@@ -12,6 +13,11 @@
 #include "widgets.hpp"
 #include "themed_form.hpp"
 #include "types.hpp"
+#include "bandwidth.hpp"
+#include "library.hpp"
+#include "trace.hpp"
+#include "executor.hpp"
+#include "ui_queue.hpp"
 
 #undef min
 #undef max
@@ -37,17 +43,21 @@ public:
 		std::vector<std::string> argsets, unfinished_queue_items;
 		std::unordered_set<std::wstring> outpaths;
 		std::map<std::wstring, std::string> playsel_strings;
-		double ratelim {0}, contrast {.1};
-		unsigned ratelim_unit {1}, pref_res {0}, pref_video {0}, pref_audio {0}, cbtheme {2}, max_argsets {10}, max_outpaths {10}, 
-			max_concurrent_downloads {1}, output_buffer_size {30000}, pref_vcodec {0}, pref_acodec {0};
-		std::chrono::milliseconds max_proc_dur {3000};
+		std::map<std::string, unsigned> domain_caps; // per-website overrides of domain_max (only in the settings file)
+		double ratelim {0}, contrast {.1}, ratelim_global {0};
+		unsigned ratelim_unit {1}, ratelim_global_unit {1}, pref_res {0}, pref_video {0}, pref_audio {0}, cbtheme {2}, max_argsets {10}, max_outpaths {10}, 
+			max_concurrent_downloads {1}, output_buffer_size {30000}, pref_vcodec {0}, pref_acodec {0}, adaptive_min {1}, adaptive_max {6},
+			domain_max {2}, domain_spacing {0}, fragment_budget {16}, prefetch_depth {2};
 		bool cbsplit {false}, cbchaps {false}, cbsubs {false}, cbthumb {false}, cbtime {true}, cbkeyframes {false}, cbmp3 {false},
 			cbargs {false}, kwhilite {true}, pref_fps {false}, cb_lengthyproc {true}, common_dl_options {true}, cb_autostart {true},
 			cb_queue_autostart {false}, gpopt_hidden {false}, open_dialog_origin {false}, cb_zeropadding {true}, cb_playlist_folder {true},
 			zoomed {false}, get_releases_at_startup {false}, col_format {false}, col_format_note {true}, col_ext {true}, col_fsize {false},
 			json_hide_null {false}, col_site_icon {true}, col_site_text {false}, ytdlp_nightly {false}, audio_multistreams {false},
 			cb_sblock_mark {false}, cb_sblock_remove {false}, cb_proxy {false}, cbsnap {true}, limit_output_buffer {true}, 
-			update_self_only {true}, cb_premium {true}, cbminw {false}, cb_save_errors {false}, cb_ffplay {false};
+			update_self_only {true}, cb_premium {true}, cbminw {false}, cb_save_errors {false}, cb_ffplay {false},
+			cb_ratelim_global {false}, cb_adaptive_concurrency {false}, cb_domain_limits {false}, cb_load_info_json {false},
+			cb_playlist_sync {true}, cb_lowprio {false}, cb_auto_fragments {true},
+			cb_playlist_shards {false};
 		nana::rectangle winrect;
 		int dpi {96};
 		std::vector<int> sblock_mark, sblock_remove;
@@ -55,6 +65,8 @@ public:
 	}
 	conf;
 
+	static media_library library; // finished downloads, opened by main() next to the settings file
+	static playlist_cache playlists; // the entries of the playlists and channel tabs last seen, for sync_playlist
 	fs::path confpath;
 	std::function<bool()> fn_write_conf;
 
@@ -62,15 +74,45 @@ private:
 
 	nlohmann::json releases;
 	fs::path self_path, appdir, ffmpeg_loc;
-	std::string inet_error, url_latest_ffmpeg, url_latest_ytdlp, url_latest_ytdlp_relnotes;
+	std::string inet_error, url_latest_ffmpeg, url_latest_ytdlp, url_latest_ytdlp_relnotes, sha256_latest_ffmpeg, sha256_latest_ytdlp;
 	std::wstring drop_cliptext_temp;
 	std::wstringstream multiple_url_text;
 	long minw {0}, minh {0}; // min frame size
-	unsigned size_latest_ffmpeg {0}, size_latest_ytdlp {0}, number_of_processors {4};
-	bool menu_working {false}, lbq_no_action {false}, thumbthr_working {false}, 
+	unsigned size_latest_ffmpeg {0}, size_latest_ytdlp {0};
+	bool menu_working {false}, lbq_no_action {false}, 
 		autostart_next_item {true}, lbq_can_drag {false}, cnlang {false}, no_draw_freeze {true};
-	std::thread thr, thr_releases, thr_versions, thr_thumb, thr_menu, thr_releases_ffmpeg, thr_releases_ytdlp, thr_update;
+	// background jobs on the I/O pool of GUI::tasks (see the unload handler)
+	executor::task<void> update_task, releases_task, versions_ffmpeg_task, versions_ytdlp_task, thumb_task, menu_task,
+		releases_ffmpeg_task, releases_ytdlp_task;
 	CComPtr<ITaskbarList3> i_taskbar;
+	bandwidth_proxy bwproxy;
+
+	struct // state of the adaptive concurrency controller
+	{
+		unsigned slots {0}, samples {0}, cooldown {0}, prev_errors {0};
+		double sum {0}, prev_avg {0};
+		int last_step {0}; // 1 = added a slot at the end of the previous window, -1 = dropped one
+		std::atomic<unsigned> errors {0}; // 403/429 responses and failed items, counted by the download threads
+		nana::timer timer;
+	} adaptive;
+
+	std::map<std::string, std::chrono::steady_clock::time_point> domain_last_start;
+	nana::timer domain_timer; // retries starting an item when the only startable ones had to wait for domain_spacing
+	std::chrono::steady_clock::time_point domain_timer_due;
+	std::string queue_totals_text; // remaining bytes and ETA of the whole queue, as last shown in the queue header
+
+	struct // refreshes the media info of the next startable items before their turn (see prefetch_tick)
+	{
+		executor::task<void> task;
+		std::wstring url; // of the item being refreshed
+		std::atomic_bool working {false};
+		std::chrono::steady_clock::time_point slot_freed; // set by hand_off_slot, taken by the item it starts
+		struct { unsigned count {0}; double secs {0}; } with, without; // handoff latency, by whether prefetched info was used
+	} prefetch;
+	const DWORD gui_tid {GetCurrentThreadId()}; // the GUI object is made by the thread that runs the message loop
+	nana::timer ui_timer; // drains ui (see drain_ui)
+	bool ui_draining {false};
+	bool lbq_dirty {false}; // a row changed while ui was being drained, to be redrawn after the batch
 	UINT WM_TASKBAR_BUTTON_CREATED {0};
 	const std::string ver_tag {"v2.8.0"}, title {"ytdlp-interface " + ver_tag/*.substr(0, 4)*/},
 		ytdlp_fname {X64 ? "yt-dlp.exe" : "yt-dlp_x86.exe"};
@@ -98,41 +140,115 @@ private:
 	class gui_bottom : public nana::panel<true>
 	{
 		GUI *pgui {nullptr};
+		std::atomic_bool made {false}; // whether view exists, for the threads that update the item
+		mutable std::mutex state_mtx; // the state the setters record (below), written by any thread
+		bool started_ {false}, btndl_enabled {true}, btnfmt_shown {false}, btncopy_shown {false};
+		unsigned prog_amount {1000}, prog_value {0}, prog_shadow {0};
+		std::string prog_caption, gpopt_caption {"Download options"};
+		std::string site_; // website domain, as shown in the queue's website column (written by the info task)
+
+		void make_widgets();
+		template<typename F> bool record(F set) // makes a state change, returns whether there are widgets to show it
+		{
+			std::lock_guard lock {state_mtx};
+			set();
+			return made;
+		}
+
 	public:
-		gui_bottom(GUI &gui, bool visible = false);
+		gui_bottom(GUI &gui);
 
-		bool is_ytlink {false}, use_strfmt {false}, working {false}, graceful_exit {false}, working_info {true}, received_procmsg {false},
+		/* The download options of the item. They are kept here and not read from the widgets, because the widgets of an
+		   item's panel (some 30 native windows) only exist while the item is displayed (see materialize and release). */
+		struct options_t
+		{
+			bool cbsplit {false}, cbkeyframes {false}, cbmp3 {false}, cbchaps {false}, cbsubs {false}, cbthumb {false},
+				cbtime {false}, cbargs {false};
+			std::string argset, ratelim; // captions of the custom arguments combobox and of the rate limit textbox
+			unsigned ratelim_unit {0};
+		} opts;
+
+		std::atomic_bool working {false}, working_info {true};
+		bool is_ytlink {false}, use_strfmt {false}, graceful_exit {false},
 			is_ytplaylist {false}, is_ytchan {false}, is_bcplaylist {false}, is_bclink {false}, is_bcchan {false}, is_yttab {false};
+		bool from_library {false}; // found in the media library when it was queued, so its info wasn't extracted
 		fs::path outpath, merger_path, download_path, printed_path;
-		nlohmann::json vidinfo, playlist_info;
+		nlohmann::json vidinfo, playlist_info; // vidinfo: only the fields the GUI reads (see store_vidinfo)
+		packed_text vidinfo_full; // the whole info dict, as printed by yt-dlp
+		format_table formats; // the "formats" of the info dict, parsed once per extraction
+		long long vidinfo_expire {0}; // earliest expiry time (Unix) of the signed URLs in the info dict, 0 if none
 		std::vector<bool> playlist_selection;
 		std::vector<std::pair<std::wstring, std::wstring>> sections;
 		std::wstring url, strfmt, fmt1, fmt2, playsel_string, cmdinfo, playlist_vid_cmdinfo;
-		std::thread dl_thread, info_thread;
+		std::thread dl_thread;
+		executor::task<void> info_task; // extraction of the media info, on the I/O pool of GUI::tasks
 		int index {0};
-
-		widgets::Group gpopt;
-		nana::place plc;
-		nana::place plcopt;
-		nana::timer timer_proc;
-		widgets::Textbox tbrate;
-		widgets::Progress prog;
-		widgets::Button btn_ytfmtlist, btndl, btnerase, btnq, btncopy;
-		widgets::Label l_out, l_rate;
-		widgets::path_label l_outpath;
-		widgets::Combox com_rate, com_args;
-		widgets::cbox cbsplit, cbkeyframes, cbmp3, cbchaps, cbsubs, cbthumb, cbtime, cbargs;
-		widgets::Separator separator;
-		widgets::Expcol expcol;
-
+		int playlist_new {-1}; // how many entries at the start of playlist_info are new since the last sync, -1 if not synced
+		std::atomic<double> dl_speed {0}; // bytes/s, from the last progress line (written by the download thread)
+		unsigned fragments {0}; // the --concurrent-fragments value the item was started with, 0 if it wasn't used
+		std::atomic<unsigned> shards {0}; // yt-dlp processes of a sharded playlist that are still running
+		std::chrono::system_clock::time_point vidinfo_time; // when vidinfo was extracted
+		double vidinfo_secs {0}; // how long the extraction of vidinfo took
+		bool prefetched {false}; // vidinfo was refreshed by the prefetcher
+		bool handoff_prefetched {false}; // the item was last started from prefetched info
+		std::chrono::steady_clock::time_point handoff_at; // when the slot the item was started in was freed (zero if it wasn't)
+		std::chrono::steady_clock::time_point prefetch_time; // of the last refresh attempt
+		long long queued_at {0}; // trace::now() when the item was queued or stopped, for the "queued" span of the timeline
+		std::wstring vidinfo_proxy; // the proxy vidinfo was extracted through (empty if none)
+		fs::path predicted_path; // output file predicted from the output template (see predict_path)
+		std::string predicted_key; // the inputs predicted_path was computed from
+
+		struct view_t // the widgets of the panel; only the displayed item has them (see materialize and release)
+		{
+			widgets::Group gpopt;
+			nana::place plc;
+			nana::place plcopt;
+			widgets::Textbox tbrate;
+			widgets::Progress prog;
+			widgets::Button btn_ytfmtlist, btndl, btnerase, btnq, btncopy;
+			widgets::Label l_out, l_rate;
+			widgets::path_label l_outpath;
+			widgets::Combox com_rate, com_args;
+			widgets::cbox cbsplit, cbkeyframes, cbmp3, cbchaps, cbsubs, cbthumb, cbtime, cbargs;
+			widgets::Separator separator;
+			widgets::Expcol expcol;
+		};
+		std::unique_ptr<view_t> view; // GUI thread only
+
+		void materialize(); // makes the widgets of the panel, if they haven't been made yet
+		void release(); // destroys the widgets of the panel if it's hidden, keeping the state they show
+		bool materialized() const { return made; }
+		void refresh_btndl(); // redraws the start/stop button, if it exists
+		void load_options(); // updates the widgets from opts
+		void reload_argsets(); // refills the custom arguments combobox from conf.argsets
 		void show_btncopy(bool show);
 		void show_btnfmt(bool show);
-		bool btnfmt_visible() { return plc.field_visible("btn_ytfmtlist"); }
+		bool btnfmt_visible() const { std::lock_guard lock {state_mtx}; return btnfmt_shown; }
+		bool btncopy_visible() const { std::lock_guard lock {state_mtx}; return btncopy_shown; }
 		fs::path file_path();
-		bool started() { return btndl.caption().starts_with("Stop"); }
-		bool using_custom_fmt() { return cbargs.checked() && com_args.caption_wstring().find(L"-f ") != -1; }
+		fs::path predict_path();
+		std::string predicted_ext();
+		bool started() const { std::lock_guard lock {state_mtx}; return started_; }
+		void started(bool started);
+		void enable_btndl(bool enable);
+		void options_caption(std::string text);
+		void progress_amount(unsigned amount);
+		void progress_value(unsigned value);
+		unsigned progress_value() const { std::lock_guard lock {state_mtx}; return prog_value; }
+		void progress_shadow(unsigned value); // per mille
+		void progress_caption(std::string text);
+		bool using_custom_fmt() { return opts.cbargs && opts.argset.find("-f ") != -1; }
 		int playlist_selected();
 		bool vidinfo_contains(std::string key);
+		void store_vidinfo(); // call after a new info dict is parsed into vidinfo
+		void clear_vidinfo();
+		void stop_info() { working_info = false; info_task.cancel(); info_task.wait(); } // waits for the extraction to end
+		bool fragmented(); // whether the format(s) to be downloaded come in fragments (HLS, DASH)
+		bool multi_video() const { return is_ytplaylist || is_ytchan || is_bcplaylist || is_bcchan; } // playlist or channel
+		nlohmann::json full_vidinfo(); // rehydrates vidinfo_full
+		std::string site() const { std::lock_guard lock {state_mtx}; return site_; }
+		void site(std::string name) { std::lock_guard lock {state_mtx}; site_ = std::move(name); }
+		std::string domain_key(); // the site, or the host of the URL before it's known, under one name per website
 		void apply_playsel_string();
 	};
 
@@ -174,8 +290,7 @@ private:
 		std::map<std::wstring, std::string> buffers {{L"", ""}};
 		std::map<std::wstring, std::string> commands;
 		std::wstring current_;
-		std::thread thr;
-		bool working {false};
+		executor::task<void> flash; // flashes the background when the text is copied to the clipboard
 		GUI *pgui {nullptr};
 
 	public:
@@ -189,11 +304,8 @@ private:
 
 		~Outbox()
 		{
-			if(thr.joinable())
-			{
-				working = false;
-				thr.join();
-			}
+			flash.cancel();
+			flash.wait();
 		}
 
 		void create(GUI *parent, bool visible = true);
@@ -206,6 +318,7 @@ private:
 		void current(std::wstring url) { current_ = url; }
 		auto current() { return current_; }
 		void clear(std::wstring url = L"");
+		size_t mem_size(std::wstring url) const; // capacity of the output buffer and command line of the URL
 
 		void append(std::wstring url, std::wstring text)
 		{
@@ -221,14 +334,19 @@ private:
 
 	gui_bottoms bottoms {this};
 	Outbox outbox {this};
+	ui_queue ui {[this](const std::wstring &url, std::string text) { outbox.append(url, std::move(text)); }};
 	widgets::Overlay overlay {*this, &outbox};
 	nana::panel<false> queue_panel {*this};
 	nana::place plc_queue {queue_panel};
 	widgets::Listbox lbq {queue_panel};
+	using lbq_rows = std::vector<std::shared_ptr<queue_model::item_t>>; // the model of lbq (see make_queue_listbox)
+	queue_model queue_items; // what lbq shows
 	widgets::Button btn_qact {queue_panel, "Queue actions", true}, btn_settings {queue_panel, "Settings", true};
 	std::wstring qurl;
 	widgets::path_label l_url {queue_panel, &qurl};
 	std::unordered_map<std::string, favicon_t> favicons;
+	// declared after the queue items, so that it's destroyed (shut down) before them, as its tasks refer to them
+	executor tasks {std::max(4u, std::thread::hardware_concurrency()), std::max(1u, std::thread::hardware_concurrency() / 2)};
 
 	widgets::conf_page updater;	
 	widgets::Label l_ver, l_ver_ytdlp, l_ver_ffmpeg, l_channel;
@@ -254,6 +372,7 @@ private:
 	void fm_sections();
 	void fm_playlist();
 	void fm_formats();
+	void fm_memory();
 
 	void queue_remove_all();
 	void queue_remove_selected();
@@ -267,6 +386,7 @@ private:
 	void get_releases();
 	void get_latest_ffmpeg();
 	void get_latest_ytdlp();
+	std::string asset_sha256(const nlohmann::json &assets, std::string fname, std::string sums_name = "", std::stop_token stop = {});
 	void get_versions();
 	void get_version_ytdlp();
 	bool is_ytlink(std::wstring url);
@@ -278,9 +398,36 @@ private:
 	void show_output();
 	void add_url(std::wstring url, bool refresh = false);
 	void taskbar_overall_progress();
+	void update_queue_totals(); // remaining bytes and ETA of the queue, in the header of the title column and the taskbar
 	void on_btn_dl(std::wstring url);
 	void remove_queue_item(std::wstring url);
 	std::wstring next_startable_url(std::wstring current_url = L"current");
+	void hand_off_slot(const std::wstring &url); // starts the next startable item after url in the slot url has freed
+	unsigned max_concurrent();
+	unsigned postproc_slots(); // size of the post-processing pool (see network_load)
+	unsigned network_load(); // how many of the download slots are taken
+	unsigned ffmpeg_threads(); // the -threads value for the ffmpeg of an item that's being started (an estimate)
+	void prefetch_tick();
+	void stop_prefetch(const std::wstring &url); // empty url: whatever item is being refreshed
+	std::vector<std::wstring> playlist_shards(gui_bottom &bottom); // the selection split for parallel processes
+	unsigned concurrent_fragments(const std::wstring &url); // the -N value for an item that's being started
+	bool domain_allows(const std::string &domain, const std::map<std::string, unsigned> &running);
+	std::map<std::string, unsigned> running_per_domain();
+	void adaptive_concurrency_tick();
+	bool info_json_usable(gui_bottom &bottom, const std::wstring &args, std::string &reason);
+	nlohmann::json memory_report();
+	bool library_lookup(gui_bottom &bottom); // fills in a new queue item from the media library, if it's in there
+	void library_add(gui_bottom &bottom); // records the item's downloaded file in the media library
+	void fetch_favicon(std::wstring url);
+	bool sync_playlist(gui_bottom &bottom, const std::wstring &options); // updates the cached entries with the new ones
+	nana::drawerbase::listbox::item_proxy lbq_item(const std::wstring &url); // the row of a queue item, or lbq.at(0).end()
+	void lbq_update(const std::wstring &url); // redraws the item's row, whose text is made from queue_items
+	bool on_gui_thread() const { return GetCurrentThreadId() == gui_tid; }
+	void ui_update(ui_queue::kind kind, const std::wstring &url, std::function<void()> fn); // now, or posted to ui
+	void drain_ui(); // makes the widget updates the worker threads posted, in one batch
+	void item_caption(const std::wstring &url); // sets the options caption of the item's panel, with its number
+	void queue_status(const std::wstring &url, queue_model::status status, std::string progress = "");
+	void stage_changed(const std::wstring &url, int stage); // YTDLP_DOWNLOAD or YTDLP_POSTPROCESS, posted by the download thread
 	bool lbq_has_scrollbar();
 	void adjust_lbq_headers();
 	void write_settings() { events().unload.emit({}, *this); }
@@ -1,212 +1,404 @@
 #include "gui.hpp"
+#include "outtmpl.hpp"
 #include <nana/gui/filebox.hpp>
 
 void GUI::gui_bottom::show_btncopy(bool show)
 {
-	plc.field_display("btncopy", show);
-	plc.field_display("btncopy_spacer", show);
-	plc.collocate();
+	if(!record([&] { btncopy_shown = show; })) return;
+	pgui->ui_update(ui_queue::kind::other, url, [this, show]
+	{
+		if(!view) return;
+		view->plc.field_display("btncopy", show);
+		view->plc.field_display("btncopy_spacer", show);
+		view->plc.collocate();
+	});
 }
 
 
 void GUI::gui_bottom::show_btnfmt(bool show)
 {
-	plc.field_display("btn_ytfmtlist", show);
-	plc.field_display("ytfm_spacer", show);
-	plc.collocate();
-	pgui->get_place().collocate();
-	nana::api::update_window(*pgui);
+	if(!record([&] { btnfmt_shown = show; })) return;
+	pgui->ui_update(ui_queue::kind::other, url, [this, show]
+	{
+		if(!view) return;
+		view->plc.field_display("btn_ytfmtlist", show);
+		view->plc.field_display("ytfm_spacer", show);
+		view->plc.collocate();
+		pgui->get_place().collocate();
+		nana::api::update_window(*pgui);
+	});
 }
 
+
+void GUI::gui_bottom::started(bool started)
+{
+	if(!record([&] { started_ = started; })) return;
+	pgui->ui_update(ui_queue::kind::other, url, [this, started]
+	{
+		if(!view) return;
+		view->btndl.caption(started ? "Stop download" : "Start download");
+		view->btndl.cancel_mode(started);
+	});
+}
+
+
+void GUI::gui_bottom::enable_btndl(bool enable)
+{
+	if(record([&] { btndl_enabled = enable; }))
+		pgui->ui_update(ui_queue::kind::other, url, [this, enable] { if(view) view->btndl.enabled(enable); });
+}
+
+
+void GUI::gui_bottom::options_caption(std::string text)
+{
+	if(!record([&] { gpopt_caption = text; })) return;
+	pgui->ui_update(ui_queue::kind::other, url, [this, text]
+	{
+		if(!view) return;
+		view->gpopt.caption(text);
+		nana::api::refresh_window(view->gpopt);
+	});
+}
+
+
+void GUI::gui_bottom::progress_amount(unsigned amount)
+{
+	if(record([&] { prog_amount = amount; }))
+		pgui->ui_update(ui_queue::kind::progress_amount, url, [this, amount] { if(view) view->prog.amount(amount); });
+}
+
+
+void GUI::gui_bottom::progress_value(unsigned value)
+{
+	if(record([&] { prog_value = value; }))
+		pgui->ui_update(ui_queue::kind::progress_value, url, [this, value] { if(view) view->prog.value(value); });
+}
+
+
+void GUI::gui_bottom::progress_shadow(unsigned value)
+{
+	if(record([&] { prog_shadow = value; }))
+		pgui->ui_update(ui_queue::kind::progress_shadow, url, [this, value] { if(view) view->prog.shadow_progress(1000, value); });
+}
+
+
+void GUI::gui_bottom::progress_caption(std::string text)
+{
+	if(record([&] { prog_caption = text; }))
+		pgui->ui_update(ui_queue::kind::progress_caption, url, [this, text] { if(view) view->prog.caption(text); });
+}
+
+
 fs::path GUI::gui_bottom::file_path()
 {
+	// the path printed by yt-dlp after the download is the real one; before that, the path is predicted from the output
+	// template (once per set of inputs), so that this costs a single stat either way
+	fs::path file;
 	if(!printed_path.empty())
 	{
-		if(printed_path.extension().string() != "NA")
+		file = printed_path;
+		if(file.extension().string() == "NA" && !merger_path.empty())
+			file.replace_extension(merger_path.extension());
+	}
+	else file = predict_path();
+	if(file.empty())
+		file = !merger_path.empty() ? merger_path : download_path;
+	if(!file.empty() && fs::exists(file))
+		return file;
+	return {};
+}
+
+
+std::string GUI::gui_bottom::predicted_ext()
+{
+	using nana::to_utf8;
+
+	if(using_custom_fmt())
+	{
+		// only a numeric format ID in the custom arguments can be resolved here
+		const auto &args {opts.argset};
+		auto pos {args.find("-f ") + 2};
+		while(pos < args.size() && isspace(args[pos]))
+			pos++;
+		std::string num;
+		while(pos < args.size() && isdigit(args[pos]))
+			num += args[pos++];
+		if(auto fmt {formats.find(num)}; fmt && !num.empty())
+			return fmt->ext;
+		return "";
+	}
+	if(use_strfmt && !formats.empty())
+	{
+		std::string ext1, ext2;
+		auto vcodec {format_t::codec::unknown};
+		if(auto fmt {formats.find(to_utf8(fmt1))})
 		{
-			if(fs::exists(printed_path))
-				return printed_path;
+			ext1 = fmt->ext;
+			if(fmt->vcodec != format_t::codec::none)
+				vcodec = fmt->vcodec;
 		}
-		if(!merger_path.empty())
+		if(auto fmt {fmt2.empty() ? nullptr : formats.find(to_utf8(fmt2))})
 		{
-			printed_path.replace_extension(merger_path.extension());
-			if(fs::exists(printed_path))
-				return printed_path;
-			if(!download_path.empty())
-			{
-				printed_path.replace_extension(download_path.extension());
-				if(fs::exists(printed_path))
-					return printed_path;
-			}
-			if(vidinfo_contains("ext"))
-			{
-				std::string ext {vidinfo["ext"]};
-				printed_path.replace_extension(ext);
-				if(fs::exists(printed_path))
-					return printed_path;
-			}
+			ext2 = fmt->ext;
+			if(fmt->vcodec != format_t::codec::none)
+				vcodec = fmt->vcodec;
 		}
+		if(ext2.empty())
+			return ext1;
+		if(ext2 == "webm")
+			return (ext1 == "webm" || ext1 == "weba") ? "webm" : "mkv";
+		if(ext1 == "webm" || ext1 == "weba")
+			return vcodec == format_t::codec::av1 ? "webm" : "mkv";
+		return "mp4";
 	}
+	if(vidinfo_contains("ext"))
+		return vidinfo["ext"];
+	return "";
+}
 
-	if(!merger_path.empty() && fs::exists(merger_path))
-		return merger_path;
-	if(!download_path.empty() && fs::exists(download_path))
-		return download_path;
 
-	fs::path file;
-	if(vidinfo_contains("filename"))
-		file = fs::u8path(std::string {vidinfo["filename"]});
+fs::path GUI::gui_bottom::predict_path()
+{
+	using nana::to_utf8;
+	auto &conf {GUI::conf};
+
+	if(vidinfo.empty() || is_ytplaylist || is_ytchan || is_bcplaylist || is_bcchan || sections.size() > 1)
+		return {};
 
-	if(!file.empty())
+	const auto args {opts.cbargs ? opts.argset : std::string {}};
+	auto key {to_utf8(outpath.wstring()) + '\n' + args + '\n' + to_utf8(conf.output_template) + '\n' + to_utf8(fmt1) + '\n' +
+		to_utf8(fmt2) + '\n' + std::to_string(use_strfmt) + std::to_string(opts.cbmp3) + '\n' +
+		std::to_string(vidinfo_time.time_since_epoch().count())};
+	if(key == predicted_key)
+		return predicted_path;
+	predicted_key = key;
+	predicted_path.clear();
+
+	// the value of an option in the custom arguments, as yt-dlp would parse it (quoted or not)
+	auto arg_value = [&args](std::string opt) -> std::string
 	{
-		file = outpath / file;
-		if(!fs::exists(file))
+		auto pos {args.find(opt)};
+		if(pos == -1 || pos && args[pos - 1] != ' ')
+			return "";
+		pos += opt.size();
+		if(pos < args.size() && args[pos] == '"')
 		{
-			if(cbargs.checked() && com_args.caption().find("-f ") != -1)
-			{
-				auto args {com_args.caption()};
-				auto pos {args.find("-f ")};
-				if(pos != -1)
-				{
-					pos += 1;
-					while(pos < args.size() && isspace(args[++pos]));
-					std::string num;
-					while(pos < args.size())
-					{
-						char c {args[pos++]};
-						if(isdigit(c))
-							num += c;
-						else break;
-					}
-					if(!num.empty())
-					{
-						for(auto &fmt : vidinfo["formats"])
-						{
-							std::string format_id {fmt["format_id"]}, ext {fmt["ext"]};
-							if(format_id == num)
-							{
-								file.replace_extension(ext);
-								break;
-							}
-						}
-						if(!fs::exists(file))
-							file.clear();
-					}
-					else file.clear();
-				}
-				else file.clear();
-			}
-			else if(cbmp3.checked())
-			{
-				file.replace_extension("mp3");
-				if(!fs::exists(file))
-					file.clear();
-			}
-			else if(use_strfmt)
-			{
-				using nana::to_utf8;
-				std::string ext1, ext2, vcodec;
-				for(auto &fmt : vidinfo["formats"])
-				{
-					std::string format_id {fmt["format_id"]}, ext {fmt["ext"]};
-					if(ext1.empty() && format_id == to_utf8(fmt1))
-					{
-						ext1 = to_utf8(ext);
-						if(fmt.contains("vcodec") && fmt["vcodec"] != "none")
-							vcodec = fmt["vcodec"];
-						if(fmt2.empty()) break;
-					}
-					else if(!fmt2.empty() && format_id == to_utf8(fmt2))
-					{
-						ext2 = to_utf8(ext);
-						if(fmt.contains("vcodec") && fmt["vcodec"] != "none")
-							vcodec = fmt["vcodec"];
-						if(!ext1.empty()) break;
-					}
-				}
-				if(ext2.empty())
-					file.replace_extension(ext1);
-				else
-				{
-					std::string ext;
-					if(ext2 == "webm")
-						ext = (ext1 == "webm" || ext1 == "weba") ? "webm" : "mkv";
-					else if(ext1 == "webm" || ext1 == "weba")
-						ext = vcodec.starts_with("av01") ? "webm" : "mkv";
-					else ext = "mp4";
-					file.replace_extension(ext);
-				}
-				if(!fs::exists(file))
-					file.clear();
-			}
-			else file.clear();
+			auto end {args.find('"', ++pos)};
+			return args.substr(pos, end == -1 ? -1 : end - pos);
 		}
+		return args.substr(pos, args.find(' ', pos) - pos);
+	};
+
+	// the same choices process_queue_item makes for single videos
+	std::string tmpl {arg_value("-o ")}, home {arg_value("-P ")};
+	if(tmpl.empty())
+		tmpl = arg_value("--output ");
+	if(tmpl.empty())
+		tmpl = conf.output_template.empty() ? "%(title)s [%(id)s].%(ext)s" : to_utf8(conf.output_template);
+	if(home.empty())
+		home = to_utf8(outpath.wstring());
+	if(home.find(':') > 1 && home.find(':') != -1)
+		return {}; // "-P TYPE:PATH"
+	for(auto opt : {"--restrict-filenames", "--windows-filenames", "--trim-filenames", "--output-na-placeholder",
+		"filename-sanitization", "--paths", "--autonumber-start", "-x ", "--extract-audio", "--remux-video",
+		"--recode-video", "--merge-output-format", "--split-chapters"})
+		if(args.find(opt) != -1)
+			return {};
+
+	auto ext {predicted_ext()};
+	if(ext.empty())
+		return {};
+	nlohmann::json overrides;
+	overrides["ext"] = ext;
+	if(vidinfo_contains("duration") && vidinfo["duration"].is_number())
+	{
+		// yt-dlp recomputes this for filenames, with '-' instead of ':'
+		const auto secs {static_cast<long long>(vidinfo["duration"].get<double>())};
+		const auto h {secs / 3600}, m {secs / 60 % 60}, s {secs % 60};
+		auto pad2 = [](long long n) { return (n < 10 ? "0" : "") + std::to_string(n); };
+		overrides["duration_string"] = h ? std::to_string(h) + '-' + pad2(m) + '-' + pad2(s) :
+			m ? std::to_string(m) + '-' + pad2(s) : std::to_string(s);
+	}
+
+	auto fname {outtmpl::evaluate(tmpl, full_vidinfo(), overrides)};
+	if(fname.empty())
+	{
+		// fall back to the name yt-dlp produced when the info was extracted
+		if(!vidinfo_contains("filename"))
+			return {};
+		fname = vidinfo["filename"];
+		auto pos {fname.rfind('.')};
+		if(pos != -1)
+			fname = fname.substr(0, pos + 1) + ext;
 	}
-	return file;
+	try { predicted_path = fs::u8path(outtmpl::sanitize_path(to_utf8((fs::u8path(home) / fs::u8path(fname)).wstring()))); }
+	catch(...) { return {}; }
+	if(opts.cbmp3)
+		predicted_path.replace_extension("mp3");
+	return predicted_path;
 }
 
 
-GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
+GUI::gui_bottom::gui_bottom(GUI &gui)
 {
-	using namespace nana;
-
 	auto &conf {GUI::conf};
 	pgui = &gui;
-	create(gui, visible);
-	bgcolor(::widgets::theme::fmbg);
 
 	auto prevbot {gui.bottoms.back()};
 	if(prevbot)
+	{
 		outpath = prevbot->outpath;
-	else outpath = conf.outpath;
-
-	plc.bind(*this);
-	gpopt.create(*this, "Download options");
-	gpopt.enabled(false);
-	plcopt.bind(gpopt);
-	tbrate.create(gpopt);
-	prog.create(*this);
-	separator.create(*this);
-	separator.refresh_theme();
-	expcol.create(*this);
-	btn_ytfmtlist.create(*this, "Select formats");
-	btndl.create(*this, "Start download");
-	btncopy.create(*this, "Apply options to all queue items");
-	btnerase.create(gpopt);
-	btnq.create(*this, gui.queue_panel.visible() ? "Show output" : "Show queue");
-	l_out.create(gpopt, "Download folder:");
-	l_out.text_align(nana::align::left, nana::align_v::center);
-	l_rate.create(gpopt, "Download rate limit:");
-	l_rate.text_align(nana::align::left, nana::align_v::center);
-	l_outpath.create(gpopt, &outpath);
-	com_rate.create(gpopt);
-	com_args.create(gpopt);
-	cbsplit.create(gpopt, "Split chapters");
-	cbkeyframes.create(gpopt, "Force keyframes at cuts");
-	cbmp3.create(gpopt, "Convert audio to MP3");
-	cbchaps.create(gpopt, "Embed chapters");
-	cbsubs.create(gpopt, "Embed subtitles");
-	cbthumb.create(gpopt, "Embed thumbnail");
-	cbsubs.create(gpopt, "Embed subtitles");
-	cbthumb.create(gpopt, "Embed thumbnail");
-	cbtime.create(gpopt, "File modification time = time of writing");
-	cbargs.create(gpopt, "Custom arguments:");
-
-	btnq.events().click([&, this]
-	{
-		if(btnq.caption().find("queue") != -1)
+		opts = prevbot->opts;
+	}
+	else
+	{
+		outpath = conf.outpath;
+		opts.cbsplit = conf.cbsplit;
+		opts.cbchaps = conf.cbchaps;
+		opts.cbsubs = conf.cbsubs;
+		opts.cbthumb = conf.cbthumb;
+		opts.cbtime = conf.cbtime;
+		opts.cbkeyframes = conf.cbkeyframes;
+		opts.cbmp3 = conf.cbmp3;
+		opts.cbargs = conf.cbargs;
+		if(conf.ratelim)
+			opts.ratelim = util::format_float(conf.ratelim, 1);
+		opts.ratelim_unit = conf.ratelim_unit;
+	}
+	opts.argset = conf.argset;
+	if(conf.common_dl_options && gui.bottoms.size())
+		opts.argset = gui.bottoms.at(0).opts.argset;
+}
+
+
+void GUI::gui_bottom::materialize()
+{
+	if(view)
+		return;
+	const auto first {empty()}; // the panel itself is made once, and stays when the widgets are released
+	if(first)
+	{
+		create(*pgui, false);
+		bgcolor(::widgets::theme::fmbg);
+	}
+	view = std::make_unique<view_t>();
+	made = true;
+	make_widgets();
+	if(first)
+		pgui->get_place()["Bottom"].fasten(*this);
+	if(conf.gpopt_hidden && !pgui->no_draw_freeze)
+	{
+		view->expcol.operate(true);
+		view->plc.field_display("gpopt", false);
+		view->plc.field_display("gpopt_spacer", false);
+		view->plc.collocate();
+	}
+}
+
+
+void GUI::gui_bottom::release()
+{
+	/* The state the widgets show is kept in opts and in the members the setters record it in (started_, prog_*, ...,
+	   under state_mtx), from which make_widgets restores it. Updates posted to the UI queue before the release check the view when
+	   they're made, and the threads that update the item only post them while it's made. */
+	if(!view || visible())
+		return;
+	made = false;
+	view.reset();
+}
+
+
+void GUI::gui_bottom::refresh_btndl()
+{
+	if(made) pgui->ui_update(ui_queue::kind::other, url, [this] { if(view) nana::api::refresh_window(view->btndl); });
+}
+
+
+void GUI::gui_bottom::load_options()
+{
+	if(!made)
+		return;
+	view->cbargs.check(opts.cbargs);
+	view->cbchaps.check(opts.cbchaps);
+	view->cbkeyframes.check(opts.cbkeyframes);
+	view->cbmp3.check(opts.cbmp3);
+	view->cbsplit.check(opts.cbsplit);
+	view->cbsubs.check(opts.cbsubs);
+	view->cbthumb.check(opts.cbthumb);
+	view->cbtime.check(opts.cbtime);
+	if(view->com_args.caption() != opts.argset)
+		view->com_args.caption(opts.argset);
+	view->com_rate.option(opts.ratelim_unit);
+	if(view->tbrate.caption() != opts.ratelim)
+		view->tbrate.caption(opts.ratelim);
+	view->l_outpath.update_caption();
+}
+
+
+void GUI::gui_bottom::reload_argsets()
+{
+	if(!made)
+		return;
+	view->com_args.clear();
+	for(auto &str : conf.argsets)
+		view->com_args.push_back(nana::to_utf8(str));
+	view->com_args.caption(opts.argset);
+}
+
+
+void GUI::gui_bottom::make_widgets()
+{
+	using namespace nana;
+
+	auto &conf {GUI::conf};
+	auto &gui {*pgui};
+	view->plc.bind(*this);
+	view->gpopt.create(*this, "Download options");
+	view->gpopt.enabled(false);
+	view->plcopt.bind(view->gpopt);
+	view->tbrate.create(view->gpopt);
+	view->prog.create(*this);
+	view->separator.create(*this);
+	view->separator.refresh_theme();
+	view->expcol.create(*this);
+	view->btn_ytfmtlist.create(*this, "Select formats");
+	view->btndl.create(*this, "Start download");
+	view->btncopy.create(*this, "Apply options to all queue items");
+	view->btnerase.create(view->gpopt);
+	view->btnq.create(*this, gui.queue_panel.visible() ? "Show output" : "Show queue");
+	view->l_out.create(view->gpopt, "Download folder:");
+	view->l_out.text_align(nana::align::left, nana::align_v::center);
+	view->l_rate.create(view->gpopt, "Download rate limit:");
+	view->l_rate.text_align(nana::align::left, nana::align_v::center);
+	view->l_outpath.create(view->gpopt, &outpath);
+	view->com_rate.create(view->gpopt);
+	view->com_args.create(view->gpopt);
+	view->cbsplit.create(view->gpopt, "Split chapters");
+	view->cbkeyframes.create(view->gpopt, "Force keyframes at cuts");
+	view->cbmp3.create(view->gpopt, "Convert audio to MP3");
+	view->cbchaps.create(view->gpopt, "Embed chapters");
+	view->cbsubs.create(view->gpopt, "Embed subtitles");
+	view->cbthumb.create(view->gpopt, "Embed thumbnail");
+	view->cbsubs.create(view->gpopt, "Embed subtitles");
+	view->cbthumb.create(view->gpopt, "Embed thumbnail");
+	view->cbtime.create(view->gpopt, "File modification time = time of writing");
+	view->cbargs.create(view->gpopt, "Custom arguments:");
+
+	view->btnq.events().click([&, this]
+	{
+		if(view->btnq.caption().find("queue") != -1)
 			gui.show_queue();
 		else gui.show_output();
 	});
 
-	btncopy.events().click([&, this]
+	view->btncopy.events().click([&, this]
 	{
 		gui.bottoms.propagate_cb_options(*this);
 		gui.bottoms.propagate_args_options(*this);
 		gui.bottoms.propagate_misc_options(*this);
 	});
 
-	plc.div(R"(vert
+	view->plc.div(R"(vert
 			<prog weight=30> 
 			<separator weight=3px>
 			<weight=20 <> <expcol weight=20>>
@@ -214,27 +406,43 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 			<weight=35 <> <btn_ytfmtlist weight=190> <ytfmt_spacer weight=20> <btncopy weight=328> <btncopy_spacer weight=20> 
 				<btnq weight=180> <weight=20> <btndl weight=200> <>>
 		)");
-	plc["prog"] << prog;
-	plc["separator"] << separator;
-	plc["expcol"] << expcol;
-	plc["gpopt"] << gpopt;
-	plc["btncopy"] << btncopy;
-	plc["btn_ytfmtlist"] << btn_ytfmtlist;
-	plc["btndl"] << btndl;
-	plc["btnq"] << btnq;
-
-	plc.field_display("prog", false);
-	plc.field_display("separator", true);
-	plc.field_display("btncopy", false);
-	plc.field_display("btncopy_spacer", false);
-	show_btnfmt(false);
-
-	prog.amount(1000);
-	prog.caption("");
-
-	gpopt.size({10, 10}); // workaround for weird caption display bug
-
-	if(gui.cnlang) gpopt.div(R"(vert margin=20
+	view->plc["prog"] << view->prog;
+	view->plc["separator"] << view->separator;
+	view->plc["expcol"] << view->expcol;
+	view->plc["gpopt"] << view->gpopt;
+	view->plc["btncopy"] << view->btncopy;
+	view->plc["btn_ytfmtlist"] << view->btn_ytfmtlist;
+	view->plc["btndl"] << view->btndl;
+	view->plc["btnq"] << view->btnq;
+
+	view->plc.field_display("prog", !gui.queue_panel.visible());
+	view->plc.field_display("separator", gui.queue_panel.visible());
+
+	// a change recorded after made was set is posted as well, so it's shown either way
+	std::unique_lock lock {state_mtx};
+	const auto copy_shown {btncopy_shown}, fmt_shown {btnfmt_shown}, dl_started {started_}, dl_enabled {btndl_enabled};
+	const auto amount {prog_amount}, value {prog_value}, shadow {prog_shadow};
+	const auto caption {prog_caption}, options {gpopt_caption};
+	lock.unlock();
+
+	view->plc.field_display("btncopy", copy_shown);
+	view->plc.field_display("btncopy_spacer", copy_shown);
+	view->plc.field_display("btn_ytfmtlist", fmt_shown);
+	view->plc.field_display("ytfm_spacer", fmt_shown);
+
+	view->prog.amount(amount);
+	view->prog.value(value);
+	if(shadow)
+		view->prog.shadow_progress(1000, shadow);
+	view->prog.caption(caption);
+	view->gpopt.caption(options);
+	view->btndl.caption(dl_started ? "Stop download" : "Start download");
+	view->btndl.cancel_mode(dl_started);
+	view->btndl.enabled(dl_enabled);
+
+	view->gpopt.size({10, 10}); // workaround for weird caption display bug
+
+	if(gui.cnlang) view->gpopt.div(R"(vert margin=20
 			<weight=25 <l_out weight=140> <l_outpath> > <weight=20>
 			<weight=25 
 				<l_rate weight=163> <tbrate weight=45> <weight=15> <com_rate weight=55> 
@@ -244,7 +452,7 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 			<weight=20> <weight=24 <cbargs weight=178> <weight=15> <com_args> <weight=10> <btnerase weight=24>>
 		)");
 
-	else gpopt.div(R"(vert margin=20
+	else view->gpopt.div(R"(vert margin=20
 			<weight=25 <l_out weight=122> <weight=15> <l_outpath> > <weight=20>
 			<weight=25 
 				<l_rate weight=144> <weight=15> <tbrate weight=45> <weight=15> <com_rate weight=55> 
@@ -254,149 +462,138 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 			<weight=20> <weight=24 <cbargs weight=164> <weight=15> <com_args> <weight=10> <btnerase weight=24>>
 		)");
 
-	gpopt["l_out"] << l_out;
-	gpopt["l_outpath"] << l_outpath;
-	gpopt["l_rate"] << l_rate;
-	gpopt["tbrate"] << tbrate;
-	gpopt["com_rate"] << com_rate;
-	gpopt["cbsplit"] << cbsplit;
-	gpopt["cbkeyframes"] << cbkeyframes;
-	gpopt["cbmp3"] << cbmp3;
-	gpopt["cbchaps"] << cbchaps;
-	gpopt["cbsubs"] << cbsubs;
-	gpopt["cbthumb"] << cbthumb;
-	gpopt["cbtime"] << cbtime;
-	gpopt["cbargs"] << cbargs;
-	gpopt["com_args"] << com_args;
-	gpopt["btnerase"] << btnerase;
+	view->gpopt["l_out"] << view->l_out;
+	view->gpopt["l_outpath"] << view->l_outpath;
+	view->gpopt["l_rate"] << view->l_rate;
+	view->gpopt["tbrate"] << view->tbrate;
+	view->gpopt["com_rate"] << view->com_rate;
+	view->gpopt["cbsplit"] << view->cbsplit;
+	view->gpopt["cbkeyframes"] << view->cbkeyframes;
+	view->gpopt["cbmp3"] << view->cbmp3;
+	view->gpopt["cbchaps"] << view->cbchaps;
+	view->gpopt["cbsubs"] << view->cbsubs;
+	view->gpopt["cbthumb"] << view->cbthumb;
+	view->gpopt["cbtime"] << view->cbtime;
+	view->gpopt["cbargs"] << view->cbargs;
+	view->gpopt["com_args"] << view->com_args;
+	view->gpopt["btnerase"] << view->btnerase;
 
 	if(API::screen_dpi(true) > 96)
 	{
-		btnerase.image(arr_erase22_ico, sizeof arr_erase22_ico);
-		btnerase.image_disabled(arr_erase22_disabled_ico, sizeof arr_erase22_disabled_ico);
+		view->btnerase.image(arr_erase22_ico, sizeof arr_erase22_ico);
+		view->btnerase.image_disabled(arr_erase22_disabled_ico, sizeof arr_erase22_disabled_ico);
 	}
 	else
 	{
-		btnerase.image(arr_erase16_ico, sizeof arr_erase16_ico);
-		btnerase.image_disabled(arr_erase16_disabled_ico, sizeof arr_erase16_disabled_ico);
+		view->btnerase.image(arr_erase16_ico, sizeof arr_erase16_ico);
+		view->btnerase.image_disabled(arr_erase16_disabled_ico, sizeof arr_erase16_disabled_ico);
 	}
 
-	tbrate.multi_lines(false);
-	tbrate.padding(0, 5, 0, 5);
+	view->tbrate.multi_lines(false);
+	view->tbrate.padding(0, 5, 0, 5);
 
 	for(auto &str : conf.argsets)
-		com_args.push_back(to_utf8(str));
-	com_args.caption(conf.argset);
-	com_args.editable(true);
+		view->com_args.push_back(to_utf8(str));
+	view->com_args.caption(opts.argset);
+	view->com_args.editable(true);
 
-	com_args.events().focus([&, this] (const arg_focus &arg)
+	view->com_args.events().focus([&, this] (const arg_focus &arg)
 	{
 		if(!arg.getting)
 		{
-			conf.argset = com_args.caption();
+			conf.argset = opts.argset;
 			if(conf.common_dl_options)
-			{
-				for(auto &pbot : gui.bottoms)
-				{
-					auto &bot {*pbot.second};
-					if(bot.handle() != *this)
-						bot.com_args.caption(caption());
-				}
-			}
+				gui.bottoms.propagate_args_options(*this);
 		}
 	});
 
-	com_args.events().selected([&, this]
+	view->com_args.events().selected([&, this]
 	{
-		conf.argset = com_args.caption();
-		if(conf.common_dl_options && api::focus_window() == com_args)
+		conf.argset = opts.argset = view->com_args.caption();
+		if(conf.common_dl_options && api::focus_window() == view->com_args)
 			gui.bottoms.propagate_args_options(*this);
 	});
 
-	com_args.events().text_changed([&, this]
+	view->com_args.events().text_changed([&, this]
 	{
-		auto idx {com_args.caption_index()};
-		if(idx != -1) btnerase.enable(true);
-		else btnerase.enable(false);
-		if(api::focus_window() == com_args)
-		{
-			for(auto &pbot : gui.bottoms)
-			{
-				auto &bot {*pbot.second};
-				if(bot.handle() != handle())
-					bot.com_args.caption(com_args.caption());
-			}
-		}
+		opts.argset = view->com_args.caption();
+		auto idx {view->com_args.caption_index()};
+		if(idx != -1) view->btnerase.enable(true);
+		else view->btnerase.enable(false);
+		if(api::focus_window() == view->com_args)
+			gui.bottoms.propagate_args_options(*this);
 	});
 
-	btnerase.events().click([&, this]
+	view->btnerase.events().click([&, this]
 	{
-		auto idx {com_args.caption_index()};
+		auto idx {view->com_args.caption_index()};
 		if(idx != -1)
 		{
-			com_args.erase(idx);
-			com_args.caption("");
+			view->com_args.erase(idx);
+			view->com_args.caption("");
 			conf.argsets.erase(conf.argsets.begin() + idx);
 			auto size {conf.argsets.size()};
 			if(size && idx == size) idx--;
-			com_args.option(idx);
+			view->com_args.option(idx);
+			opts.argset = view->com_args.caption();
+			for(auto &pbot : gui.bottoms)
+				if(pbot.second.get() != this)
+					pbot.second->reload_argsets();
 			if(conf.common_dl_options)
 				gui.bottoms.propagate_args_options(*this);
 		}
 	});
 
-	if(prevbot)
-		tbrate.caption(prevbot->tbrate.caption());
-	else if(conf.ratelim)
-		tbrate.caption(util::format_float(conf.ratelim, 1));
+	view->tbrate.caption(opts.ratelim);
 
-	tbrate.set_accept([this](wchar_t wc)->bool
+	view->tbrate.set_accept([this](wchar_t wc)->bool
 	{
-		return wc == keyboard::backspace || wc == keyboard::del || ((isdigit(wc) || wc == '.') && tbrate.text().size() < 5);
+		return wc == keyboard::backspace || wc == keyboard::del || ((isdigit(wc) || wc == '.') && view->tbrate.text().size() < 5);
 	});
 
-	tbrate.events().focus([this](const arg_focus &arg)
+	view->tbrate.events().focus([this](const arg_focus &arg)
 	{
 		if(!arg.getting)
 		{
-			auto str {tbrate.caption()};
+			auto str {view->tbrate.caption()};
 			if(!str.empty() && str.back() == '.')
 			{
 				str.pop_back();
-				tbrate.caption(str);
+				view->tbrate.caption(str);
 			}
-			GUI::conf.ratelim = tbrate.to_double();
+			GUI::conf.ratelim = view->tbrate.to_double();
 		}
 	});
 
-	tbrate.events().text_changed([&, this]
+	view->tbrate.events().text_changed([&, this]
 	{
-		if(conf.common_dl_options && tbrate == api::focus_window())
+		opts.ratelim = view->tbrate.caption();
+		if(conf.common_dl_options && view->tbrate == api::focus_window())
 			gui.bottoms.propagate_misc_options(*this);
 	});
 
-	com_rate.editable(false);
-	com_rate.push_back(" KB/s");
-	com_rate.push_back(" MB/s");
-	if(prevbot)
-		com_rate.option(prevbot->com_rate.option());
-	else com_rate.option(conf.ratelim_unit);
-	com_rate.events().selected([&]
+	view->com_rate.editable(false);
+	view->com_rate.push_back(" KB/s");
+	view->com_rate.push_back(" MB/s");
+	view->com_rate.option(opts.ratelim_unit);
+	view->com_rate.events().selected([&]
 	{
-		conf.ratelim_unit = com_rate.option();
-		if(conf.common_dl_options && com_rate == api::focus_window())
+		opts.ratelim_unit = conf.ratelim_unit = view->com_rate.option();
+		if(conf.common_dl_options && view->com_rate == api::focus_window())
 			gui.bottoms.propagate_misc_options(*this);
 	});
 
-	expcol.events().click([&, this]
+	view->expcol.events().click([&, this]
 	{
 		auto wdsz {api::window_size(gui)};
 		const auto px {(nana::API::screen_dpi(true) >= 144) * gui.queue_panel.visible()};
-		gui.change_field_attr(gui.get_place(), "Bottom", "weight", 325 - 240 * expcol.collapsed() - 27 * gui.queue_panel.visible() - px);
+		gui.change_field_attr(gui.get_place(), "Bottom", "weight", 325 - 240 * view->expcol.collapsed() - 27 * gui.queue_panel.visible() - px);
 		for(auto &bottom : gui.bottoms)
 		{
 			auto &bot {*bottom.second};
-			if(expcol.collapsed())
+			if(!bot.made)
+				continue;
+			if(view->expcol.collapsed())
 			{
 				if(&bot == this)
 				{
@@ -410,10 +607,10 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 					gui.minh -= dh;
 					api::window_size(gui, wdsz);
 				}
-				else bot.expcol.operate(true);
-				bot.plc.field_display("gpopt", false);
-				bot.plc.field_display("gpopt_spacer", false);
-				bot.plc.collocate();
+				else bot.view->expcol.operate(true);
+				bot.view->plc.field_display("gpopt", false);
+				bot.view->plc.field_display("gpopt_spacer", false);
+				bot.view->plc.collocate();
 				if(&bot == this && !gui.no_draw_freeze)
 				{
 					SendMessageA(gui.hwnd, WM_SETREDRAW, TRUE, 0);
@@ -434,10 +631,10 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 					gui.minh += dh;
 					api::window_size(gui, wdsz);
 				}
-				else bot.expcol.operate(false);
-				bot.plc.field_display("gpopt", true);
-				bot.plc.field_display("gpopt_spacer", true);
-				bot.plc.collocate();
+				else bot.view->expcol.operate(false);
+				bot.view->plc.field_display("gpopt", true);
+				bot.view->plc.field_display("gpopt_spacer", true);
+				bot.view->plc.collocate();
 				if(&bot == this && !gui.no_draw_freeze)
 				{
 					SendMessageA(gui.hwnd, WM_SETREDRAW, TRUE, 0);
@@ -447,21 +644,21 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 		}
 	});
 
-	cbsplit.tooltip("Split into multiple files based on internal chapters. (<bold>--split-chapters)</>");
-	cbkeyframes.tooltip("Force keyframes around the chapters before\nremoving/splitting them. Requires a\n"
+	view->cbsplit.tooltip("Split into multiple files based on internal chapters. (<bold>--split-chapters)</>");
+	view->cbkeyframes.tooltip("Force keyframes around the chapters before\nremoving/splitting them. Requires a\n"
 		"reencode and thus is very slow, but the\nresulting video may have fewer artifacts\n"
 		"around the cuts. (<bold>--force-keyframes-at-cuts</>)");
-	cbtime.tooltip("Do not use the Last-modified header to set the file modification time (<bold>--no-mtime</>)");
-	cbsubs.tooltip("Embed subtitles in the video (only for mp4, webm and mkv videos) (<bold>--embed-subs</>)");
-	cbchaps.tooltip("Add chapter markers to the video file (<bold>--embed-chapters</>)");
-	cbthumb.tooltip("Embed thumbnail in the video as cover art (<bold>--embed-thumbnail</>)");
-	cbmp3.tooltip("Convert the source audio to MPEG Layer 3 format and save it to an .mp3 file.\n"
+	view->cbtime.tooltip("Do not use the Last-modified header to set the file modification time (<bold>--no-mtime</>)");
+	view->cbsubs.tooltip("Embed subtitles in the video (only for mp4, webm and mkv videos) (<bold>--embed-subs</>)");
+	view->cbchaps.tooltip("Add chapter markers to the video file (<bold>--embed-chapters</>)");
+	view->cbthumb.tooltip("Embed thumbnail in the video as cover art (<bold>--embed-thumbnail</>)");
+	view->cbmp3.tooltip("Convert the source audio to MPEG Layer 3 format and save it to an .mp3 file.\n"
 		"The video is discarded if present, so it's preferable to download an audio-only\n"
 		"format if one is available. (<bold>-x --audio-format mp3</>)\n\n"
 		"To download the best audio-only format available, use the custom\nargument <bold>-f ba</>");
-	btnerase.tooltip("Remove this argument set from the list");
-	btncopy.tooltip("Copy the options for this queue item to all the other queue items.");
-	btn_ytfmtlist.tooltip("Choose formats manually, instead of letting yt-dlp\nchoose automatically. "
+	view->btnerase.tooltip("Remove this argument set from the list");
+	view->btncopy.tooltip("Copy the options for this queue item to all the other queue items.");
+	view->btn_ytfmtlist.tooltip("Choose formats manually, instead of letting yt-dlp\nchoose automatically. "
 		"By default, yt-dlp chooses the\nbest formats, according to the preferences you set\n"
 		"(if you press the \"Settings\" button, you can set\nthe preferred resolution, container, and framerate).");
 	std::string args_tip
@@ -475,28 +672,28 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 			"For more, read the yt-dlp documentation:\n"
 			"https://github.com/yt-dlp/yt-dlp#usage-and-options"
 	};
-	cbargs.tooltip(args_tip);
-	com_args.tooltip(args_tip);
+	view->cbargs.tooltip(args_tip);
+	view->com_args.tooltip(args_tip);
 
-	btndl.events().click([&gui, this] { gui.on_btn_dl(url); });
+	view->btndl.events().click([&gui, this] { gui.on_btn_dl(url); });
 
-	btndl.events().key_press([&gui, this](const arg_keyboard &arg)
+	view->btndl.events().key_press([&gui, this](const arg_keyboard &arg)
 	{
 		if(arg.key == '\r')
 			gui.on_btn_dl(url);
 	});
 
-	btn_ytfmtlist.events().click([&gui, this]
+	view->btn_ytfmtlist.events().click([&gui, this]
 	{
 		gui.fm_formats();
 	});
 
-	l_outpath.events().click([&gui, &conf, this]
+	view->l_outpath.events().click([&gui, &conf, this]
 	{
 		auto clip_text = [this](const std::wstring &str, int max_pixels) -> std::wstring
 		{
 			nana::label l {*this, str};
-			l.typeface(l_outpath.typeface());
+			l.typeface(view->l_outpath.typeface());
 			int offset {0};
 			const auto strsize {str.size()};
 			while(l.measure(1234).width > max_pixels)
@@ -519,7 +716,7 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 			{
 				conf.outpaths.insert(outpath);
 				outpath = conf.outpath = res.front();
-				l_outpath.caption(outpath.u8string());
+				view->l_outpath.caption(outpath.u8string());
 				if(conf.common_dl_options)
 					gui.bottoms.propagate_misc_options(*this);
 			}
@@ -553,7 +750,7 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 					m.append(to_utf8(clip_text(path, gui.dpi_transform(250))), [&, this](menu::item_proxy &)
 					{
 						outpath = conf.outpath = path;
-						l_outpath.update_caption();
+						view->l_outpath.update_caption();
 						conf.outpaths.insert(outpath);
 						if(conf.common_dl_options)
 							gui.bottoms.propagate_misc_options(*this);
@@ -569,91 +766,74 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 
 	});
 
-	if(prevbot)
-	{
-		cbsplit.check(prevbot->cbsplit.checked());
-		cbchaps.check(prevbot->cbchaps.checked());
-		cbsubs.check(prevbot->cbsubs.checked());
-		cbthumb.check(prevbot->cbthumb.checked());
-		cbtime.check(prevbot->cbtime.checked());
-		cbkeyframes.check(prevbot->cbkeyframes.checked());
-		cbmp3.check(prevbot->cbmp3.checked());
-		cbargs.check(prevbot->cbargs.checked());
-	}
-	else
-	{
-		cbsplit.check(conf.cbsplit);
-		cbchaps.check(conf.cbchaps);
-		cbsubs.check(conf.cbsubs);
-		cbthumb.check(conf.cbthumb);
-		cbtime.check(conf.cbtime);
-		cbkeyframes.check(conf.cbkeyframes);
-		cbmp3.check(conf.cbmp3);
-		cbargs.check(conf.cbargs);
-	}
+	view->cbsplit.check(opts.cbsplit);
+	view->cbchaps.check(opts.cbchaps);
+	view->cbsubs.check(opts.cbsubs);
+	view->cbthumb.check(opts.cbthumb);
+	view->cbtime.check(opts.cbtime);
+	view->cbkeyframes.check(opts.cbkeyframes);
+	view->cbmp3.check(opts.cbmp3);
+	view->cbargs.check(opts.cbargs);
 
-	cbsplit.radio(true);
-	cbchaps.radio(true);
+	view->cbsplit.radio(true);
+	view->cbchaps.radio(true);
 
-	cbsplit.events().checked([&, this]
+	view->cbsplit.events().checked([&, this]
 	{
-		if(cbsplit.checked() && cbchaps.checked())
-			cbchaps.check(false);
-		conf.cbsplit = cbsplit.checked();
-		if(conf.common_dl_options && cbsplit == api::focus_window())
+		if(view->cbsplit.checked() && view->cbchaps.checked())
+			view->cbchaps.check(false);
+		conf.cbsplit = opts.cbsplit = view->cbsplit.checked();
+		if(conf.common_dl_options && view->cbsplit == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
 
-	cbchaps.events().checked([&, this]
+	view->cbchaps.events().checked([&, this]
 	{
-		if(cbchaps.checked() && cbsplit.checked())
-			cbsplit.check(false);
-		conf.cbchaps = cbchaps.checked();
-		if(conf.common_dl_options && cbchaps == api::focus_window())
+		if(view->cbchaps.checked() && view->cbsplit.checked())
+			view->cbsplit.check(false);
+		conf.cbchaps = opts.cbchaps = view->cbchaps.checked();
+		if(conf.common_dl_options && view->cbchaps == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
 
-	cbtime.events().checked([&, this]
+	view->cbtime.events().checked([&, this]
 	{
-		conf.cbtime = cbtime.checked();
-		if(conf.common_dl_options && cbtime == api::focus_window())
+		conf.cbtime = opts.cbtime = view->cbtime.checked();
+		if(conf.common_dl_options && view->cbtime == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
-	cbthumb.events().checked([&, this]
+	view->cbthumb.events().checked([&, this]
 	{
-		conf.cbthumb = cbthumb.checked();
-		if(conf.common_dl_options && cbthumb == api::focus_window())
+		conf.cbthumb = opts.cbthumb = view->cbthumb.checked();
+		if(conf.common_dl_options && view->cbthumb == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
-	cbsubs.events().checked([&, this]
+	view->cbsubs.events().checked([&, this]
 	{
-		conf.cbsubs = cbsubs.checked();
-		if(conf.common_dl_options && cbsubs == api::focus_window())
+		conf.cbsubs = opts.cbsubs = view->cbsubs.checked();
+		if(conf.common_dl_options && view->cbsubs == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
-	cbkeyframes.events().checked([&, this]
+	view->cbkeyframes.events().checked([&, this]
 	{
-		conf.cbkeyframes = cbkeyframes.checked();
-		if(conf.common_dl_options && cbkeyframes == api::focus_window())
+		conf.cbkeyframes = opts.cbkeyframes = view->cbkeyframes.checked();
+		if(conf.common_dl_options && view->cbkeyframes == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
-	cbmp3.events().checked([&, this]
+	view->cbmp3.events().checked([&, this]
 	{
-		conf.cbmp3 = cbmp3.checked();
-		if(conf.common_dl_options && cbmp3 == api::focus_window())
+		conf.cbmp3 = opts.cbmp3 = view->cbmp3.checked();
+		if(conf.common_dl_options && view->cbmp3 == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
-	cbargs.events().checked([&, this]
+	view->cbargs.events().checked([&, this]
 	{
-		conf.cbargs = cbargs.checked();
-		if(conf.common_dl_options && cbargs == api::focus_window())
+		conf.cbargs = opts.cbargs = view->cbargs.checked();
+		if(conf.common_dl_options && view->cbargs == api::focus_window())
 			gui.bottoms.propagate_cb_options(*this);
 	});
 
-	if(conf.common_dl_options && gui.bottoms.size())
-		com_args.caption(gui.bottoms.at(0).com_args.caption());
-
-	com_args.events().mouse_up([this](const arg_mouse &arg)
+	view->com_args.events().mouse_up([this](const arg_mouse &arg)
 	{
 		if(arg.button == mouse::right_button)
 		{
@@ -665,19 +845,19 @@ GUI::gui_bottom::gui_bottom(GUI &gui, bool visible)
 
 			m.append("Paste", [&, this](menu::item_proxy)
 			{
-				com_args.focus();
+				view->com_args.focus();
 				keybd_event(VK_LCONTROL, 0, 0, 0);
 				keybd_event('V', 0, 0, 0);
 				keybd_event('V', 0, KEYEVENTF_KEYUP, 0);
 				keybd_event(VK_LCONTROL, 0, KEYEVENTF_KEYUP, 0);
 			}).enabled(!cliptext.empty());
 
-			m.popup_await(com_args, arg.pos.x, arg.pos.y);
+			m.popup_await(view->com_args, arg.pos.x, arg.pos.y);
 		}
 	});
 
 	gui.queue_panel.focus();
-	plc.collocate();
+	view->plc.collocate();
 }
 
 
@@ -747,4 +927,142 @@ bool GUI::gui_bottom::vidinfo_contains(std::string key)
 	if(vidinfo.contains(key) && vidinfo[key] != nullptr)
 		return true;
 	return false;
+}
+
+
+void GUI::gui_bottom::store_vidinfo()
+{
+	/* the info dict of a YouTube video is mostly signed format URLs, thumbnails, automatic captions and HTTP headers,
+	   often more than a megabyte of JSON nodes; the GUI reads only a handful of fields, so only those stay parsed,
+	   and the whole dict is kept compressed for the few things that need it (JSON viewer, format selection, output
+	   template, --load-info-json) */
+	static const std::vector<std::string> keep {"id", "title", "webpage_url", "webpage_url_domain", "extractor",
+		"extractor_key", "is_live", "live_status", "format_id", "format", "format_note", "resolution", "ext", "filesize",
+		"filesize_approx", "duration", "duration_string", "filename", "_filename", "thumbnail", "uploader", "upload_date"};
+
+	formats.build(vidinfo);
+	vidinfo_full.clear();
+	vidinfo_expire = 0;
+	if(vidinfo.empty())
+		return;
+
+	/* signed format URLs (YouTube and others) carry their expiry time as "expire=<unix time>" in the query, or as
+	   "/expire/<unix time>/" in the path of manifest URLs */
+	const auto dump {vidinfo.dump()};
+	for(std::string key : {"expire=", "/expire/"})
+		for(auto pos {dump.find(key)}; pos != -1; pos = dump.find(key, pos))
+		{
+			pos += key.size();
+			long long val {0};
+			while(pos < dump.size() && isdigit(dump[pos]))
+				val = val * 10 + dump[pos++] - '0';
+			if(val && (!vidinfo_expire || val < vidinfo_expire))
+				vidinfo_expire = val;
+		}
+	vidinfo_full.pack(dump);
+
+	nlohmann::json slim;
+	for(const auto &key : keep)
+		if(auto it {vidinfo.find(key)}; it != vidinfo.end())
+			slim[key] = std::move(*it);
+	if(auto it {vidinfo.find("requested_formats")}; it != vidinfo.end() && it->is_array())
+	{
+		auto &reqfmts {slim["requested_formats"] = nlohmann::json::array()};
+		for(auto &fmt : *it)
+		{
+			nlohmann::json el = nlohmann::json::object();
+			for(auto key : {"format_id", "ext", "filesize"})
+				if(fmt.contains(key))
+					el[key] = fmt[key];
+			reqfmts.push_back(std::move(el));
+		}
+	}
+	vidinfo = std::move(slim);
+}
+
+
+bool GUI::gui_bottom::fragmented()
+{
+	// the formats yt-dlp is going to download: the ones picked in the formats window, or its own pick from the info
+	std::vector<std::string> ids;
+	auto split = [&ids](std::string str)
+	{
+		for(size_t pos {0}, plus {0}; pos <= str.size(); pos = plus + 1)
+		{
+			plus = str.find('+', pos);
+			if(plus == -1)
+				plus = str.size();
+			if(plus > pos)
+				ids.push_back(str.substr(pos, plus - pos));
+		}
+	};
+	if(use_strfmt)
+	{
+		split(nana::to_utf8(fmt1));
+		split(nana::to_utf8(fmt2));
+	}
+	else if(vidinfo_contains("format_id"))
+		split(vidinfo["format_id"].get<std::string>());
+
+	bool found {false};
+	for(const auto &id : ids)
+		if(auto pfmt {formats.find(id)})
+		{
+			if(pfmt->fragmented)
+				return true;
+			found = true;
+		}
+	if(found)
+		return false;
+	// nothing to go by (playlists, channels): -N is harmless for formats that aren't fragmented, so it's used anyway
+	if(formats.empty())
+		return true;
+	return formats.formats[formats.by_quality.front()].fragmented;
+}
+
+
+void GUI::gui_bottom::clear_vidinfo()
+{
+	vidinfo.clear();
+	vidinfo_full.clear();
+	formats.clear();
+	vidinfo_expire = 0;
+}
+
+
+nlohmann::json GUI::gui_bottom::full_vidinfo()
+{
+	if(vidinfo_full.empty())
+		return vidinfo;
+	try { return nlohmann::json::parse(vidinfo_full.unpack()); }
+	catch(nlohmann::detail::exception) { return vidinfo; }
+}
+
+
+std::string GUI::gui_bottom::domain_key()
+{
+	auto host {site()};
+	if(host.empty()) // media info not available yet, use the host part of the URL
+	{
+		host = nana::to_utf8(url);
+		auto pos {host.find("://")};
+		if(pos != -1)
+			host.erase(0, pos + 3);
+		pos = host.find_first_of("/?#:");
+		if(pos != -1)
+			host.erase(pos);
+		for(auto &c : host)
+			c = std::tolower(c);
+	}
+
+	// yt-dlp's webpage_url_domain only drops "www.", and the URL can name the site differently than the info does
+	// (youtu.be links have youtube.com pages), so the names are reduced to the site's main domain
+	for(const auto prefix : {"www.", "m.", "music."})
+		if(host.starts_with(prefix))
+			host.erase(0, strlen(prefix));
+	if(host == "youtu.be" || host == "youtube-nocookie.com")
+		host = "youtube.com";
+	else if(host.ends_with(".bandcamp.com")) // artist subdomains (the queue column shows them as they are)
+		host = "bandcamp.com";
+	return host;
 }
\ No newline at end of file
@@ -37,15 +37,21 @@ void GUI::gui_bottoms::show(std::wstring key)
 	{
 		if(bottom.first == key)
 		{
+			gui->item_caption(key); // not kept up to date while the item isn't displayed
+			bottom.second->materialize();
 			bottom.second->show();
-			bottom.second->btndl.focus();
+			bottom.second->view->btndl.focus();
 			break;
 		}
 	}
 
+	// only the displayed item keeps its widgets (some 30 native windows); the others are made again when shown
 	for(auto &bottom : bottoms)
-		if(bottom.first != key)
+		if(bottom.first != key && bottom.second->materialized())
+		{
 			bottom.second->hide();
+			bottom.second->release();
+		}
 
 	gui->get_place().collocate();
 }
@@ -54,7 +60,7 @@ void GUI::gui_bottoms::show(std::wstring key)
 std::wstring GUI::gui_bottoms::visible()
 {
 	for(auto &bottom : bottoms)
-		if(bottom.second->visible())
+		if(bottom.second->materialized() && bottom.second->visible())
 			return bottom.first;
 	return L"";
 }
@@ -67,9 +73,8 @@ GUI::gui_bottom &GUI::gui_bottoms::add(std::wstring url, bool visible)
 	auto it {bottoms.find(url)};
 	if(it == bottoms.end())
 	{
-		auto &pbot {bottoms[url] = std::make_unique<gui_bottom>(*gui, visible)};
+		auto &pbot {bottoms[url] = std::make_unique<gui_bottom>(*gui)};
 		insertion_order.push_back(url);
-		gui->get_place()["Bottom"].fasten(*pbot);
 		pbot->index = insertion_order.size() - 1;
 		pbot->url = url;
 		pbot->is_ytlink = gui->is_ytlink(url);
@@ -79,12 +84,10 @@ GUI::gui_bottom &GUI::gui_bottoms::add(std::wstring url, bool visible)
 		pbot->is_bclink = url.find(L"bandcamp.com") != -1;
 		pbot->is_bcchan = url.find(L".bandcamp.com/music") != -1 || url.rfind(L".bandcamp.com") == url.size() - 13
 			|| url.rfind(L".bandcamp.com/") == url.size() - 14;
-		if(gui->conf.gpopt_hidden && !gui->no_draw_freeze)
+		if(visible)
 		{
-			pbot->expcol.operate(true);
-			pbot->plc.field_display("gpopt", false);
-			pbot->plc.field_display("gpopt_spacer", false);
-			pbot->plc.collocate();
+			pbot->materialize();
+			pbot->show();
 		}
 		return *pbot;
 	}
@@ -97,7 +100,8 @@ void GUI::gui_bottoms::erase(std::wstring url)
 	if(bottoms.contains(url))
 	{
 		insertion_order.remove(url);
-		gui->get_place().erase(*bottoms.at(url));
+		if(!bottoms.at(url)->empty())
+			gui->get_place().erase(*bottoms.at(url));
 		bottoms.erase(url);
 	}
 }
@@ -108,16 +112,17 @@ void GUI::gui_bottoms::propagate_cb_options(const gui_bottom &srcbot)
 	for(auto &pbot : *this)
 	{
 		auto &bot {*pbot.second};
-		if(bot.handle() != srcbot.handle())
+		if(&bot != &srcbot)
 		{
-			bot.cbargs.check(srcbot.cbargs.checked());
-			bot.cbchaps.check(srcbot.cbchaps.checked());
-			bot.cbkeyframes.check(srcbot.cbkeyframes.checked());
-			bot.cbmp3.check(srcbot.cbmp3.checked());
-			bot.cbsplit.check(srcbot.cbsplit.checked());
-			bot.cbsubs.check(srcbot.cbsubs.checked());
-			bot.cbthumb.check(srcbot.cbthumb.checked());
-			bot.cbtime.check(srcbot.cbtime.checked());
+			bot.opts.cbargs = srcbot.opts.cbargs;
+			bot.opts.cbchaps = srcbot.opts.cbchaps;
+			bot.opts.cbkeyframes = srcbot.opts.cbkeyframes;
+			bot.opts.cbmp3 = srcbot.opts.cbmp3;
+			bot.opts.cbsplit = srcbot.opts.cbsplit;
+			bot.opts.cbsubs = srcbot.opts.cbsubs;
+			bot.opts.cbthumb = srcbot.opts.cbthumb;
+			bot.opts.cbtime = srcbot.opts.cbtime;
+			bot.load_options();
 		}
 	}
 }
@@ -128,15 +133,11 @@ void GUI::gui_bottoms::propagate_args_options(const gui_bottom &srcbot)
 	for(auto &pbot : *this)
 	{
 		auto &bot {*pbot.second};
-		if(bot.handle() != srcbot.handle())
+		if(&bot != &srcbot)
 		{
-			bot.com_args.clear();
-			if(srcbot.com_args.the_number_of_options())
-			{
-				for(int n {0}; n < srcbot.com_args.the_number_of_options(); n++)
-					bot.com_args.push_back(srcbot.com_args.text(n));
-			}
-			bot.com_args.caption(srcbot.com_args.caption());
+			bot.opts.argset = srcbot.opts.argset;
+			if(bot.materialized() && bot.view->com_args.caption() != bot.opts.argset)
+				bot.view->com_args.caption(bot.opts.argset);
 		}
 	}
 }
@@ -147,12 +148,12 @@ void GUI::gui_bottoms::propagate_misc_options(const gui_bottom &srcbot)
 	for(auto &pbot : *this)
 	{
 		auto &bot {*pbot.second};
-		if(bot.handle() != srcbot.handle())
+		if(&bot != &srcbot)
 		{
-			bot.com_rate.option(srcbot.com_rate.option());
-			bot.tbrate.caption(srcbot.tbrate.caption());
+			bot.opts.ratelim = srcbot.opts.ratelim;
+			bot.opts.ratelim_unit = srcbot.opts.ratelim_unit;
 			bot.outpath = srcbot.outpath;
-			bot.l_outpath.update_caption();
+			bot.load_options();
 		}
 	}
 }
\ No newline at end of file
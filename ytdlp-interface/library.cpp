@@ -0,0 +1,435 @@
+#include <windows.h>
+#include "library.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cwctype>
+#include <algorithm>
+#include <unordered_set>
+
+#pragma warning (disable: 4267)
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+	std::string lowercase(std::string str)
+	{
+		for(auto &c : str)
+			if(c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+		return str;
+	}
+}
+
+
+void media_library::open(const fs::path &base_path)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	unmap();
+	journal.clear();
+	journal_keys.clear();
+	base = base_path;
+
+	auto table_path {base};
+	table_path += ".bin";
+	hfile = CreateFileW(table_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0, nullptr);
+	if(hfile == INVALID_HANDLE_VALUE)
+		hfile = nullptr;
+	LARGE_INTEGER fsize {};
+	if(hfile && GetFileSizeEx(hfile, &fsize) && fsize.QuadPart >= sizeof(header_t))
+	{
+		hmap = CreateFileMappingW(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(hmap)
+			view = static_cast<const char*>(MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0));
+	}
+	if(view)
+	{
+		// a table that doesn't add up is ignored (and replaced by the next merge), rather than trusted
+		hdr = reinterpret_cast<const header_t*>(view);
+		const auto expected {sizeof(header_t) + static_cast<unsigned long long>(hdr->slots) * sizeof(slot_t) +
+			static_cast<unsigned long long>(hdr->records) * sizeof(disk_record_t) + hdr->strings};
+		if(!std::equal(magic, magic + sizeof magic, hdr->magic) || !hdr->slots || (hdr->slots & (hdr->slots - 1)) ||
+			expected != static_cast<unsigned long long>(fsize.QuadPart))
+		{
+			unmap();
+		}
+		else
+		{
+			slots = reinterpret_cast<const slot_t*>(view + sizeof(header_t));
+			records = reinterpret_cast<const disk_record_t*>(slots + hdr->slots);
+			strings = reinterpret_cast<const char*>(records + hdr->records);
+		}
+	}
+	else unmap();
+
+	auto journal_path {base};
+	journal_path += ".jsonl";
+	if(std::ifstream is {journal_path})
+	{
+		std::string line;
+		while(std::getline(is, line))
+		{
+			auto j {nlohmann::json::parse(line, nullptr, false)};
+			if(j.is_discarded() || !j.is_object())
+				continue; // a line cut short by a crash
+			record_t rec;
+			rec.extractor = j.value("extractor", "");
+			rec.id = j.value("id", "");
+			rec.url = j.value("url", "");
+			rec.title = j.value("title", "");
+			rec.website = j.value("website", "");
+			rec.path = j.value("path", "");
+			rec.size = j.value("size", 0ull);
+			rec.time = j.value("time", 0ll);
+			for(auto kind : {key_kind::id, key_kind::url, key_kind::path})
+				if(auto k {key(kind, rec)}; !k.empty())
+					journal_keys[std::to_string(static_cast<uint32_t>(kind)) + k] = journal.size();
+			journal.push_back(std::move(rec));
+		}
+	}
+}
+
+
+void media_library::close()
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	if(journal.empty() || base.empty())
+	{
+		unmap();
+		return;
+	}
+
+	// newest first, so that a re-download of the same video (or into the same file) replaces the older record
+	std::vector<record_t> recs;
+	std::unordered_set<std::string> seen;
+	auto take = [&](record_t rec)
+	{
+		auto k_id {key(key_kind::id, rec)}, k_path {key(key_kind::path, rec)};
+		if(!k_id.empty() && seen.contains('i' + k_id) || !k_path.empty() && seen.contains('p' + k_path))
+			return;
+		if(!k_id.empty())
+			seen.insert('i' + k_id);
+		if(!k_path.empty())
+			seen.insert('p' + k_path);
+		recs.push_back(std::move(rec));
+	};
+	for(auto it {journal.rbegin()}; it != journal.rend(); it++)
+		take(*it);
+	for(size_t i {0}; hdr && i < hdr->records; i++)
+		take(disk_record(i));
+
+	uint32_t slot_count {16};
+	while(slot_count < recs.size() * 6) // up to three keys per record, at most half of the slots used
+		slot_count *= 2;
+	std::vector<slot_t> new_slots(slot_count, slot_t {0, 0, key_kind::id});
+	std::vector<disk_record_t> new_records;
+	std::string new_strings;
+	new_records.reserve(recs.size());
+	for(const auto &rec : recs)
+	{
+		auto &drec {new_records.emplace_back()};
+		drec.size = rec.size;
+		drec.time = rec.time;
+		int n {0};
+		for(auto str : {&rec.extractor, &rec.id, &rec.url, &rec.title, &rec.website, &rec.path})
+		{
+			drec.off[n] = new_strings.size();
+			drec.len[n++] = str->size();
+			new_strings += *str;
+		}
+		for(auto kind : {key_kind::id, key_kind::url, key_kind::path})
+		{
+			auto k {key(kind, rec)};
+			if(k.empty())
+				continue;
+			const auto h {hash(kind, k)};
+			auto idx {h & (slot_count - 1)};
+			while(new_slots[idx].record)
+				idx = (idx + 1) & (slot_count - 1);
+			new_slots[idx] = {h, static_cast<uint32_t>(new_records.size()), kind};
+		}
+	}
+
+	header_t header {};
+	std::copy(magic, magic + sizeof magic, header.magic);
+	header.records = new_records.size();
+	header.slots = slot_count;
+	header.strings = new_strings.size();
+
+	auto table_path {base}, temp_path {base};
+	table_path += ".bin";
+	temp_path += ".bin.tmp";
+	{
+		std::ofstream os {temp_path, std::ios::binary | std::ios::trunc};
+		os.write(reinterpret_cast<const char*>(&header), sizeof header);
+		os.write(reinterpret_cast<const char*>(new_slots.data()), new_slots.size() * sizeof(slot_t));
+		os.write(reinterpret_cast<const char*>(new_records.data()), new_records.size() * sizeof(disk_record_t));
+		os.write(new_strings.data(), new_strings.size());
+		if(!os)
+		{
+			os.close();
+			std::error_code ec;
+			fs::remove(temp_path, ec);
+			unmap();
+			return; // the journal is kept, the next run tries again
+		}
+	}
+	unmap();
+	std::error_code ec;
+	fs::rename(temp_path, table_path, ec);
+	if(ec)
+	{
+		fs::remove(temp_path, ec);
+		return;
+	}
+	auto journal_path {base};
+	journal_path += ".jsonl";
+	std::ofstream {journal_path, std::ios::trunc};
+	journal.clear();
+	journal_keys.clear();
+}
+
+
+void media_library::add(record_t rec)
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	if(base.empty())
+		return;
+	nlohmann::json j;
+	j["extractor"] = rec.extractor;
+	j["id"] = rec.id;
+	j["url"] = rec.url;
+	j["title"] = rec.title;
+	j["website"] = rec.website;
+	j["path"] = rec.path;
+	j["size"] = rec.size;
+	j["time"] = rec.time;
+	auto journal_path {base};
+	journal_path += ".jsonl";
+	if(std::ofstream os {journal_path, std::ios::app})
+		os << j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << '\n';
+
+	for(auto kind : {key_kind::id, key_kind::url, key_kind::path})
+		if(auto k {key(kind, rec)}; !k.empty())
+			journal_keys[std::to_string(static_cast<uint32_t>(kind)) + k] = journal.size();
+	journal.push_back(std::move(rec));
+}
+
+
+std::optional<media_library::record_t> media_library::find_id(const std::string &extractor, const std::string &id) const
+{
+	record_t rec;
+	rec.extractor = extractor;
+	rec.id = id;
+	return find(key_kind::id, key(key_kind::id, rec));
+}
+
+
+std::optional<media_library::record_t> media_library::find_url(const std::string &url) const
+{
+	return find(key_kind::url, url);
+}
+
+
+std::optional<media_library::record_t> media_library::find_path(const fs::path &path, unsigned long long size) const
+{
+	record_t rec;
+	const auto u8path {path.u8string()};
+	rec.path.assign(u8path.begin(), u8path.end());
+	rec.size = size;
+	return find(key_kind::path, key(key_kind::path, rec));
+}
+
+
+size_t media_library::size() const
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	return journal.size() + (hdr ? hdr->records : 0);
+}
+
+
+bool media_library::export_archive(const fs::path &file) const
+{
+	std::lock_guard<std::mutex> lock {mtx};
+	std::ofstream os {file};
+	if(!os)
+		return false;
+	// the lines of yt-dlp's archive are "<extractor key in lowercase> <video ID>"
+	std::unordered_set<std::string> written;
+	auto write = [&](const record_t &rec)
+	{
+		if(auto k {key(key_kind::id, rec)}; !k.empty() && written.insert(k).second)
+			os << k << '\n';
+	};
+	for(const auto &rec : journal)
+		write(rec);
+	for(size_t i {0}; hdr && i < hdr->records; i++)
+		write(disk_record(i));
+	return static_cast<bool>(os);
+}
+
+
+std::string media_library::youtube_id(const std::wstring &url)
+{
+	if(url.find(L"youtube.com/") == -1 && url.find(L"youtu.be/") == -1)
+		return "";
+	size_t pos {url.npos};
+	for(auto marker : {L"?v=", L"&v=", L"youtu.be/", L"/shorts/", L"/live/", L"/embed/"})
+		if((pos = url.find(marker)) != -1)
+		{
+			pos += std::wstring_view {marker}.size();
+			break;
+		}
+	if(pos == url.npos)
+		return "";
+	std::string id;
+	while(pos < url.size() && (iswalnum(url[pos]) || url[pos] == '_' || url[pos] == '-') && url[pos] < 128)
+		id += static_cast<char>(url[pos++]);
+	return id.size() == 11 ? id : "";
+}
+
+
+std::string media_library::key(key_kind kind, const record_t &rec)
+{
+	switch(kind)
+	{
+	case key_kind::id:
+		return rec.extractor.empty() || rec.id.empty() ? "" : lowercase(rec.extractor) + ' ' + rec.id;
+	case key_kind::url:
+		return rec.url;
+	case key_kind::path: // paths are case-insensitive on Windows
+		return rec.path.empty() ? "" : lowercase(rec.path) + '|' + std::to_string(rec.size);
+	}
+	return "";
+}
+
+
+uint64_t media_library::hash(key_kind kind, const std::string &key)
+{
+	// FNV-1a, seeded with the kind of key
+	uint64_t h {14695981039346656037ull ^ static_cast<uint64_t>(kind)};
+	for(unsigned char c : key)
+	{
+		h ^= c;
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+
+std::optional<media_library::record_t> media_library::find(key_kind kind, const std::string &k) const
+{
+	if(k.empty())
+		return std::nullopt;
+	std::lock_guard<std::mutex> lock {mtx};
+	if(auto it {journal_keys.find(std::to_string(static_cast<uint32_t>(kind)) + k)}; it != journal_keys.end())
+		return journal[it->second];
+	if(!hdr)
+		return std::nullopt;
+	const auto h {hash(kind, k)};
+	const auto mask {hdr->slots - 1};
+	auto idx {h & mask};
+	for(uint32_t n {0}; n < hdr->slots && slots[idx].record; n++, idx = (idx + 1) & mask)
+	{
+		if(slots[idx].hash == h && slots[idx].kind == kind && slots[idx].record <= hdr->records)
+		{
+			auto rec {disk_record(slots[idx].record - 1)};
+			if(key(kind, rec) == k)
+				return rec;
+		}
+	}
+	return std::nullopt;
+}
+
+
+media_library::record_t media_library::disk_record(size_t i) const
+{
+	const auto &drec {records[i]};
+	auto str = [&](int n) -> std::string
+	{
+		if(static_cast<unsigned long long>(drec.off[n]) + drec.len[n] > hdr->strings)
+			return "";
+		return {strings + drec.off[n], drec.len[n]};
+	};
+	record_t rec {str(0), str(1), str(2), str(3), str(4), str(5)};
+	rec.size = drec.size;
+	rec.time = drec.time;
+	return rec;
+}
+
+
+void media_library::unmap()
+{
+	if(view)
+		UnmapViewOfFile(view);
+	if(hmap)
+		CloseHandle(hmap);
+	if(hfile)
+		CloseHandle(hfile);
+	view = nullptr;
+	hmap = hfile = nullptr;
+	hdr = nullptr;
+	slots = nullptr;
+	records = nullptr;
+	strings = nullptr;
+}
+
+
+nlohmann::json playlist_cache::load(const std::wstring &url) const
+{
+	if(dir.empty())
+		return nullptr;
+	std::ifstream is {file(url)};
+	if(!is)
+		return nullptr;
+	auto j {nlohmann::json::parse(is, nullptr, false)};
+	if(j.is_discarded() || !j.is_object() || !j.contains("entries") || !j["entries"].is_array())
+		return nullptr;
+	return j;
+}
+
+
+void playlist_cache::save(const std::wstring &url, const nlohmann::json &playlist_info) const
+{
+	if(dir.empty() || !playlist_info.contains("entries"))
+		return;
+	nlohmann::json j = nlohmann::json::object();
+	for(const auto &[key, val] : playlist_info.items())
+		if(key != "entries" && key != "requested_entries")
+			j[key] = val;
+	auto &entries {j["entries"] = nlohmann::json::array()};
+	for(const auto &entry : playlist_info["entries"])
+	{
+		nlohmann::json el = nlohmann::json::object();
+		for(auto key : {"id", "url", "title", "duration"})
+			if(entry.contains(key))
+				el[key] = entry[key];
+		entries.push_back(std::move(el));
+	}
+
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+	auto path {file(url)}, temp {path};
+	temp += ".tmp";
+	if(std::ofstream os {temp}; !(os << j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace)))
+		return;
+	fs::rename(temp, path, ec);
+}
+
+
+fs::path playlist_cache::file(const std::wstring &url) const
+{
+	// FNV-1a of the URL as the file name
+	uint64_t h {14695981039346656037ull};
+	for(auto c : url)
+	{
+		h ^= static_cast<uint16_t>(c);
+		h *= 1099511628211ull;
+	}
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << h << ".json";
+	return dir / ss.str();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+
+/* Index of the finished downloads, so that a URL that was already downloaded (into any output folder) is recognized
+   when it's added to the queue, without running yt-dlp first. A record can be found by extractor + video ID, by the URL
+   it was queued as, and by its final path + size.
+
+   The index is kept in two files. "<base>.bin" is an open-addressing hash table that's memory-mapped at startup and
+   only read while the program runs. "<base>.jsonl" is a journal: each finished download is appended to it as a line
+   of JSON, and it's read into memory at startup. When the library is closed, the journal is merged into a new table
+   and emptied, so the journal stays short and the table is the only thing that grows. */
+
+class media_library
+{
+public:
+	struct record_t
+	{
+		std::string extractor, id, url, title, website, path; // extractor: "extractor_key" from the info dict; path: UTF-8
+		unsigned long long size {0};
+		long long time {0}; // when the download finished, in seconds since the epoch
+	};
+
+	~media_library() { close(); }
+	void open(const std::filesystem::path &base); // base path of the two files, without extension
+	void close(); // merges the journal into the table
+	void add(record_t rec);
+	std::optional<record_t> find_id(const std::string &extractor, const std::string &id) const;
+	std::optional<record_t> find_url(const std::string &url) const;
+	std::optional<record_t> find_path(const std::filesystem::path &path, unsigned long long size) const;
+	size_t size() const;
+	bool export_archive(const std::filesystem::path &file) const; // writes a yt-dlp --download-archive file
+	static std::string youtube_id(const std::wstring &url); // the video ID of a YouTube video URL, "" if it's not one
+
+private:
+	enum class key_kind : uint32_t { id = 1, url, path };
+
+	// on-disk layout: header, slots, records, strings (the strings of a record are referenced by offset and length)
+	struct header_t
+	{
+		char magic[8];
+		uint32_t records, slots, strings, reserved;
+	};
+	struct slot_t
+	{
+		uint64_t hash;
+		uint32_t record; // index + 1, 0 for an empty slot
+		key_kind kind;
+	};
+	struct disk_record_t
+	{
+		uint64_t size;
+		int64_t time;
+		uint32_t off[6], len[6]; // extractor, id, url, title, website, path
+	};
+	static constexpr char magic[8] {'Y', 'D', 'L', 'I', 'B', '0', '0', '1'};
+
+	static std::string key(key_kind kind, const record_t &rec);
+	static uint64_t hash(key_kind kind, const std::string &key);
+	std::optional<record_t> find(key_kind kind, const std::string &key) const;
+	record_t disk_record(size_t i) const;
+	void unmap();
+
+	std::filesystem::path base;
+	void *hfile {nullptr}, *hmap {nullptr};
+	const char *view {nullptr};
+	const header_t *hdr {nullptr};
+	const slot_t *slots {nullptr};
+	const disk_record_t *records {nullptr};
+	const char *strings {nullptr};
+
+	std::vector<record_t> journal;
+	std::unordered_map<std::string, size_t> journal_keys; // key string -> index in `journal` (the newest record wins)
+	mutable std::mutex mtx;
+};
+
+
+/* The entries of the playlists and channel tabs as they were last seen, one file per URL, so that a list can be
+   brought up to date by fetching only the entries that were added since (see GUI::sync_playlist). Only the fields
+   the program reads from the entries are kept. */
+
+class playlist_cache
+{
+public:
+	void open(const std::filesystem::path &dir_path) { dir = dir_path; }
+	nlohmann::json load(const std::wstring &url) const; // null if the list wasn't seen before
+	void save(const std::wstring &url, const nlohmann::json &playlist_info) const;
+
+private:
+	std::filesystem::path file(const std::wstring &url) const;
+	std::filesystem::path dir;
+};
@@ -56,20 +56,6 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 		{
 			fs::remove(fs::temp_directory_path() / "ytdlp-interface.exe", ec);
 		}
-		else if(first_arg == L"ytdlp_status")
-		{
-			if(argc > 3)
-			{
-				auto hwnd {reinterpret_cast<HWND>(std::stoull(argv[3], 0, 16))};
-				std::wstring url {argv[4]};
-				COPYDATASTRUCT cds;
-				cds.dwData = std::stoi(argv[2]);
-				cds.cbData = url.size()*2;
-				cds.lpData = url.data();
-				SendMessageW(hwnd, WM_COPYDATA, NULL, reinterpret_cast<LPARAM>(&cds));
-			}
-			return 0;
-		}
 		else GUI::conf.url_passed_as_arg = argv[1];
 	}
 	LocalFree(argv);
@@ -192,7 +178,6 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 				GUI::conf.output_template = to_wstring(jconf["output_template"].get<std::string>());
 				GUI::conf.max_concurrent_downloads = jconf["max_concurrent_downloads"];
 				GUI::conf.cb_lengthyproc = jconf["cb_lengthyproc"];
-				GUI::conf.max_proc_dur = std::chrono::milliseconds {jconf["max_proc_dur"].get<int>()};
 				for(auto &el : jconf["unfinished_queue_items"])
 					GUI::conf.unfinished_queue_items.push_back(el);
 				for(auto &el : jconf["outpaths"])
@@ -285,10 +270,47 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 				GUI::conf.cb_save_errors = jconf["cb_save_errors"];
 				GUI::conf.cb_ffplay = jconf["cb_ffplay"];
 			}
+			if(jconf.contains("ratelim_global"))
+			{
+				GUI::conf.cb_ratelim_global = jconf["ratelim_global"]["enabled"];
+				GUI::conf.ratelim_global = jconf["ratelim_global"]["value"];
+				GUI::conf.ratelim_global_unit = jconf["ratelim_global"]["unit"];
+			}
+			if(jconf.contains("adaptive_concurrency"))
+			{
+				GUI::conf.cb_adaptive_concurrency = jconf["adaptive_concurrency"]["enabled"];
+				GUI::conf.adaptive_min = jconf["adaptive_concurrency"]["min"];
+				GUI::conf.adaptive_max = jconf["adaptive_concurrency"]["max"];
+			}
+			if(jconf.contains("domain_limits"))
+			{
+				GUI::conf.cb_domain_limits = jconf["domain_limits"]["enabled"];
+				GUI::conf.domain_max = jconf["domain_limits"]["max"];
+				GUI::conf.domain_spacing = jconf["domain_limits"]["spacing_ms"];
+				for(auto &[domain, cap] : jconf["domain_limits"]["overrides"].items())
+					GUI::conf.domain_caps[domain] = cap.get<unsigned>();
+			}
+			if(jconf.contains("cb_load_info_json"))
+				GUI::conf.cb_load_info_json = jconf["cb_load_info_json"];
+			if(jconf.contains("cb_playlist_sync"))
+				GUI::conf.cb_playlist_sync = jconf["cb_playlist_sync"];
+			if(jconf.contains("cb_lowprio"))
+				GUI::conf.cb_lowprio = jconf["cb_lowprio"];
+			if(jconf.contains("prefetch_depth"))
+				GUI::conf.prefetch_depth = jconf["prefetch_depth"];
+			if(jconf.contains("cb_playlist_shards"))
+				GUI::conf.cb_playlist_shards = jconf["cb_playlist_shards"];
+			if(jconf.contains("concurrent_fragments"))
+			{
+				GUI::conf.cb_auto_fragments = jconf["concurrent_fragments"]["auto"];
+				GUI::conf.fragment_budget = jconf["concurrent_fragments"]["budget"];
+			}
 		}
 	}
 	else GUI::conf.outpath = util::get_sys_folder(FOLDERID_Downloads);
 
+	GUI::library.open(confpath.parent_path() / "ytdlp-interface library");
+	GUI::playlists.open(confpath.parent_path() / "ytdlp-interface playlists");
 	GUI gui;
 	gui.confpath = confpath;
 
@@ -331,7 +353,6 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 		jconf["output_template"] = to_utf8(GUI::conf.output_template);
 		jconf["max_concurrent_downloads"] = GUI::conf.max_concurrent_downloads;
 		jconf["cb_lengthyproc"] = GUI::conf.cb_lengthyproc;
-		jconf["max_proc_dur"] = GUI::conf.max_proc_dur.count();
 		jconf["unfinished_queue_items"] = GUI::conf.unfinished_queue_items;
 		jconf["common_dl_options"] = GUI::conf.common_dl_options;
 		jconf["cb_autostart"] = GUI::conf.cb_autostart;
@@ -373,6 +394,23 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 		jconf["cbminw"] = GUI::conf.cbminw;
 		jconf["cb_save_errors"] = GUI::conf.cb_save_errors;
 		jconf["cb_ffplay"] = GUI::conf.cb_ffplay;
+		jconf["ratelim_global"]["enabled"] = GUI::conf.cb_ratelim_global;
+		jconf["ratelim_global"]["value"] = GUI::conf.ratelim_global;
+		jconf["ratelim_global"]["unit"] = GUI::conf.ratelim_global_unit;
+		jconf["adaptive_concurrency"]["enabled"] = GUI::conf.cb_adaptive_concurrency;
+		jconf["adaptive_concurrency"]["min"] = GUI::conf.adaptive_min;
+		jconf["adaptive_concurrency"]["max"] = GUI::conf.adaptive_max;
+		jconf["domain_limits"]["enabled"] = GUI::conf.cb_domain_limits;
+		jconf["domain_limits"]["max"] = GUI::conf.domain_max;
+		jconf["domain_limits"]["spacing_ms"] = GUI::conf.domain_spacing;
+		jconf["domain_limits"]["overrides"] = GUI::conf.domain_caps;
+		jconf["cb_load_info_json"] = GUI::conf.cb_load_info_json;
+		jconf["cb_playlist_sync"] = GUI::conf.cb_playlist_sync;
+		jconf["cb_lowprio"] = GUI::conf.cb_lowprio;
+		jconf["prefetch_depth"] = GUI::conf.prefetch_depth;
+		jconf["cb_playlist_shards"] = GUI::conf.cb_playlist_shards;
+		jconf["concurrent_fragments"]["auto"] = GUI::conf.cb_auto_fragments;
+		jconf["concurrent_fragments"]["budget"] = GUI::conf.fragment_budget;
 
 		if(jconf.contains("sblock"))
 		{
@@ -407,5 +445,6 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int)
 
 	gui.events().unload(gui.fn_write_conf);
 	nana::exec();
+	GUI::library.close();
 	CoUninitialize();
 }
\ No newline at end of file
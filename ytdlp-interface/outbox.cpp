@@ -37,9 +37,8 @@ void GUI::Outbox::create(GUI *parent, bool visible)
 			{
 				util::set_clipboard_text(pgui->hwnd, to_wstring(text));
 
-				if(!thr.joinable()) thr = std::thread([this]
+				if(!flash.running()) flash = pgui->tasks.submit(executor::pool::io, [this](std::stop_token stop)
 				{
-					working = true;
 					auto bgclr {bgcolor()};
 					auto blendclr {theme::is_dark() ? colors::dark_orange : colors::orange};
 					std::vector<color> blended_colors;
@@ -48,7 +47,7 @@ void GUI::Outbox::create(GUI *parent, bool visible)
 					int n {0};
 					if(theme::is_dark())
 					{
-						for(auto i {blended_colors.size() / 2}; i < blended_colors.size(); i++)
+						for(auto i {blended_colors.size() / 2}; i < blended_colors.size() && !stop.stop_requested(); i++)
 						{
 							bgcolor(blended_colors[i]);
 							Sleep(90 - n);
@@ -57,17 +56,13 @@ void GUI::Outbox::create(GUI *parent, bool visible)
 					}
 					else for(const auto &clr : blended_colors)
 					{
+						if(stop.stop_requested())
+							break;
 						bgcolor(clr);
 						Sleep(90 - n);
 						n += 9;
 					}
 					bgcolor(bgclr);
-					if(working)
-					{
-						working = false;
-						if(thr.joinable())
-							thr.detach();
-					}
 				});
 			}).enabled(arg.window_handle == handle());
 
@@ -178,9 +173,15 @@ void GUI::Outbox::show(std::wstring url)
 
 void GUI::Outbox::append(std::wstring url, std::string text)
 {
+	if(!pgui->on_gui_thread())
+	{
+		pgui->ui.post_output(url, std::move(text));
+		return;
+	}
+	pgui->drain_ui(); // the output that was posted before this goes first
 	if(!empty())
 	{
-		if(!visible() && url == pgui->bottoms.current().url && pgui->bottoms.at(url).btnq.caption().find("queue") != -1)
+		if(!visible() && url == pgui->bottoms.current().url && pgui->bottoms.at(url).view->btnq.caption().find("queue") != -1)
 		{
 			widget::show();
 			pgui->overlay.hide();
@@ -252,6 +253,17 @@ void GUI::Outbox::erase(std::wstring url)
 }
 
 
+size_t GUI::Outbox::mem_size(std::wstring url) const
+{
+	size_t size {0};
+	if(auto it {buffers.find(url)}; it != buffers.end())
+		size += it->second.capacity();
+	if(auto it {commands.find(url)}; it != commands.end())
+		size += it->second.capacity();
+	return size;
+}
+
+
 void GUI::Outbox::clear(std::wstring url)
 {
 	if(url.empty())
@@ -0,0 +1,700 @@
+#include "outtmpl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#pragma warning (disable: 4267)
+
+
+namespace
+{
+	using json = nlohmann::json;
+
+	struct unsupported {}; // thrown when the template goes beyond what's implemented here
+
+	struct field_t
+	{
+		bool negate {false}, has_strf {false};
+		std::string fields, strf;
+		std::vector<std::pair<char, std::string>> maths; // {operator, number or field}
+	};
+
+	bool is_word(char c)
+	{
+		return isalnum(static_cast<unsigned char>(c)) || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+	}
+
+	size_t u8len(const std::string &str)
+	{
+		size_t len {0};
+		for(auto c : str)
+			if((c & 0xc0) != 0x80)
+				len++;
+		return len;
+	}
+
+	std::string u8prefix(const std::string &str, size_t count)
+	{
+		size_t pos {0};
+		for(; pos < str.size(); pos++)
+			if((str[pos] & 0xc0) != 0x80 && count-- == 0)
+				break;
+		return str.substr(0, pos);
+	}
+
+	std::string u8char(unsigned cp)
+	{
+		std::string out;
+		if(cp < 0x80)
+			out += static_cast<char>(cp);
+		else if(cp < 0x800)
+		{
+			out += static_cast<char>(0xc0 | cp >> 6);
+			out += static_cast<char>(0x80 | cp & 0x3f);
+		}
+		else
+		{
+			out += static_cast<char>(0xe0 | cp >> 12);
+			out += static_cast<char>(0x80 | cp >> 6 & 0x3f);
+			out += static_cast<char>(0x80 | cp & 0x3f);
+		}
+		return out;
+	}
+
+	// FIELD_RE: \w* followed by any number of .\w+ or .-?\d+ (slices and {} field sets are not supported)
+	std::string parse_fields(const std::string &key, size_t &pos)
+	{
+		auto start {pos};
+		while(pos < key.size() && is_word(key[pos]))
+			pos++;
+		while(pos + 1 < key.size() && key[pos] == '.')
+		{
+			auto p {pos + 1};
+			if(key[p] == '-') p++;
+			auto word_start {p};
+			while(p < key.size() && is_word(key[p]))
+				p++;
+			if(p == word_start)
+				break;
+			if(p < key.size() && (key[p] == ':' || key[p] == '{'))
+				throw unsupported {};
+			pos = p;
+		}
+		if(pos < key.size() && (key[pos] == ':' || key[pos] == '{'))
+			throw unsupported {};
+		return key.substr(start, pos - start);
+	}
+
+	// one alternative: -?FIELDS(OP OPERAND)*(>STRF)?
+	field_t parse_alternative(const std::string &key, size_t &pos)
+	{
+		field_t field;
+		if(pos < key.size() && key[pos] == '-')
+		{
+			field.negate = true;
+			pos++;
+		}
+		field.fields = parse_fields(key, pos);
+		while(pos < key.size() && (key[pos] == '+' || key[pos] == '-' || key[pos] == '*'))
+		{
+			auto op {key[pos++]};
+			if(pos < key.size() && key[pos] == '-')
+				throw unsupported {};
+			auto operand {parse_fields(key, pos)};
+			if(operand.empty())
+				throw unsupported {};
+			field.maths.emplace_back(op, operand);
+		}
+		if(pos < key.size() && key[pos] == '>')
+		{
+			field.has_strf = true;
+			auto start {++pos};
+			while(pos < key.size() && key[pos] != '&' && key[pos] != '|' && !(key[pos] == ',' && key[pos - 1] != '\\'))
+				pos++;
+			if(pos == start)
+				throw unsupported {};
+			field.strf = key.substr(start, pos - start);
+			for(auto p {field.strf.find("\\,")}; p != -1; p = field.strf.find("\\,", p))
+				field.strf.erase(p, 1);
+		}
+		return field;
+	}
+
+	// Python's float(), as used by yt-dlp's float_or_none()
+	bool float_or_none(const json &val, double &out)
+	{
+		if(val.is_number())
+			out = val.get<double>();
+		else if(val.is_boolean())
+			out = val.get<bool>();
+		else if(val.is_string())
+		{
+			auto str {val.get<std::string>()};
+			auto first {str.find_first_not_of(" \t\r\n")}, last {str.find_last_not_of(" \t\r\n")};
+			if(first == -1)
+				return false;
+			str = str.substr(first, last - first + 1);
+			if(str.find_first_not_of("0123456789+-.eE") != -1)
+				return false;
+			char *end {nullptr};
+			out = strtod(str.data(), &end);
+			if(end != str.data() + str.size())
+				return false;
+		}
+		else return false;
+		return true;
+	}
+
+	// Python's str()
+	std::string py_str(const json &val)
+	{
+		if(val.is_string())
+			return val.get<std::string>();
+		if(val.is_boolean())
+			return val.get<bool>() ? "True" : "False";
+		if(val.is_number())
+			return val.dump();
+		throw unsupported {};
+	}
+
+	json traverse(const json &info, const json &overrides, const std::string &fields)
+	{
+		std::vector<std::string> keys;
+		for(size_t pos {0}, next {0}; next != -1; pos = next + 1)
+		{
+			next = fields.find('.', pos);
+			keys.push_back(fields.substr(pos, next == -1 ? -1 : next - pos));
+		}
+		if(!keys.empty() && keys.front().empty())
+			keys.erase(keys.begin());
+		if(!keys.empty() && keys.back().empty())
+			keys.pop_back();
+		if(keys.empty())
+			throw unsupported {}; // the whole info dict
+
+		if(keys.front() == "autonumber" || keys.front() == "video_autonumber")
+			throw unsupported {}; // counters of the yt-dlp process
+
+		const json *obj {overrides.is_object() && overrides.contains(keys.front()) ? &overrides : &info};
+		json str_char;
+		for(const auto &key : keys)
+		{
+			const bool is_int {key.find_first_not_of("-0123456789") == -1 && key.find_first_of("0123456789") != -1};
+			if(obj->is_object())
+			{
+				auto it {obj->find(key)};
+				if(is_int || it == obj->end())
+					return nullptr;
+				obj = &*it;
+			}
+			else if((obj->is_array() || obj->is_string()) && is_int)
+			{
+				long long idx {std::stoll(key)};
+				if(obj->is_array())
+				{
+					long long size = obj->size();
+					if(idx < 0) idx += size;
+					if(idx < 0 || idx >= size)
+						return nullptr;
+					obj = &(*obj)[static_cast<size_t>(idx)];
+				}
+				else
+				{
+					// strings are indexed by code point
+					auto str {obj->get<std::string>()};
+					long long size = u8len(str);
+					if(idx < 0) idx += size;
+					if(idx < 0 || idx >= size)
+						return nullptr;
+					auto rest {str.substr(u8prefix(str, static_cast<size_t>(idx)).size())};
+					str_char = u8prefix(rest, 1);
+					obj = &str_char;
+				}
+			}
+			else return nullptr;
+		}
+		return *obj;
+	}
+
+	// days since 1970-01-01 -> civil date (Howard Hinnant's algorithm)
+	void civil_from_days(long long z, int &y, unsigned &m, unsigned &d)
+	{
+		z += 719468;
+		const long long era {(z >= 0 ? z : z - 146096) / 146097};
+		const unsigned doe {static_cast<unsigned>(z - era * 146097)};
+		const unsigned yoe {(doe - doe / 1460 + doe / 36524 - doe / 146096) / 365};
+		const unsigned doy {doe - (365 * yoe + yoe / 4 - yoe / 100)};
+		const unsigned mp {(5 * doy + 2) / 153};
+		d = doy - (153 * mp + 2) / 5 + 1;
+		m = mp < 10 ? mp + 3 : mp - 9;
+		y = static_cast<int>(yoe + era * 400 + (m <= 2));
+	}
+
+	long long days_from_civil(int y, unsigned m, unsigned d)
+	{
+		y -= m <= 2;
+		const long long era {(y >= 0 ? y : y - 399) / 400};
+		const unsigned yoe {static_cast<unsigned>(y - era * 400)};
+		const unsigned doy {(153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1};
+		const unsigned doe {yoe * 365 + yoe / 4 - yoe / 100 + doy};
+		return era * 146097 + doe - 719468;
+	}
+
+	// yt-dlp's strftime_or_none: unix timestamps (UTC) and YYYYMMDD strings; locale-independent English names
+	json strftime_or_none(const json &val, const std::string &fmt)
+	{
+		long long days {0}, secs {0};
+		double ts {0};
+		if(val.is_number())
+		{
+			ts = std::floor(val.get<double>());
+			days = static_cast<long long>(std::floor(ts / 86400));
+			secs = static_cast<long long>(ts - days * 86400.0);
+		}
+		else if(val.is_string())
+		{
+			auto str {val.get<std::string>()};
+			if(str.size() != 8 || str.find_first_not_of("0123456789") != -1)
+				return nullptr;
+			int y {std::stoi(str.substr(0, 4))};
+			unsigned m = std::stoi(str.substr(4, 2)), d = std::stoi(str.substr(6, 2));
+			static const unsigned mdays[] {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+			if(y < 1 || m < 1 || m > 12 || d < 1 || d > mdays[m - 1] ||
+				m == 2 && d == 29 && (y % 4 || y % 100 == 0 && y % 400))
+				return nullptr;
+			days = days_from_civil(y, m, d);
+		}
+		else return nullptr;
+
+		int y;
+		unsigned m, d;
+		civil_from_days(days, y, m, d);
+		const unsigned H = secs / 3600, M = secs / 60 % 60, S = secs % 60,
+			wday = static_cast<unsigned>(((days % 7) + 11) % 7), // 0 = Sunday
+			yday = static_cast<unsigned>(days - days_from_civil(y, 1, 1) + 1);
+		static const char *months[] {"January", "February", "March", "April", "May", "June", "July", "August", "September",
+			"October", "November", "December"};
+		static const char *weekdays[] {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+
+		auto num = [](long long n, int digits)
+		{
+			auto str {std::to_string(n)};
+			if(str.size() < digits)
+				str.insert(0, digits - str.size(), '0');
+			return str;
+		};
+
+		std::string out;
+		for(size_t i {0}; i < fmt.size(); i++)
+		{
+			if(fmt[i] != '%')
+			{
+				out += fmt[i];
+				continue;
+			}
+			if(++i == fmt.size())
+				throw unsupported {};
+			switch(fmt[i])
+			{
+			case 'Y': out += num(y, 4); break;
+			case 'y': out += num(y % 100, 2); break;
+			case 'm': out += num(m, 2); break;
+			case 'd': out += num(d, 2); break;
+			case 'H': out += num(H, 2); break;
+			case 'I': out += num(H % 12 ? H % 12 : 12, 2); break;
+			case 'M': out += num(M, 2); break;
+			case 'S': out += num(S, 2); break;
+			case 'p': out += H < 12 ? "AM" : "PM"; break;
+			case 'j': out += num(yday, 3); break;
+			case 'B': out += months[m - 1]; break;
+			case 'b': out += std::string {months[m - 1]}.substr(0, 3); break;
+			case 'A': out += weekdays[wday]; break;
+			case 'a': out += std::string {weekdays[wday]}.substr(0, 3); break;
+			case '%': out += '%'; break;
+			default: throw unsupported {};
+			}
+		}
+		return out;
+	}
+
+	json get_value(const json &info, const json &overrides, const field_t &field)
+	{
+		json val = traverse(info, overrides, field.fields);
+		double num;
+		if(field.negate)
+			val = float_or_none(val, num) ? json(-num) : json(nullptr);
+		if(!field.maths.empty())
+		{
+			if(!float_or_none(val, num))
+				return nullptr;
+			for(const auto &[op, operand] : field.maths)
+			{
+				double offset;
+				if(!float_or_none(json(operand), offset) && !float_or_none(traverse(info, overrides, operand), offset))
+					return nullptr;
+				num = op == '+' ? num + offset : op == '-' ? num - offset : num * offset;
+			}
+			val = num;
+		}
+		if(field.has_strf)
+			val = strftime_or_none(val, field.strf);
+		if(val.is_string() && val.get<std::string>().empty())
+			return nullptr;
+		return val;
+	}
+
+	// Python's str.format() with the value as the only positional argument; only "{}" and "{0}" are supported
+	std::string format_replacement(const std::string &repl, const std::string &value)
+	{
+		std::string out;
+		for(size_t i {0}; i < repl.size(); i++)
+		{
+			if(repl[i] == '{')
+			{
+				if(i + 1 < repl.size() && repl[i + 1] == '{')
+				{
+					out += '{';
+					i++;
+					continue;
+				}
+				auto end {repl.find('}', i)};
+				if(end == -1)
+					throw unsupported {};
+				auto name {repl.substr(i + 1, end - i - 1)};
+				if(!name.empty() && name.find_first_not_of("0123456789") != -1)
+					throw unsupported {};
+				if(!name.empty() && std::stoi(name) != 0)
+					throw unsupported {};
+				out += value;
+				i = end;
+			}
+			else if(repl[i] == '}')
+			{
+				if(i + 1 < repl.size() && repl[i + 1] == '}')
+					i++;
+				out += '}';
+			}
+			else out += repl[i];
+		}
+		return out;
+	}
+
+	std::string pad(std::string str, const std::string &flags, size_t width)
+	{
+		auto len {u8len(str)};
+		if(width > len)
+		{
+			if(flags.find('-') != -1)
+				str.append(width - len, ' ');
+			else str.insert(0, width - len, ' ');
+		}
+		return str;
+	}
+
+	// one "%(key)<format>" conversion, as done by yt-dlp's create_key() and then Python's % operator
+	std::string convert(const json &info, const json &overrides, const std::string &key, std::string flags, size_t width,
+		int precision, char type)
+	{
+		// -FIELDS... (,ALTERNATIVE)* (&REPLACEMENT)? (|DEFAULT)?
+		std::vector<field_t> alternatives;
+		std::string replacement, default_val {"NA"};
+		bool has_replacement {false};
+		size_t pos {0};
+		alternatives.push_back(parse_alternative(key, pos));
+		while(pos < key.size() && key[pos] == ',')
+		{
+			pos++;
+			alternatives.push_back(parse_alternative(key, pos));
+		}
+		if(pos < key.size() && key[pos] == '&')
+		{
+			has_replacement = true;
+			auto end {key.find('|', pos)};
+			replacement = key.substr(pos + 1, end == -1 ? -1 : end - pos - 1);
+			pos = end == -1 ? key.size() : end;
+		}
+		if(pos < key.size() && key[pos] == '|')
+		{
+			default_val = key.substr(pos + 1);
+			pos = key.size();
+		}
+		if(pos != key.size())
+			throw unsupported {};
+
+		json val;
+		std::string last_field;
+		for(const auto &alt : alternatives)
+		{
+			val = get_value(info, overrides, alt);
+			last_field = alt.fields;
+			if(!val.is_null())
+				break;
+		}
+
+		if(!val.is_null() && has_replacement)
+			val = format_replacement(replacement, py_str(val));
+
+		if(type == 's' && val.is_number_integer() &&
+			(last_field == "playlist_index" || last_field == "playlist_autonumber" || last_field == "autonumber"))
+			throw unsupported {}; // padded to the size of the playlist, which the info dict doesn't tell
+
+		bool sanitize {false};
+		double num {0};
+		if(val.is_null())
+		{
+			val = default_val;
+			type = 's';
+			flags.clear(), width = 0, precision = -1;
+		}
+		else if(type == 'S')
+		{
+			if(flags.find('#') != -1)
+				throw unsupported {}; // restricted filenames
+			val = outtmpl::sanitize_filename(py_str(val));
+			type = 's';
+		}
+		else if(type == 'c')
+		{
+			if(val.is_string() && !val.get<std::string>().empty() || val.is_number() && val != 0 || val.is_boolean() && val.get<bool>())
+				val = u8prefix(py_str(val), 1);
+			else type = 's';
+		}
+		else if(type != 's')
+		{
+			if(!float_or_none(val, num))
+			{
+				val = default_val;
+				type = 's';
+				flags.clear(), width = 0, precision = -1;
+			}
+		}
+		if(type == 's' || type == 'c')
+			sanitize = true;
+
+		if(sanitize)
+		{
+			auto str {outtmpl::sanitize_filename(py_str(val))};
+			if(precision >= 0 && type == 's')
+				str = u8prefix(str, precision);
+			return pad(str, flags, width);
+		}
+
+		if(type == 'd' || type == 'i')
+		{
+			if(!std::isfinite(num) || std::fabs(num) >= 9e18)
+				throw unsupported {};
+			std::erase(flags, '#');
+			std::string fmt {'%' + flags + (width ? std::to_string(width) : "") +
+				(precision >= 0 ? '.' + std::to_string(precision) : "") + "lld"};
+			char buf[128];
+			snprintf(buf, sizeof buf, fmt.data(), static_cast<long long>(std::trunc(num)));
+			return buf;
+		}
+		std::string fmt {'%' + flags + (width ? std::to_string(width) : "") +
+			(precision >= 0 ? '.' + std::to_string(precision) : "") + type};
+		char buf[512];
+		if(width > 256 || precision > 100 || !std::isfinite(num))
+			throw unsupported {};
+		snprintf(buf, sizeof buf, fmt.data(), num);
+		return buf;
+	}
+}
+
+
+std::string outtmpl::evaluate(const std::string &tmpl, const nlohmann::json &info, const nlohmann::json &overrides)
+{
+	// environment variables and "~" are expanded by yt-dlp before the fields
+	if(tmpl.find('$') != -1 || tmpl.starts_with('~'))
+		return "";
+
+	std::string out;
+	try
+	{
+		for(size_t i {0}; i < tmpl.size(); i++)
+		{
+			if(tmpl[i] != '%' || i + 1 == tmpl.size() || tmpl[i + 1] != '%' && tmpl[i + 1] != '(')
+			{
+				out += tmpl[i];
+				continue;
+			}
+			if(tmpl[i + 1] == '%')
+			{
+				out += '%';
+				i++;
+				continue;
+			}
+
+			auto end {tmpl.find(')', i)};
+			if(end == -1)
+				return "";
+			auto key {tmpl.substr(i + 2, end - i - 2)};
+			auto pos {end + 1};
+			std::string flags;
+			while(pos < tmpl.size() && std::string {"#0- +"}.find(tmpl[pos]) != -1)
+				flags += tmpl[pos++];
+			size_t width {0};
+			while(pos < tmpl.size() && isdigit(static_cast<unsigned char>(tmpl[pos])))
+				width = width * 10 + tmpl[pos++] - '0';
+			int precision {-1};
+			if(pos < tmpl.size() && tmpl[pos] == '.')
+			{
+				precision = 0;
+				while(++pos < tmpl.size() && isdigit(static_cast<unsigned char>(tmpl[pos])))
+					precision = precision * 10 + tmpl[pos] - '0';
+			}
+			if(pos < tmpl.size() && (tmpl[pos] == 'h' || tmpl[pos] == 'l' || tmpl[pos] == 'L'))
+				pos++;
+			if(pos == tmpl.size() || std::string {"diceEfFgGsS"}.find(tmpl[pos]) == -1)
+				return ""; // o, x, X, r, a, l, j, h, q, B, U, D, or a malformed template
+			out += convert(info, overrides, key, flags, width, precision, tmpl[pos]);
+			i = pos;
+		}
+	}
+	catch(...) { return ""; }
+	return out;
+}
+
+
+std::string outtmpl::sanitize_filename(const std::string &str)
+{
+	if(str.empty())
+		return "";
+
+	std::string result;
+	for(size_t i {0}; i < str.size(); i++)
+	{
+		const unsigned char c = str[i];
+		if(c == ':')
+		{
+			// timestamps: the colons of "1:23:45" become underscores
+			auto prev {i ? str[i - 1] : 0}, next {i + 1 < str.size() ? str[i + 1] : 0};
+			if(isdigit(static_cast<unsigned char>(prev)) && isdigit(static_cast<unsigned char>(next)))
+			{
+				result += '_';
+				continue;
+			}
+		}
+		if(c == '\n')
+			result += std::string {'\0', ' '};
+		else if(c == '/')
+			result += u8char(0x29f8);
+		else if(c == '\\')
+			result += u8char(0x29f9);
+		else if(std::string {"\"*:<>?|"}.find(c) != -1)
+			result += u8char(c + 0xfee0); // full-width counterparts
+		else if(c < 32 || c == 127)
+			continue;
+		else result += c;
+	}
+
+	// the newline substitutes: repeats are merged, and they're removed from the ends along with adjacent " _-"
+	if(result.find('\0') != -1)
+	{
+		std::string merged;
+		for(size_t i {0}; i < result.size(); i++)
+		{
+			if(result[i] == '\0' && merged.size() >= 2 && merged[merged.size() - 2] == '\0' && merged.back() == result[i + 1])
+			{
+				i++;
+				continue;
+			}
+			merged += result[i];
+		}
+		result = merged;
+
+		auto is_strip = [](char c) { return c == ' ' || c == '_' || c == '-'; };
+		if(result.size() >= 2 && result[0] == '\0')
+		{
+			size_t pos {2};
+			while(pos < result.size())
+			{
+				if(result[pos] == '\0' && pos + 1 < result.size())
+					pos += 2;
+				else if(is_strip(result[pos]))
+					pos++;
+				else break;
+			}
+			result.erase(0, pos);
+		}
+		if(result.size() >= 2 && result[result.size() - 2] == '\0')
+		{
+			auto pos {result.size() - 2};
+			while(pos)
+			{
+				if(pos >= 2 && result[pos - 2] == '\0')
+					pos -= 2;
+				else if(is_strip(result[pos - 1]))
+					pos--;
+				else break;
+			}
+			result.erase(pos);
+		}
+		std::erase(result, '\0');
+	}
+	return result.empty() ? "_" : result;
+}
+
+
+std::string outtmpl::sanitize_path(const std::string &path)
+{
+	auto normed {path};
+	std::replace(normed.begin(), normed.end(), '/', '\\');
+
+	std::string root, rest;
+	std::vector<std::string> parts;
+	if(normed.starts_with("\\\\"))
+	{
+		// UNC path (\\server\share) or device path (\\.\, \\?\)
+		size_t pos {0};
+		for(int n {0}; n < 4 && pos != -1; n++)
+			pos = normed.find('\\', pos + (n > 0));
+		if(pos == -1)
+			return normed;
+		root = normed.substr(0, pos + 1);
+		rest = normed.substr(pos + 1);
+	}
+	else if(normed.size() > 1 && normed[1] == ':')
+	{
+		auto offset {normed.size() > 2 && normed[2] == '\\' ? 3 : 2};
+		root = normed.substr(0, offset);
+		rest = normed.substr(offset);
+	}
+	else
+	{
+		root = normed.starts_with('\\') ? "\\" : "";
+		rest = normed;
+	}
+
+	for(size_t pos {0}, next {0}; next != -1; pos = next + 1)
+	{
+		next = rest.find('\\', pos);
+		auto part {rest.substr(pos, next == -1 ? -1 : next - pos)};
+		if(part.empty() || part == ".")
+			continue;
+		if(part == "..")
+		{
+			if(!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else parts.push_back(part);
+			continue;
+		}
+		// invalid characters, and a trailing dot or space, are replaced with '#'
+		for(auto &c : part)
+			if(std::string {"<>:\"|?*"}.find(c) != -1)
+				c = '#';
+		if(part.back() == '.' || isspace(static_cast<unsigned char>(part.back())))
+			part.back() = '#';
+		parts.push_back(part);
+	}
+
+	std::string out {root};
+	for(const auto &part : parts)
+	{
+		if(out.size() > root.size())
+			out += '\\';
+		out += part;
+	}
+	return out.empty() ? "." : out;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <string>
+
+/* Local evaluation of yt-dlp output templates (-o), so the program knows where a download ends up without asking
+   yt-dlp or probing the filesystem. It follows yt-dlp's prepare_outtmpl/prepare_filename as they run on Windows
+   (default sanitization rules, "NA" as the placeholder for missing fields), for this subset of the syntax:
+   dotted field traversal, negation, maths (+ - *), date formatting (>), alternatives (,), replacement (&), default
+   (|), and the conversions d, i, e, E, f, F, g, G, c, s and S with their flags/width/precision. */
+
+namespace outtmpl
+{
+	// Evaluates the template against an info dict (the JSON printed by "yt-dlp -j"); fields in `overrides` take
+	// precedence over the ones in `info`. Returns an empty string if the template uses something outside the
+	// subset above, so that the caller can fall back to something else instead of acting on a wrong guess.
+	std::string evaluate(const std::string &tmpl, const nlohmann::json &info, const nlohmann::json &overrides = {});
+	std::string sanitize_filename(const std::string &str); // yt-dlp's rules for field values (no --restrict-filenames)
+	std::string sanitize_path(const std::string &path); // yt-dlp's rules for the whole path on Windows
+}
@@ -1,5 +1,6 @@
 ﻿#include "gui.hpp"
 #include <codecvt>
+#include <nana/gui/filebox.hpp>
 
 
 void GUI::make_queue_listbox()
@@ -24,6 +25,21 @@ void GUI::make_queue_listbox()
 	lbq.column_at(5).visible(conf.col_format_note);
 	lbq.column_at(6).visible(conf.col_ext);
 	lbq.column_at(7).visible(conf.col_fsize);
+	/* the rows are the records of queue_items: the listbox asks for the text of a row only when it draws it, so an
+	   item that changes costs a redraw of the visible rows, and removing one doesn't rewrite the "#" of the others */
+	lbq.at(0).model<std::recursive_mutex>(lbq_rows {},
+		[](const std::vector<listbox::cell> &) -> lbq_rows::value_type
+		{
+			return nullptr; // the rows are never written through the listbox, only redrawn (see lbq_update)
+		},
+		[this](const lbq_rows::value_type &pqi)
+		{
+			std::vector<listbox::cell> cells;
+			if(pqi)
+				for(auto &text : queue_items.row(*pqi))
+					cells.emplace_back(std::move(text));
+			return cells;
+		});
 	lbq.at(0).inline_factory(1, pat::make_factory<inline_widget>());
 
 	lbq.events().resized([this](const arg_resized &arg) { adjust_lbq_headers(); });
@@ -144,116 +160,73 @@ void GUI::make_queue_listbox()
 			auto hovered {lbq.cast({arg.pos.x, arg.pos.y})}, selected {selection[0]};
 			if(hovered.item != npos && hovered.item != selected.item)
 			{
-				std::string seltext0 {lb.at(selected.item).text(0)},
-					seltext1 {lb.at(selected.item).text(1)},
-					seltext2 {lb.at(selected.item).text(2)},
-					seltext3 {lb.at(selected.item).text(3)},
-					seltext4 {lb.at(selected.item).text(4)},
-					seltext5 {lb.at(selected.item).text(5)},
-					seltext6 {lb.at(selected.item).text(6)},
-					seltext7 {lb.at(selected.item).text(7)};
-
-				lbqval_t selval {lb.at(selected.item).value<lbqval_t>()};
-				std::string sel_favicon_url {lbq.favicon_url_from_value(selval)};
-
-				auto hovitem {lb.at(hovered.item)};
-
-				// moving item upward, pushing list downward below insertion point
-				if(hovered.item < selected.item)
+				const auto from {selected.item}, to {hovered.item};
+				queue_items.move(from, to);
+
+				// the rows and their values (URL and favicon) move along with the items
 				{
-					for(auto n {selected.item}; n > hovered.item; n--)
+					auto guard {lb.model()};
+					auto &rows {guard.container<lbq_rows>()};
+					if(from < to)
+						std::rotate(rows.begin() + from, rows.begin() + from + 1, rows.begin() + to + 1);
+					else std::rotate(rows.begin() + to, rows.begin() + from, rows.begin() + from + 1);
+				}
+				lbqval_t selval {lb.at(from).value<lbqval_t>()};
+				if(to < from)
+					for(auto n {from}; n > to; n--)
+						lb.at(n).value(lb.at(n - 1).value<lbqval_t>());
+				else for(auto n {from}; n < to; n++)
+					lb.at(n).value(lb.at(n + 1).value<lbqval_t>());
+				lb.at(to).value(selval);
+				item_caption(queue_items.at(to).url);
+
+				for(auto n {std::min(from, to)}; n <= std::max(from, to); n++)
+				{
+					if(n != to)
 					{
-						const auto &val {lb.at(n - 1).value<lbqval_t>()};
-						lb.at(n).value(val);
-						lb.at(n).text(1, lb.at(n - 1).text(1));
-						lb.at(n).text(2, lb.at(n - 1).text(2));
-						lb.at(n).text(3, lb.at(n - 1).text(3));
-						lb.at(n).text(4, lb.at(n - 1).text(4));
-						lb.at(n).text(5, lb.at(n - 1).text(5));
-						lb.at(n).text(6, lb.at(n - 1).text(6));
-						lb.at(n).text(7, lb.at(n - 1).text(7));
-						if(!conf.common_dl_options)
-							bottoms.at(val).gpopt.caption("Download options for queue item #" + lb.at(n).text(0));
 						lb.at(n).fgcolor(lbq.fgcolor());
 						lb.at(n).select(false);
 					}
-					if(autoscroll)
+				}
+
+				if(autoscroll)
+				{
+					// moving an item upward scrolls up near the top edge, moving it downward scrolls down near the bottom edge
+					if(to < from && arg.pos.y / util::scale(27) <= 2)
 					{
-						if(arg.pos.y / util::scale(27) <= 2)
+						if(!scroll_up_timer.started())
 						{
-							if(!scroll_up_timer.started())
-							{
-								scroll_up_timer.elapse([&arg] {mouse_event(MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_WHEEL, arg.pos.x, arg.pos.y, WHEEL_DELTA, 0); });
-								scroll_up_timer.interval(delay);
-								if(scroll_down_timer.started()) scroll_down_timer.stop();
-								lbq.scheme().mouse_wheel.lines = lines;
-								scroll_up_timer.start();
-							}
-						}
-						else
-						{
-							if(scroll_up_timer.started()) scroll_up_timer.stop();
+							scroll_up_timer.elapse([&arg] {mouse_event(MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_WHEEL, arg.pos.x, arg.pos.y, WHEEL_DELTA, 0); });
+							scroll_up_timer.interval(delay);
 							if(scroll_down_timer.started()) scroll_down_timer.stop();
 							lbq.scheme().mouse_wheel.lines = lines;
+							scroll_up_timer.start();
 						}
 					}
-				}
-
-				// moving item downward, pushing list upward above insertion point
-				else
-				{
-					for(auto n(selected.item); n < hovered.item; n++)
-					{
-						const auto &val {lb.at(n + 1).value<lbqval_t>()};
-						lb.at(n).value(val);
-						lb.at(n).text(1, lb.at(n + 1).text(1));
-						lb.at(n).text(2, lb.at(n + 1).text(2));
-						lb.at(n).text(3, lb.at(n + 1).text(3));
-						lb.at(n).text(4, lb.at(n + 1).text(4));
-						lb.at(n).text(5, lb.at(n + 1).text(5));
-						lb.at(n).text(6, lb.at(n + 1).text(6));
-						lb.at(n).text(7, lb.at(n + 1).text(7));
-						if(!conf.common_dl_options)
-							bottoms.at(val).gpopt.caption("Download options for queue item #" + lb.at(n).text(0));
-						lb.at(n).fgcolor(lbq.fgcolor());
-						lb.at(n).select(false);
-					}
-					if(autoscroll)
+					else if(to > from && arg.pos.y > lbq.size().height - 2 * util::scale(27))
 					{
-						if(arg.pos.y > lbq.size().height - 2 * util::scale(27))
+						if(!scroll_down_timer.started())
 						{
-							if(!scroll_down_timer.started())
+							scroll_down_timer.elapse([&arg]
 							{
-								scroll_down_timer.elapse([&arg]
-								{
-									mouse_event(MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_WHEEL, arg.pos.x, arg.pos.y, -WHEEL_DELTA, 0);
-								});
-								scroll_down_timer.interval(delay);
-								if(scroll_up_timer.started()) scroll_up_timer.stop();
-								lbq.scheme().mouse_wheel.lines = lines;
-								scroll_down_timer.start();
-							}
-						}
-						else
-						{
+								mouse_event(MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_WHEEL, arg.pos.x, arg.pos.y, -WHEEL_DELTA, 0);
+							});
+							scroll_down_timer.interval(delay);
 							if(scroll_up_timer.started()) scroll_up_timer.stop();
-							if(scroll_down_timer.started()) scroll_down_timer.stop();
 							lbq.scheme().mouse_wheel.lines = lines;
+							scroll_down_timer.start();
 						}
 					}
+					else
+					{
+						if(scroll_up_timer.started()) scroll_up_timer.stop();
+						if(scroll_down_timer.started()) scroll_down_timer.stop();
+						lbq.scheme().mouse_wheel.lines = lines;
+					}
 				}
-				hovitem.value(selval);
-				hovitem.text(1, seltext1);
-				hovitem.text(2, seltext2);
-				hovitem.text(3, seltext3);
-				hovitem.text(4, seltext4);
-				hovitem.text(5, seltext5);
-				hovitem.text(6, seltext6);
-				hovitem.text(7, seltext7);
+				auto hovitem {lb.at(to)};
 				hovitem.select(true);
 				hovitem.fgcolor(dragging_color);
-				if(!conf.common_dl_options)
-					bottoms.at(selval).gpopt.caption("Download options for queue item #" + lb.at(lbq.selected().front().item).text(0));
 				lbq.auto_draw(true);
 			}
 		}
@@ -279,8 +252,7 @@ void GUI::make_queue_listbox()
 			conf.max_concurrent_downloads = temp;
 			if(!first_startable_url.empty())
 			{
-				auto first_startable_item {lbq.item_from_value(first_startable_url)};
-				if(stoi(selitem.text(0)) > stoi(first_startable_item.text(0)))
+				if(sel[0].item > queue_items.pos(first_startable_url))
 				{
 					autostart_next_item = false;
 					process_queue_item(curbot.url);
@@ -292,16 +264,12 @@ void GUI::make_queue_listbox()
 		else
 		{
 			std::wstring last_downloading_url;
-			for(auto item : lbq.at(0))
-			{
-				auto &bot {bottoms.at(item.value<lbqval_t>())};
-				if(bot.started())
-					last_downloading_url = bot.url;
-			}
+			for(auto &item : queue_items)
+				if(bottoms.at(item->url).started())
+					last_downloading_url = item->url;
 			if(!last_downloading_url.empty())
 			{
-				auto last_downloading_item {lbq.item_from_value(last_downloading_url)};
-				if(stoi(selitem.text(0)) < stoi(last_downloading_item.text(0)))
+				if(sel[0].item < queue_items.pos(last_downloading_url))
 				{
 					autostart_next_item = false;
 					process_queue_item(last_downloading_url);
@@ -345,40 +313,38 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 	::widgets::Menu m;
 	m.item_pixels(dpi_transform(24));
 	auto sel {lbq.selected()};
-	if(!sel.empty() && !thr_menu.joinable())
+	if(!sel.empty() && !menu_task.running())
 	{
 		if(sel.size() == 1)
 		{
-			auto item {lbq.at(sel.front())};
-			auto item_name {"item #" + item.text(0)};
-			auto url {item.value<lbqval_t>().url};
+			using status = queue_model::status;
+			auto url {lbq.at(sel.front()).value<lbqval_t>().url};
+			auto item_name {"item #" + std::to_string(queue_items.pos(url) + 1)};
+			const auto item_state {queue_items.find(url)->state};
+			const auto item_title {queue_items.find(url)->title};
 			auto &bottom {bottoms.current()};
 			const auto is_live {bottom.vidinfo_contains("is_live") && bottom.vidinfo["is_live"] ||
 							   bottom.vidinfo_contains("live_status") && bottom.vidinfo["live_status"] == "is_live"};
-			static std::vector<drawerbase::listbox::item_proxy> stoppable, startable;
-			static std::vector<std::wstring> completed;
+			static std::vector<std::wstring> stoppable, startable, completed;
 			stoppable.clear();
 			startable.clear();
 			completed.clear();
-			for(auto &item : lbq.at(0))
+			for(auto &item : queue_items)
 			{
-				const auto text {item.text(3)};
-				if(text == "done")
-					completed.push_back(item.value<lbqval_t>().url);
-				else if(text.find("stopped") == -1 && text.find("queued") == -1 && text.find("error") == -1)
-					stoppable.push_back(item);
-				else startable.push_back(item);
+				if(item->state == status::done)
+					completed.push_back(item->url);
+				else if(item->startable() || item->state == status::error)
+					startable.push_back(item->url);
+				else stoppable.push_back(item->url);
 			}
 
-			auto verb {bottom.btndl.caption().substr(0, 5)};
-			if(verb.back() == ' ')
-				verb.pop_back();
-			if(item.text(3).find("stopped") != -1)
+			std::string verb {bottom.started() ? "Stop" : "Start"};
+			if(item_state == status::stopped)
 				verb = "Resume";
 			m.append(verb + " " + item_name, [&, url, this](menu::item_proxy)
 			{
 				on_btn_dl(url);
-				api::refresh_window(bottom.btndl);
+				bottom.refresh_btndl();
 			});
 			m.append("Remove " + item_name, [&, url, this](menu::item_proxy)
 			{
@@ -390,11 +356,7 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 			{
 				file = bottom.file_path();
 				if(!file.empty())
-				{
-					if(fs::exists(file))
-						m.append_splitter();
-					else file.clear();
-				}
+					m.append_splitter();
 			}
 
 			m.append("Open folder of " + item_name, [&, file, this](menu::item_proxy)
@@ -424,7 +386,13 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 				ShellExecuteW(NULL, L"open", file.wstring().data(), NULL, NULL, SW_NORMAL);
 			});
 
-			if(item.text(3) != "error")
+			if(bottom.from_library) m.append("Get media info", [&, url, this](menu::item_proxy)
+			{
+				queue_status(url, status::queued);
+				add_url(url, true);
+			});
+
+			if(item_state != status::error)
 			{
 				m.append_splitter();
 				if(bottom.is_ytplaylist || bottom.is_bcplaylist)
@@ -449,9 +417,9 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 					{
 						bottom.is_ytplaylist = true;
 						add_url(url, true);
-					}).enabled(item.text(2) != "...");
+					}).enabled(item_title != "...");
 				}
-				else if(!bottom.is_ytchan && !bottom.is_bcchan && !is_live && item.text(2).find("[live event scheduled to begin in") != 0)
+				else if(!bottom.is_ytchan && !bottom.is_bcchan && !is_live && item_title.find("[live event scheduled to begin in") != 0)
 				{
 					m.append("Download sections", [this](menu::item_proxy)
 					{
@@ -459,7 +427,7 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 					});
 				}
 
-				if(item.text(2) == "..." && !bottom.is_ytchan)
+				if(item_title == "..." && !bottom.is_ytchan)
 					m.append("Select formats", [this](menu::item_proxy) { fm_formats(); }).enabled(false);
 				else if(bottom.btnfmt_visible())
 				{
@@ -478,7 +446,7 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 					vidsel_item = {&m, vidsel_item.pos};
 			}
 
-			if(lbq.at(0).size() > 1)
+			if(queue_items.size() > 1)
 			{
 				m.append_splitter();
 				if(!completed.empty())
@@ -488,60 +456,52 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 						lbq.auto_draw(false);
 						autostart_next_item = false;
 						for(auto &url : completed)
-						{
-							auto item {lbq.item_from_value(url)};
-							if(item != lbq.at(0).end())
+							if(queue_items.find(url))
 								remove_queue_item(url);
-						}
 						autostart_next_item = true;
 						lbq.auto_draw(true);
 					});
 				}
 				if(!startable.empty())
 				{
-					m.append("Start all", [&, this](menu::item_proxy)
+					m.append("Start all", [this](menu::item_proxy)
 					{
-						thr_menu = std::thread([&, this]
+						// the lists are copied, as they're made again the next time the menu pops up
+						menu_task = tasks.submit(executor::pool::io, [this, startable = startable](std::stop_token stop)
 						{
 							menu_working = true;
 							autostart_next_item = false;
-							for(auto item : startable)
+							for(auto &url : startable)
 							{
-								if(!menu_working) break;
-								auto url {item.value<lbqval_t>().url};
+								if(!menu_working || stop.stop_requested()) break;
 								process_queue_item(url);
 							}
+							if(menu_working)
+								bottoms.current().refresh_btndl();
+							autostart_next_item = true;
 						});
-						if(menu_working)
-							api::refresh_window(bottom.btndl);
-						autostart_next_item = true;
-						if(thr_menu.joinable())
-							thr_menu.detach();
 					});
 				}
 				if(!stoppable.empty())
 				{
-					m.append("Stop all", [&, this](menu::item_proxy)
+					m.append("Stop all", [this](menu::item_proxy)
 					{
-						thr_menu = std::thread([&, this]
+						menu_task = tasks.submit(executor::pool::io, [this, stoppable = stoppable](std::stop_token stop)
 						{
 							menu_working = true;
 							autostart_next_item = false;
-							for(auto item : stoppable)
+							for(auto &url : stoppable)
 							{
-								if(!menu_working) break;
-								auto url {item.value<lbqval_t>().url};
+								if(!menu_working || stop.stop_requested()) break;
 								on_btn_dl(url);
 							}
 							if(menu_working)
-								api::refresh_window(bottom.btndl);
+								bottoms.current().refresh_btndl();
 							autostart_next_item = true;
-							if(thr_menu.joinable())
-								thr_menu.detach();
 						});
 					});
 				}
-				if(completed.size() != lbq.at(0).size())
+				if(completed.size() != queue_items.size())
 				{
 					m.append("Remove all", [this](menu::item_proxy)
 					{
@@ -571,25 +531,23 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 
 			m.append(cmdtext, [startables, stoppables, this](menu::item_proxy)
 			{
-				thr_menu = std::thread([this, startables, stoppables]
+				menu_task = tasks.submit(executor::pool::io, [this, startables, stoppables](std::stop_token stop)
 				{
 					menu_working = true;
 					autostart_next_item = false;
 					for(auto url : stoppables)
 					{
-						if(!menu_working) break;
+						if(!menu_working || stop.stop_requested()) break;
 						process_queue_item(url);
 					}
 					for(auto url : startables)
 					{
-						if(!menu_working) break;
+						if(!menu_working || stop.stop_requested()) break;
 						process_queue_item(url);
 					}
 					if(menu_working)
-						api::refresh_window(bottoms.current().btndl);
+						bottoms.current().refresh_btndl();
 					autostart_next_item = true;
-					if(thr_menu.joinable())
-						thr_menu.detach();
 				});
 			});
 
@@ -604,11 +562,9 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 
 	auto update_inline_widgets = [this]
 	{
-		lbq.auto_draw(false);
-		for(auto item : lbq.at(0))
-			item.text(1, '%' + std::to_string(conf.col_site_icon + conf.col_site_text * 2) + item.text(1));
-		lbq.auto_draw(true);
 		adjust_lbq_headers();
+		inline_widget::relayout();
+		nana::api::refresh_window(lbq);
 	};
 
 	make_columns_menu(m.create_sub_menu(m.append("Extra columns").index()));
@@ -626,6 +582,50 @@ std::wstring GUI::pop_queue_menu(int x, int y)
 		update_inline_widgets();
 	}).checked(conf.col_site_text);
 
+	m.append_splitter();
+	m.append("Export download archive", [this](menu::item_proxy)
+	{
+		filebox fb {*this, false};
+		fb.init_path(conf.outpath);
+		fb.init_file("archive.txt");
+		fb.allow_multi_select(false);
+		fb.add_filter("yt-dlp download archive", "*.txt");
+		fb.title("Save the media library as a yt-dlp --download-archive file");
+		auto res {fb()};
+		if(res.size() && !library.export_archive(res.front()))
+		{
+			msgbox mbox {*this, "ytdlp-interface error"};
+			mbox.icon(msgbox::icon_error);
+			(mbox << "Couldn't write the file \"" << res.front().string() << "\"")();
+		}
+	}).enabled(library.size() > 0);
+	m.append("Record a timeline", [](menu::item_proxy)
+	{
+		if(!trace::enabled)
+			trace::clear();
+		trace::enabled = !trace::enabled;
+	}).checked(trace::enabled);
+	m.append("Save the timeline", [this](menu::item_proxy)
+	{
+		filebox fb {*this, false};
+		fb.init_path(conf.outpath);
+		fb.init_file("ytdlp-interface trace.json");
+		fb.allow_multi_select(false);
+		fb.add_filter("Chrome trace (chrome://tracing, ui.perfetto.dev)", "*.json");
+		fb.title("Save the timeline of the queue items");
+		auto res {fb()};
+		if(res.size() && !trace::save(res.front()))
+		{
+			msgbox mbox {*this, "ytdlp-interface error"};
+			mbox.icon(msgbox::icon_error);
+			(mbox << "Couldn't write the file \"" << res.front().string() << "\"")();
+		}
+	}).enabled(trace::size() > 0);
+	m.append("Memory usage", [this](menu::item_proxy)
+	{
+		fm_memory();
+	});
+
 	m.popup_await(lbq, x, y);
 	vidsel_item.m = nullptr;
 	return url_of_item_to_delete;
@@ -639,24 +639,21 @@ void GUI::queue_remove_all()
 	qurl = L"";
 	l_url.update_caption();
 	lbq.auto_draw(false);
-	auto item {lbq.at(0).begin()};
-	while(item != lbq.at(0).end() && menu_working)
+	// last to first, so that the positions of the items that are left stay as they are (see queue_model::index)
+	for(auto pos {lbq.at(0).size()}; pos-- && menu_working;)
 	{
-		auto url {item.value<lbqval_t>().url};
-		item = lbq.erase(item);
+		auto url {lbq.at(0).at(pos).value<lbqval_t>().url};
+		lbq.erase(lbq.at(0).at(pos));
+		queue_items.erase(url);
 		auto &bottom {bottoms.at(url)};
-		if(bottom.timer_proc.started())
-			bottom.timer_proc.stop();
-		if(bottom.info_thread.joinable())
-		{
-			bottom.working_info = false;
-			bottom.info_thread.join();
-		}
+		stop_prefetch(url);
+		bottom.stop_info();
 		if(bottom.dl_thread.joinable())
 		{
 			bottom.working = false;
 			bottom.dl_thread.join();
 		}
+		ui.discard(url);
 		bottoms.erase(url);
 		outbox.erase(url);
 	}
@@ -687,38 +684,35 @@ void GUI::queue_remove_selected()
 	qurl = to_wstring(val);
 	l_url.update_caption();
 
-	std::vector<std::wstring> sel_urls;
+	std::vector<std::wstring> sel_urls; // last to first (see queue_remove_all)
 
-	for(auto ip : sel)
-		sel_urls.push_back(lbq.at(ip).value<lbqval_t>().url);
+	for(auto it {sel.rbegin()}; it != sel.rend(); it++)
+		sel_urls.push_back(lbq.at(*it).value<lbqval_t>().url);
 
 	lbq.auto_draw(false);
 
 	for(auto url : sel_urls)
 	{
-		lbq.erase(lbq.item_from_value(url));
+		lbq.erase(lbq_item(url)); // only rows after it are gone, so its row is still at its position in queue_items
 		auto &bottom {bottoms.at(url)};
-		if(bottom.timer_proc.started())
-			bottom.timer_proc.stop();
-		if(bottom.info_thread.joinable())
-		{
-			bottom.working_info = false;
-			bottom.info_thread.join();
-		}
+		stop_prefetch(url);
+		bottom.stop_info();
 		if(bottom.dl_thread.joinable())
 		{
 			bottom.working = false;
 			bottom.dl_thread.join();
 		}
+		ui.discard(url);
 		bottoms.erase(url);
 		outbox.erase(url);
 	}
-
+	queue_items.erase(sel_urls);
 	if(!val.empty())
 	{
-		auto item {lbq.item_from_value(val)};
+		auto item {lbq_item(val)};
 		if(!item.empty())
 			item.select(true);
+		item_caption(val); // its number was taken before the items above it were removed
 	}
 
 	adjust_lbq_headers();
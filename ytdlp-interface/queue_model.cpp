@@ -0,0 +1,251 @@
+#include "queue_model.hpp"
+
+#include <algorithm>
+#include <functional>
+
+
+std::string queue_model::item_t::status_text() const
+{
+	switch(state)
+	{
+	case status::queued: return "queued";
+	case status::started: return "started";
+	case status::downloading: return progress.empty() ? "downloading" : progress;
+	case status::processing: return "processing";
+	case status::stopped: return progress.empty() ? "stopped" : "stopped (" + progress + ')';
+	case status::done: return "done";
+	case status::error: return "error";
+	}
+	return "";
+}
+
+
+void queue_model::item_t::stop()
+{
+	// "[3/10] 45.2%" (a playlist) becomes "3/10"
+	if(state == status::downloading && !progress.empty() && progress.front() == '[')
+		progress = progress.substr(1, progress.find(']') - 1);
+	else if(state != status::downloading && state != status::stopped)
+		progress.clear();
+	state = status::stopped;
+}
+
+
+void queue_model::item_t::reset_info()
+{
+	website = title = format = format_note = ext = filesize = "...";
+	size = downloaded = file_base = file_size = 0;
+	size_approx = false;
+}
+
+
+void queue_model::item_t::file_progress(unsigned long long fsize, unsigned long long permille)
+{
+	file_size = fsize;
+	downloaded = file_base + fsize * std::min(permille, 1000ull) / 1000;
+	// the size from the media info can be missing or too small (approximate, or not covering all the files)
+	if(file_base + fsize > size)
+		size = file_base + fsize;
+}
+
+
+void queue_model::item_t::next_file()
+{
+	file_base += file_size;
+	file_size = 0;
+	downloaded = file_base;
+}
+
+
+queue_model::item_t &queue_model::append(const std::wstring &url)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	if(auto it {index.find(url)}; it != index.end())
+		return *it->second.item;
+	auto &item {items.emplace_back(std::make_shared<item_t>())};
+	item->url = url;
+	index[url] = {item, items.size() - 1};
+	if(indexed == items.size() - 1)
+		indexed++;
+	return *item;
+}
+
+
+void queue_model::erase(const std::wstring &url)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	auto it {index.find(url)};
+	if(it == index.end())
+		return;
+	const auto pos {locate(it->second)};
+	index.erase(it);
+	items.erase(items.begin() + pos);
+	indexed = std::min(indexed, pos);
+}
+
+
+void queue_model::erase(const std::vector<std::wstring> &urls)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	size_t first {items.size()};
+	for(const auto &url : urls)
+		if(auto it {index.find(url)}; it != index.end())
+		{
+			first = std::min(first, locate(it->second));
+			it->second.item = nullptr;
+		}
+	// one pass over the items, instead of one for each removed item
+	auto last {std::remove_if(items.begin() + first, items.end(), [this](const auto &item)
+	{
+		auto it {index.find(item->url)};
+		if(it->second.item)
+			return false;
+		index.erase(it);
+		return true;
+	})};
+	items.erase(last, items.end());
+	indexed = std::min(indexed, first);
+}
+
+
+void queue_model::move(size_t from, size_t to)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	if(from == to || from >= items.size() || to >= items.size())
+		return;
+	// the positions are brought up to date first, as locate counts on them being too high, not too low
+	for(; indexed < items.size(); indexed++)
+		index.find(items[indexed]->url)->second.pos = indexed;
+	if(from < to)
+		std::rotate(items.begin() + from, items.begin() + from + 1, items.begin() + to + 1);
+	else std::rotate(items.begin() + to, items.begin() + from, items.begin() + from + 1);
+	// only the items in between have moved (by one step when an item is dragged)
+	for(auto pos {std::min(from, to)}; pos <= std::max(from, to); pos++)
+		index.find(items[pos]->url)->second.pos = pos;
+}
+
+
+void queue_model::clear()
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	items.clear();
+	index.clear();
+	indexed = 0;
+}
+
+
+std::shared_ptr<queue_model::item_t> queue_model::find(const std::wstring &url)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	auto it {index.find(url)};
+	return it == index.end() ? nullptr : it->second.item;
+}
+
+
+size_t queue_model::pos(const std::wstring &url) const
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	auto it {index.find(url)};
+	return it == index.end() ? -1 : locate(it->second);
+}
+
+
+size_t queue_model::count(status st) const
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	size_t n {0};
+	for(const auto &item : items)
+		n += item->state == st;
+	return n;
+}
+
+
+queue_model::totals_t queue_model::totals(unsigned slots, bool autostart) const
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	totals_t t;
+	std::vector<double> slot_free; // when each download slot becomes free, in seconds from now
+	std::vector<unsigned long long> waiting;
+	for(const auto &item : items)
+	{
+		if(item->state == status::done)
+			t.finished += std::max(item->size, item->downloaded);
+		if(!item->running() && item->state != status::processing && !(autostart && item->startable()))
+			continue;
+		if(!item->size)
+			t.unknown++;
+		t.size += item->size;
+		t.downloaded += std::min(item->downloaded, item->size);
+		t.remaining += item->remaining();
+		if(item->startable())
+		{
+			t.waiting++;
+			waiting.push_back(item->remaining());
+		}
+		else
+		{
+			t.running++;
+			t.speed += item->speed;
+			slot_free.push_back(item->speed > 0 ? item->remaining() / item->speed : 0);
+		}
+	}
+
+	if(t.running && t.speed > 0)
+	{
+		// the waiting items start in queue order as slots free up, each at the average rate of a running item
+		const double rate {t.speed / t.running};
+		if(slot_free.size() < slots)
+			slot_free.resize(slots, 0);
+		std::make_heap(slot_free.begin(), slot_free.end(), std::greater<> {});
+		for(auto bytes : waiting)
+		{
+			std::pop_heap(slot_free.begin(), slot_free.end(), std::greater<> {});
+			slot_free.back() += bytes / rate;
+			std::push_heap(slot_free.begin(), slot_free.end(), std::greater<> {});
+		}
+		t.eta = *std::max_element(slot_free.begin(), slot_free.end());
+	}
+	return t;
+}
+
+
+void queue_model::progress(const std::wstring &url, unsigned long long fsize, unsigned long long permille, double speed)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	if(auto it {index.find(url)}; it != index.end())
+	{
+		auto &item {*it->second.item};
+		if(fsize)
+			item.file_progress(fsize, permille);
+		if(speed >= 0)
+			item.speed = speed;
+	}
+}
+
+
+void queue_model::next_file(const std::wstring &url)
+{
+	std::lock_guard<std::recursive_mutex> lock {mtx};
+	if(auto it {index.find(url)}; it != index.end())
+		it->second.item->next_file();
+}
+
+
+std::vector<std::string> queue_model::row(const item_t &item) const
+{
+	return {std::to_string(pos(item.url) + 1), item.website, item.title, item.status_text(), item.format,
+		item.format_note, item.ext, item.filesize};
+}
+
+
+size_t queue_model::locate(const entry_t &entry) const
+{
+	// the positions from `indexed` on are too high by the number of items removed before them; they're corrected as
+	// far as the item that's asked for, so a redraw after a removal costs no more than the rows it shows
+	while(entry.pos >= indexed && indexed < items.size())
+	{
+		index.find(items[indexed]->url)->second.pos = indexed;
+		indexed++;
+	}
+	return entry.pos;
+}
\ No newline at end of file
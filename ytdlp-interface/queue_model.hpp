@@ -0,0 +1,84 @@
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// The download queue as data: one typed record per item, in queue order, with positions looked up by URL. The queue
+// listbox (GUI::lbq) is a view of it: its rows hold the records, and their text is made from them only when they're
+// drawn (see GUI::make_queue_listbox and row). It doesn't depend on nana, so tests/queue_bench.cpp builds it on its own.
+class queue_model
+{
+public:
+	enum class status : unsigned char { queued, started, downloading, processing, stopped, done, error };
+
+	struct item_t
+	{
+		std::wstring url;
+		status state {status::queued};
+		std::string progress; // e.g. "45.2%" or "[3/10] 45.2%"; for a stopped item, how far it got ("45.2%" or "3/10")
+		std::string website {"..."}, title {"..."}, format {"..."}, format_note {"..."}, ext {"..."}, filesize {"..."};
+
+		// byte accounting for the queue totals; `size` is 0 when it isn't known (yet)
+		unsigned long long size {0}, downloaded {0};
+		bool size_approx {false}; // from "filesize_approx", or from a yt-dlp estimate during the download
+		unsigned long long file_base {0}, file_size {0}; // bytes of the files already finished, size of the current one
+		double speed {0}; // bytes/s while running
+
+		std::string status_text() const; // as shown in the status column
+		bool running() const { return state == status::started || state == status::downloading; }
+		bool startable() const { return state == status::queued || state == status::stopped; }
+		void stop(); // keeps how far the download got in `progress`
+		void reset_info(); // back to "..." for everything but the status, for when the info is extracted again
+		void file_progress(unsigned long long fsize, unsigned long long permille); // from a progress line of the current file
+		void next_file(); // a new destination file was announced (video and audio of a merged format are separate files)
+		unsigned long long remaining() const { return size > downloaded ? size - downloaded : 0; }
+	};
+
+	struct totals_t
+	{
+		unsigned long long size {0}, downloaded {0}, remaining {0}; // over the items that are running or waiting to start
+		unsigned long long finished {0}; // bytes of the items that are done
+		double speed {0}; // combined rate of the running items
+		size_t running {0}, waiting {0}, unknown {0}; // `unknown`: items among them whose size isn't known
+		double eta {-1}; // seconds until the queue is done at the current rates, -1 if there's nothing to go on
+	};
+
+	item_t &append(const std::wstring &url);
+	void erase(const std::wstring &url);
+	void erase(const std::vector<std::wstring> &urls); // several at once, in one pass
+	void move(size_t from, size_t to); // the item at `from` ends up at `to`, the ones in between shift by one
+	void clear();
+	std::shared_ptr<item_t> find(const std::wstring &url); // null if not in the queue; the item outlives its removal
+	item_t &at(size_t pos) { return *items[pos]; }
+	size_t pos(const std::wstring &url) const; // -1 if not in the queue
+	size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+	size_t count(status st) const;
+	// `slots`: how many items can download at the same time; `autostart`: whether the waiting items get started when
+	// slots free up (otherwise they're left out)
+	totals_t totals(unsigned slots, bool autostart) const;
+	void progress(const std::wstring &url, unsigned long long fsize, unsigned long long permille, double speed);
+	void next_file(const std::wstring &url);
+	std::vector<std::string> row(const item_t &item) const; // the texts of the item's listbox row, "#" first
+	auto begin() { return items.begin(); }
+	auto end() { return items.end(); }
+
+private:
+	struct entry_t
+	{
+		std::shared_ptr<item_t> item;
+		size_t pos; // right only if it's before `indexed`
+	};
+
+	std::vector<std::shared_ptr<item_t>> items; // shared, so that an item a worker thread found stays valid if it's removed
+	/* Removing an item shifts the positions of the ones after it; instead of being written again right away, they're
+	   corrected when one of them is asked for (see locate), so a removal doesn't cost a pass over the queue */
+	mutable std::unordered_map<std::wstring, entry_t> index;
+	mutable size_t indexed {0};
+	mutable std::recursive_mutex mtx;
+
+	size_t locate(const entry_t &entry) const;
+};
\ No newline at end of file
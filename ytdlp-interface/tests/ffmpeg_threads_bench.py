@@ -0,0 +1,63 @@
+# Measures what the -threads value that GUI::ffmpeg_threads passes to ffmpeg (through --ppa) does when several items are
+# post-processed at once. It makes synthetic media with the local ffmpeg (a video-only and an audio-only file, like the
+# formats yt-dlp merges), then runs the same number of concurrent jobs twice: with ffmpeg's default thread count (every
+# process uses all the cores) and with the cores divided between the jobs, and prints the total wall time of each run.
+#
+# Two kinds of job are timed: the merge yt-dlp does ([Merger], streams copied), and a merge that re-encodes the video,
+# as the post-processors that cut or convert do ([FixupM3u8] with --force-keyframes-at-cuts, --recode-video); the thread
+# count only matters for the latter. The results depend on the machine: run it on one with several cores.
+#
+# The jobs stand for the running items, which can all reach post-processing together; --pool caps them at the size of
+# the post-processing pool, as GUI::ffmpeg_threads does when post-processing is done in the pool (cb_lengthyproc).
+#
+#   python ffmpeg_threads_bench.py [--ffmpeg PATH] [--jobs 4] [--pool] [--seconds 30] [--height 720]
+
+import os, sys, time, shutil, argparse, tempfile, subprocess
+
+ap = argparse.ArgumentParser()
+ap.add_argument('--ffmpeg', default=shutil.which('ffmpeg') or 'ffmpeg')
+ap.add_argument('--jobs', type=int, default=4, help='concurrent post-processing jobs')
+ap.add_argument('--pool', action='store_true', help='divide the cores as if the post-processing pool was used')
+ap.add_argument('--seconds', type=int, default=30, help='duration of the synthetic media')
+ap.add_argument('--height', type=int, default=720)
+args = ap.parse_args()
+
+cores = os.cpu_count() or 1
+pool = max(1, cores // 2) # GUI::postproc_slots
+split = max(1, cores // (min(args.jobs, pool) if args.pool else args.jobs)) # what ffmpeg_threads gives with `jobs` items running
+tmp = tempfile.mkdtemp(prefix='ffbench')
+
+def ffmpeg(*a):
+	subprocess.run([args.ffmpeg, '-hide_banner', '-loglevel', 'error', '-y', *a], check=True)
+
+width = args.height * 16 // 9 // 2 * 2
+video, audio = os.path.join(tmp, 'v.mp4'), os.path.join(tmp, 'a.m4a')
+ffmpeg('-f', 'lavfi', '-i', f'testsrc2=size={width}x{args.height}:rate=30:duration={args.seconds}',
+	'-c:v', 'libx264', '-preset', 'veryfast', '-pix_fmt', 'yuv420p', video)
+ffmpeg('-f', 'lavfi', '-i', f'sine=frequency=440:sample_rate=48000:duration={args.seconds}', '-c:a', 'aac', audio)
+
+jobs = {
+	'merge': ['-c', 'copy'],
+	'merge + re-encode': ['-c:v', 'libx264', '-preset', 'veryfast', '-c:a', 'copy'],
+}
+
+def run(kind, threads):
+	procs = []
+	start = time.perf_counter()
+	for n in range(args.jobs):
+		out = os.path.join(tmp, f'out{n}.mkv')
+		thr = ['-threads', str(threads)] if threads else []
+		procs.append(subprocess.Popen([args.ffmpeg, '-hide_banner', '-loglevel', 'error', '-y', '-i', video, '-i', audio,
+			'-map', '0:v:0', '-map', '1:a:0', *jobs[kind], *thr, out]))
+	for p in procs:
+		if p.wait():
+			sys.exit(f'ffmpeg failed ({kind}, threads={threads})')
+	return time.perf_counter() - start
+
+print(f'{cores} cores, {args.jobs} concurrent jobs, {args.seconds} s of {width}x{args.height} video')
+try:
+	for kind in jobs:
+		default, divided = run(kind, 0), run(kind, split)
+		print(f'{kind:>20}: default threads {default:7.2f} s, -threads {split}: {divided:7.2f} s ({default / divided:.2f}x)')
+finally:
+	shutil.rmtree(tmp, ignore_errors=True)
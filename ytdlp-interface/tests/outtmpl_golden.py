@@ -0,0 +1,56 @@
+# Makes outtmpl_golden.json, the table outtmpl_test checks outtmpl against: the names yt-dlp gives the templates below
+# for the info dict below, and what its sanitize_filename and sanitize_path (with the Windows rules) make of the strings
+# below. Run it with the yt-dlp it should match importable (pip install yt-dlp, or PYTHONPATH set to a source tree):
+#   python outtmpl_golden.py > outtmpl_golden.json
+
+import sys, json
+import yt_dlp
+from yt_dlp import YoutubeDL
+from yt_dlp.utils import _utils
+
+info = {
+ 'id': 'dQw4w9WgXcQ', 'title': 'Rick Astley - Never Gonna Give You Up (Official Music Video) [4K] 10:30 "live"? <a|b> */\\',
+ 'uploader': 'Rick Astley ', 'ext': 'webm', 'upload_date': '20091025', 'timestamp': 1256453478, 'duration': 213,
+ 'view_count': 1500000000, 'like_count': None, 'height': 1080, 'width': 1920, 'fps': 25.0, 'resolution': '1920x1080',
+ 'tags': ['a', 'b'], 'channel': 'RickAstleyVEVO', 'webpage_url_domain': 'youtube.com', 'empty': '',
+ 'description': 'line1\nline2\n\nline3\n', 'format_id': '313+251', 'epoch': 1700000000, 'playlist_index': None,
+ 'series': None, 'track': 'Never Gonna Give You Up', 'release_date': None, 'abr': 129.482, 'chapters': [{'title': 'Intro', 'start_time': 0.0}],
+ 'weird': ' .dotted. ', 'nl': '\nstart and end\n', 'colons': '12:34:56 and a:b', 'dash': '-leading', 'dot': '.hidden',
+ 'unicode': 'Ünïcödé 日本語 テスト', 'ctrl': 'a\x01b\x7fc', 'tab': 'a\tb',
+}
+templates = [
+ '%(title)s.%(ext)s', '%(title)s [%(id)s].%(ext)s', '%(uploader)s/%(title)s.%(ext)s', '%(uploader,channel)s/%(title)s.%(ext)s',
+ '%(series,track)s - %(id)s.%(ext)s', '%(like_count)s.%(ext)s', '%(like_count|unknown)s.%(ext)s', '%(like_count)05d.%(ext)s',
+ '%(view_count)d views.%(ext)s', '%(view_count)015d.%(ext)s', '%(height)dp%(fps)d.%(ext)s', '%(fps)s.%(ext)s', '%(abr).1f.%(ext)s',
+ '%(abr)08.3f.%(ext)s', '%(upload_date>%Y-%m-%d)s %(title)s.%(ext)s', '%(timestamp>%Y-%m-%d %H-%M-%S)s.%(ext)s',
+ '%(release_date>%Y,upload_date>%Y)s.%(ext)s', '%(duration_string)s.%(ext)s', '%(duration+60)s.%(ext)s', '%(duration-13)d.%(ext)s',
+ '%(-duration)s.%(ext)s', '%(duration*2)d.%(ext)s', '%(tags.0)s-%(tags.-1)s-%(tags.5)s.%(ext)s', '%(chapters.0.title)s.%(ext)s',
+ '%(title.0)s%(title.-1)s.%(ext)s', '%(empty)s-%(empty|x)s.%(ext)s', '%(description)s.%(ext)s', '%(weird)s/%(weird)s.%(ext)s',
+ '%(nl)s.%(ext)s', '%(colons)s.%(ext)s', '%(dash)s.%(dot)s.%(ext)s', '%(unicode)s.%(ext)s', '%(unicode).5s|%(unicode)12s|%(unicode)-12s.%(ext)s',
+ '%(ctrl)s%(tab)s.%(ext)s', '100%% %(title)S.%(ext)s', '%(title)c%(nothing)c.%(ext)s', '%(id&[{}] |)s%(title)s.%(ext)s',
+ '%(nothing&yes|no)s.%(ext)s', 'weird?:name*<>|"/%(id)s .%(ext)s', '%(webpage_url_domain)s/%(upload_date>%B %d %Y %a %A %b %j)s.%(ext)s',
+ '%(view_count)+d %(view_count) d %(view_count)-12d|.%(ext)s', '%(fps)e %(fps)g %(fps)G.%(ext)s', 'a%b%(id)s%.%(ext)s', '%(id)s%',
+ '%(timestamp>%I %p)s.%(ext)s', '%(title)10.10s.%(ext)s', '../x/./y/%(id)s.%(ext)s', '%(format_id)s.%(ext)s', '%(playlist_index)s - %(title)s.%(ext)s',
+ '%(uploader)s.%(epoch-1700000000)d.%(ext)s',
+ '%(upload_date>%Y\\,%m)s.%(ext)s', '%(id&{0}-{{x}})s.%(ext)s', '%(autonumber)s.%(ext)s', '%(title)j', '%(tags.:2)s', '%(title)r', '%(title)x',
+ '%(view_count-view_count)d.%(ext)s', '%(timestamp>%s)s', '%(nothing,also_nothing|)s.%(ext)s', '%(title)-5.3s|', '%(like_count+1)s', '%(abr)i',
+ '%(height)s %(height)5s %(height)-5s|', '%(tags)s', '%(id)5c|%(empty)c|',
+]
+sanitize_cases = ['abc', 'abc/de///', 'xxx/<>\\*|', 'yes? no', 'this: that', 'AT&T', 'ä', 'New World record at 0:12:34', '--gasdgf', '.gasdgf',
+ '\n\nfoo\n\n', '- \nfoo\n -', 'a\n\nb', '"quoted"', 'tab\there', '\x00\x1f', '']
+path_cases = ['C:\\Users\\x\\Down.loads\\a .mp4', 'rel/dir. /file?.mp4', '\\\\srv\\share\\a\\b.', 'C:rel\\x', 'a/../../b/./c', '', 'x:y\\z']
+
+# templates using what outtmpl doesn't do (it returns an empty name for them, and the app falls back to asking yt-dlp)
+unsupported = {'%(autonumber)s.%(ext)s', '%(title)j', '%(tags.:2)s', '%(title)r', '%(title)x', '%(timestamp>%s)s', '%(tags)s'}
+
+names = {t: YoutubeDL({'outtmpl': t, 'windowsfilenames': True, 'quiet': True}).prepare_filename(dict(info)) for t in templates}
+sanitized = [{'input': s, 'expected': _utils.sanitize_filename(s)} for s in sanitize_cases]
+sys.platform = 'win32' # the path rules of yt-dlp on Windows, for the names as they end up there
+cases = [{'template': t, 'expected': '' if t in unsupported else _utils.sanitize_path(names[t])} for t in templates]
+paths = [{'input': p, 'expected': _utils.sanitize_path(p)} for p in path_cases]
+
+golden = {'generated_with': 'yt-dlp ' + yt_dlp.version.__version__, 'info': info, 'templates': cases,
+          'sanitize_filename': sanitized, 'sanitize_path': paths}
+sys.stdout.reconfigure(encoding='utf-8', newline='\n')
+json.dump(golden, sys.stdout, ensure_ascii=False, indent='\t')
+print()
@@ -0,0 +1,67 @@
+#include "../outtmpl.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+/* Checks outtmpl against the names yt-dlp itself produced, as recorded in outtmpl_golden.json (made by
+   outtmpl_golden.py, which runs yt-dlp's prepare_filename, sanitize_filename and sanitize_path on the same inputs).
+   A template with an empty expected name is one outtmpl doesn't support, which it has to report by returning an
+   empty string. Takes the path of the golden file as its argument; without one, it's looked up next to this source. */
+
+namespace fs = std::filesystem;
+
+
+int main(int argc, char *argv[])
+{
+	using json = nlohmann::json;
+
+	const fs::path golden_path {argc > 1 ? fs::path {argv[1]} : fs::path {__FILE__}.parent_path() / "outtmpl_golden.json"};
+	std::ifstream f {golden_path, std::ios::binary};
+	if(!f)
+	{
+		std::cerr << "can't open " << golden_path.string() << std::endl;
+		return 2;
+	}
+	const json golden = json::parse(f);
+	const auto &info {golden["info"]};
+
+	// yt-dlp makes the filename version of duration_string itself; outtmpl gets it from the caller (as in predict_path)
+	json overrides;
+	if(info.contains("duration") && info["duration"].is_number())
+	{
+		const auto secs {static_cast<long long>(info["duration"].get<double>())};
+		const auto h {secs / 3600}, m {secs / 60 % 60}, s {secs % 60};
+		auto pad2 = [](long long n) { return (n < 10 ? "0" : "") + std::to_string(n); };
+		overrides["duration_string"] = h ? std::to_string(h) + '-' + pad2(m) + '-' + pad2(s) :
+			m ? std::to_string(m) + '-' + pad2(s) : std::to_string(s);
+	}
+
+	size_t cases {0}, failed {0};
+	auto check = [&](const char *what, const std::string &input, const std::string &expected, const std::string &result)
+	{
+		cases++;
+		if(result != expected)
+		{
+			failed++;
+			std::cout << what << " mismatch for " << json(input).dump() << "\n  expected " << json(expected).dump() <<
+				"\n  got      " << json(result).dump() << std::endl;
+		}
+	};
+
+	for(const auto &c : golden["templates"])
+	{
+		const std::string tmpl {c["template"]}, expected {c["expected"]};
+		auto result {outtmpl::evaluate(tmpl, info, overrides)};
+		if(!result.empty())
+			result = outtmpl::sanitize_path(result);
+		check("template", tmpl, expected, result);
+	}
+	for(const auto &c : golden["sanitize_filename"])
+		check("sanitize_filename", c["input"], c["expected"], outtmpl::sanitize_filename(c["input"]));
+	for(const auto &c : golden["sanitize_path"])
+		check("sanitize_path", c["input"], c["expected"], outtmpl::sanitize_path(c["input"]));
+
+	std::cout << cases - failed << " of " << cases << " cases match " << golden["generated_with"].get<std::string>() << std::endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#include "../queue_model.hpp"
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+/* Times what the queue costs the GUI thread with 10,000 synthetic items: adding them, progress updates, removing
+   items one at a time and in batches, and moving them. The queue listbox is a view of queue_model: its rows hold the
+   item records (`rows` below), and nana formats a row only when it draws it, so each redraw is simulated by making
+   the texts of the visible rows (queue_model::row). Prints the time of each operation, and fails if any single
+   action takes longer than a frame budget, as the GUI would then stop being interactive (a batch removal gets a
+   budget of its own). Takes the number of items as its optional argument. */
+
+using clk = std::chrono::steady_clock;
+
+const size_t visible {30}; // rows on screen
+const double budget_ms {16}, batch_budget_ms {100}; // per action
+
+
+int main(int argc, char *argv[])
+{
+	const size_t count {argc > 1 ? std::stoul(argv[1]) : 10'000};
+	queue_model queue;
+	std::vector<std::shared_ptr<queue_model::item_t>> rows; // the listbox's model (GUI::lbq_rows)
+	std::mt19937 rng {1337};
+	size_t top {0}, chars {0}; // first visible row; `chars` keeps the formatting from being optimized away
+	bool failed {false};
+
+	auto redraw = [&]
+	{
+		top = std::min(top, rows.size() > visible ? rows.size() - visible : 0);
+		for(auto pos {top}; pos < std::min(top + visible, rows.size()); pos++)
+			for(const auto &text : queue.row(*rows[pos]))
+				chars += text.size();
+	};
+
+	auto report = [&](const char *what, size_t actions, clk::time_point t0, double worst_ms, double budget = budget_ms)
+	{
+		const double ms {std::chrono::duration<double, std::milli> {clk::now() - t0}.count()};
+		std::cout << what << ": " << actions << " in " << ms << " ms, " << ms / actions << " ms each, worst " << worst_ms <<
+			" ms" << std::endl;
+		if(worst_ms > budget)
+		{
+			failed = true;
+			std::cout << "  over the budget of " << budget << " ms per action" << std::endl;
+		}
+	};
+
+	auto timed = [](double &worst_ms, auto action)
+	{
+		const auto t0 {clk::now()};
+		action();
+		worst_ms = std::max(worst_ms, std::chrono::duration<double, std::milli> {clk::now() - t0}.count());
+	};
+
+	auto url = [](size_t n) { return L"https://www.youtube.com/watch?v=" + std::to_wstring(1'000'000 + n); };
+
+	// adding: the row is appended and the view is redrawn, as GUI::add_url does for every URL
+	double worst {0};
+	auto t0 {clk::now()};
+	for(size_t n {0}; n < count; n++)
+		timed(worst, [&]
+		{
+			auto &item {queue.append(url(n))};
+			item.website = "youtube.com";
+			item.title = "Synthetic item " + std::to_string(n);
+			item.format = "137 - 1920x1080 (1080p)";
+			item.format_note = "1080p";
+			item.ext = "mp4";
+			item.filesize = "512.00 MB";
+			item.size = 512ull << 20;
+			rows.push_back(queue.find(url(n)));
+			top = rows.size();
+			redraw();
+		});
+	report("add", count, t0, worst);
+
+	// progress: 8 items downloading, their updates drained in batches of 100 that each get one redraw (GUI::drain_ui)
+	for(size_t n {0}; n < 8; n++)
+		queue.at(n).state = queue_model::status::downloading;
+	top = 0;
+	worst = 0;
+	t0 = clk::now();
+	const size_t updates {100'000}, batch {100};
+	for(size_t n {0}; n < updates; n += batch)
+		timed(worst, [&]
+		{
+			for(size_t u {n}; u < n + batch; u++)
+			{
+				const auto &item_url {queue.at(u % 8).url};
+				queue.progress(item_url, 512ull << 20, u * 1000 / updates, 5e6);
+				if(auto pqi {queue.find(item_url)})
+					pqi->progress = std::to_string(u * 100 / updates) + '%';
+			}
+			redraw();
+		});
+	report("progress updates (batches of 100)", updates / batch, t0, worst);
+
+	// the queue totals, which GUI::update_queue_totals makes once a second
+	worst = 0;
+	t0 = clk::now();
+	for(size_t n {0}; n < 100; n++)
+		timed(worst, [&] { chars += queue.totals(4, true).waiting; });
+	report("totals", 100, t0, worst);
+
+	// removing one item at a time, from anywhere, with the view at the end of the queue: every "#" after the removed
+	// item changes, and the visible rows are numbered from their new positions when they're drawn
+	worst = 0;
+	t0 = clk::now();
+	const size_t removals {count / 10};
+	for(size_t n {0}; n < removals; n++)
+		timed(worst, [&]
+		{
+			const auto pos {std::uniform_int_distribution<size_t> {0, rows.size() - 1}(rng)};
+			const auto item_url {rows[pos]->url};
+			rows.erase(rows.begin() + pos);
+			queue.erase(item_url);
+			top = rows.size();
+			redraw();
+		});
+	report("remove one", removals, t0, worst);
+
+	// moving an item (dragging it in the listbox), a step at a time, with a redraw for each step
+	worst = 0;
+	t0 = clk::now();
+	const size_t moves {count / 10};
+	for(size_t n {0}; n < moves; n++)
+		timed(worst, [&]
+		{
+			const auto from {std::uniform_int_distribution<size_t> {1, rows.size() - 1}(rng)}, to {from - 1};
+			queue.move(from, to);
+			std::rotate(rows.begin() + to, rows.begin() + from, rows.begin() + from + 1);
+			top = to;
+			redraw();
+		});
+	report("move one step", moves, t0, worst);
+
+	// removing half of the queue at once ("Remove selected"): the rows last to first, the items in one go, and one
+	// redraw at the end (GUI::queue_remove_selected)
+	worst = 0;
+	t0 = clk::now();
+	timed(worst, [&]
+	{
+		std::vector<std::wstring> urls;
+		for(auto pos {rows.size()}; pos--;)
+			if(pos % 2)
+			{
+				urls.push_back(rows[pos]->url);
+				rows.erase(rows.begin() + pos);
+			}
+		queue.erase(urls);
+		top = 0;
+		redraw();
+	});
+	report("remove half at once", 1, t0, worst, batch_budget_ms);
+
+	// the rows must still match the queue
+	for(size_t pos {0}; pos < rows.size(); pos++)
+		if(queue.pos(rows[pos]->url) != pos || queue.row(*rows[pos]).front() != std::to_string(pos + 1))
+		{
+			std::cout << "row " << pos << " doesn't match its item" << std::endl;
+			return 1;
+		}
+
+	std::cout << count << " items, " << chars << " characters drawn" << std::endl;
+	return failed;
+}
\ No newline at end of file
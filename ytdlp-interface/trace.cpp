@@ -0,0 +1,192 @@
+#include <windows.h>
+#include "trace.hpp"
+#include "json.hpp"
+
+#include <mutex>
+#include <memory>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <fstream>
+
+#pragma warning (disable: 4267)
+
+namespace
+{
+	struct event_t
+	{
+		const char *name;
+		char ph; // 'X' = complete (span), 'i' = instant
+		long long ts, dur;
+		std::wstring item;
+	};
+
+	/* Only the thread that owns a buffer writes to it, and only at the end: an event is written first, and then
+	   published by storing the new count, so a reader sees whole events up to the count it loaded. The events are
+	   kept in chunks that are allocated as they're needed, so a thread that records a few events costs little.
+
+	   Clearing the timeline starts a new generation. The owner of a buffer that's from an earlier one starts it over
+	   (count and dropped go back to 0, and the chunks are reused) before it records the next event, and the readers
+	   pass over such buffers. The owner stores the buffer's generation after resetting the count, so a reader that
+	   loads the current generation from the buffer sees the reset too; a buffer isn't started over while it's read,
+	   as the generation only changes under registry_mtx, which the readers hold. */
+	struct buffer_t
+	{
+		static constexpr size_t chunk_size {256}, max_chunks {64};
+		std::unique_ptr<event_t[]> chunks[max_chunks];
+		std::atomic<size_t> count {0}, dropped {0}; // dropped: events that didn't fit, since the buffer was started over
+		std::atomic<unsigned> generation {0};
+		unsigned tid {0};
+
+		event_t &at(size_t i) { return chunks[i / chunk_size][i % chunk_size]; }
+	};
+
+	std::mutex registry_mtx; // guards the list of buffers, which changes when a thread records its first event
+	std::vector<std::shared_ptr<buffer_t>> buffers;
+	std::atomic<unsigned> generation {0}; // incremented by clear
+	const auto t0 {std::chrono::steady_clock::now()};
+
+	buffer_t &local_buffer()
+	{
+		thread_local std::shared_ptr<buffer_t> buf;
+		if(!buf)
+		{
+			buf = std::make_shared<buffer_t>();
+			std::lock_guard lock {registry_mtx};
+			buf->generation = generation.load();
+			buf->tid = static_cast<unsigned>(buffers.size() + 1);
+			buffers.push_back(buf);
+		}
+		return *buf;
+	}
+
+	void record(const char *name, char ph, long long ts, long long dur, const std::wstring &item)
+	{
+		auto &buf {local_buffer()};
+		if(const auto gen {generation.load(std::memory_order_acquire)}; buf.generation.load(std::memory_order_relaxed) != gen)
+		{
+			buf.count.store(0, std::memory_order_relaxed);
+			buf.dropped.store(0, std::memory_order_relaxed);
+			buf.generation.store(gen, std::memory_order_release);
+		}
+		const auto n {buf.count.load(std::memory_order_relaxed)};
+		if(n == buffer_t::chunk_size * buffer_t::max_chunks)
+		{
+			// the buffer is full, so the thread's events are dropped until the timeline is cleared (the count is saved)
+			buf.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		if(n % buffer_t::chunk_size == 0 && !buf.chunks[n / buffer_t::chunk_size])
+			buf.chunks[n / buffer_t::chunk_size].reset(new event_t[buffer_t::chunk_size]);
+		buf.at(n) = {name, ph, ts, dur, item};
+		buf.count.store(n + 1, std::memory_order_release);
+	}
+
+	std::string to_utf8(const std::wstring &wstr)
+	{
+		if(wstr.empty())
+			return {};
+		std::string str(WideCharToMultiByte(CP_UTF8, 0, wstr.data(), wstr.size(), nullptr, 0, nullptr, nullptr), '\0');
+		WideCharToMultiByte(CP_UTF8, 0, wstr.data(), wstr.size(), &str.front(), str.size(), nullptr, nullptr);
+		return str;
+	}
+}
+
+
+long long trace::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+
+
+void trace::complete(const char *name, const std::wstring &item, long long start, long long end)
+{
+	if(enabled.load(std::memory_order_relaxed))
+		record(name, 'X', start, end - start, item);
+}
+
+
+void trace::instant(const char *name, const std::wstring &item)
+{
+	if(enabled.load(std::memory_order_relaxed))
+		record(name, 'i', now(), 0, item);
+}
+
+
+void trace::phases::enter(const char *name)
+{
+	if(current && name && !std::strcmp(current, name))
+		return;
+	const auto ts {current || name ? now() : 0};
+	if(current)
+		complete(current, item, start, ts);
+	current = enabled.load(std::memory_order_relaxed) ? name : nullptr;
+	start = ts;
+}
+
+
+bool trace::save(const std::filesystem::path &file)
+{
+	using json = nlohmann::json;
+
+	json events = json::array();
+	size_t dropped {0};
+	std::lock_guard lock {registry_mtx};
+	for(auto &buf : buffers)
+	{
+		if(buf->generation.load(std::memory_order_acquire) != generation.load())
+			continue; // nothing recorded since the timeline was last cleared
+		const auto count {buf->count.load(std::memory_order_acquire)};
+		if(!count)
+			continue;
+		const auto thread_dropped {buf->dropped.load(std::memory_order_relaxed)};
+		dropped += thread_dropped;
+		// the thread is named after the first thing it recorded, which tells the GUI thread from the item threads
+		const auto &ev0 {buf->at(0)};
+		events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buf->tid},
+			{"args", {{"name", std::string {ev0.name} + (ev0.item.empty() ? "" : " " + to_utf8(ev0.item))}}}});
+		if(thread_dropped)
+		{
+			// shown at the end of the thread's events, which is where its timeline stops
+			const auto &last {buf->at(count - 1)};
+			events.push_back({{"name", "events dropped (buffer full)"}, {"cat", "ytdlp-interface"}, {"ph", "i"}, {"s", "t"},
+				{"ts", last.ts + last.dur}, {"pid", 1}, {"tid", buf->tid}, {"args", {{"dropped", thread_dropped}}}});
+		}
+		for(size_t i {0}; i < count; i++)
+		{
+			const auto &ev {buf->at(i)};
+			json jev {{"name", ev.name}, {"cat", "ytdlp-interface"}, {"ph", std::string(1, ev.ph)}, {"ts", ev.ts},
+				{"pid", 1}, {"tid", buf->tid}};
+			if(ev.ph == 'X')
+				jev["dur"] = ev.dur;
+			else jev["s"] = "t";
+			if(!ev.item.empty())
+				jev["args"] = {{"item", to_utf8(ev.item)}};
+			events.push_back(std::move(jev));
+		}
+	}
+	json doc {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}};
+	if(dropped)
+		doc["otherData"] = {{"dropped_events", dropped}};
+	std::ofstream f {file, std::ios::binary};
+	return (f << doc.dump(1, '\t')).good();
+}
+
+
+void trace::clear()
+{
+	// each thread starts its buffer over when it records its next event (see buffer_t)
+	std::lock_guard lock {registry_mtx};
+	generation++;
+}
+
+
+size_t trace::size()
+{
+	size_t total {0};
+	std::lock_guard lock {registry_mtx};
+	for(auto &buf : buffers)
+		if(buf->generation.load(std::memory_order_acquire) == generation.load())
+			total += buf->count.load(std::memory_order_acquire);
+	return total;
+}
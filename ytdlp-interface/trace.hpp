@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <filesystem>
+
+/* Timeline of what the program does with the queue items, for finding out where the time goes between "queued" and
+   "done" (info extraction, waiting for a slot, yt-dlp startup, download, post-processing). Spans and instants are
+   recorded into a buffer per thread, which only that thread writes to, so recording takes no locks; the buffers are
+   read when the timeline is saved, as a Chrome trace_event JSON file (chrome://tracing, ui.perfetto.dev).
+
+   Nothing is recorded unless recording is turned on (from the queue menu), and when it's off, each instrumentation
+   point costs a relaxed atomic load. The names given to the functions must be string literals (only the pointer is
+   stored). */
+
+namespace trace
+{
+	inline std::atomic_bool enabled {false};
+
+	long long now(); // microseconds since the program started
+	void complete(const char *name, const std::wstring &item, long long start, long long end = now());
+	void instant(const char *name, const std::wstring &item = L"");
+	bool save(const std::filesystem::path &file);
+	void clear();
+	size_t size(); // events recorded so far
+
+	class span // records the time from its construction to its destruction
+	{
+	public:
+		span(const char *name, const std::wstring &item = L"") : name {name}, item {enabled.load(std::memory_order_relaxed) ? item : L""},
+			start {enabled.load(std::memory_order_relaxed) ? now() : -1} {}
+		~span() { if(start != -1) complete(name, item, start); }
+		span(const span &) = delete;
+		span &operator=(const span &) = delete;
+
+	private:
+		const char *name;
+		std::wstring item;
+		long long start;
+	};
+
+	class phases // consecutive spans on one thread, each of which ends where the next one begins
+	{
+	public:
+		phases(const std::wstring &item) : item {item} {}
+		~phases() { enter(nullptr); }
+		void enter(const char *name); // nullptr ends the current phase without starting another one
+
+	private:
+		std::wstring item;
+		const char *current {nullptr};
+		long long start {0};
+	};
+}
@@ -84,21 +84,20 @@ bool semver_t::operator == (const semver_t &o)
 }
 
 
-void favicon_t::add(std::string favicon_url, callback fn)
+void favicon_t::add(std::string favicon_url, callback fn, executor &tasks)
 {
 	if(img.empty())
 	{
 		std::lock_guard<std::mutex> lock {mtx};
 		callbacks.push_back(std::move(fn));
-		if(!thr.joinable())
-			thr = std::thread {[favicon_url, this]
+		if(!fetch.valid())
+			fetch = tasks.submit(executor::pool::io, [favicon_url, this](std::stop_token stop)
 			{
-				working = true;
 				if(!favicon_url.empty())
 				{
 					std::string res, error;
-					res = util::get_inet_res(favicon_url, &error);
-					if(working)
+					res = util::get_inet_res(favicon_url, &error, stop);
+					if(!stop.stop_requested())
 					{
 						std::lock_guard<std::mutex> lock {mtx};
 						if(!img.open(res.data(), res.size()))
@@ -108,12 +107,9 @@ void favicon_t::add(std::string favicon_url, callback fn)
 							callbacks.back()(img);
 							callbacks.pop_back();
 						}
-						working = false;
-						if(thr.joinable())
-							thr.detach();
 					}
 				}
-			}};
+			});
 	}
 	else fn(img);
 }
@@ -121,9 +117,131 @@ void favicon_t::add(std::string favicon_url, callback fn)
 
 favicon_t::~favicon_t()
 {
-	if(thr.joinable())
+	fetch.cancel();
+	fetch.wait();
+}
+
+
+format_t::codec format_t::parse_codec(const std::string &str)
+{
+	static const std::vector<std::pair<std::string, codec>> prefixes {{"none", codec::none}, {"avc", codec::h264},
+		{"h264", codec::h264}, {"hev", codec::h265}, {"hvc", codec::h265}, {"h265", codec::h265}, {"vp8", codec::vp8},
+		{"vp9", codec::vp9}, {"vp09", codec::vp9}, {"av01", codec::av1}, {"mp4a", codec::aac}, {"aac", codec::aac},
+		{"opus", codec::opus}, {"vorbis", codec::vorbis}, {"mp3", codec::mp3}, {"flac", codec::flac}, {"ac-3", codec::ac3},
+		{"ac3", codec::ac3}, {"ec-3", codec::eac3}, {"eac3", codec::eac3}};
+	if(str.empty())
+		return codec::unknown;
+	for(const auto &[prefix, val] : prefixes)
+		if(str.starts_with(prefix))
+			return val;
+	return codec::other;
+}
+
+
+void format_table::build(const nlohmann::json &info)
+{
+	clear();
+	if(!info.is_object() || !info.contains("formats") || !info["formats"].is_array())
+		return;
+
+	auto get_str = [](const nlohmann::json &j, const char *key) -> std::string
+	{
+		auto it {j.find(key)};
+		return it != j.end() && it->is_string() ? it->get<std::string>() : "";
+	};
+	auto get_int = [](const nlohmann::json &j, const char *key) -> int
+	{
+		auto it {j.find(key)};
+		return it != j.end() && it->is_number() ? static_cast<int>(it->get<double>()) : -1;
+	};
+
+	const auto &jformats {info["formats"]};
+	formats.reserve(jformats.size());
+	for(const auto &jfmt : jformats)
 	{
-		working = false;
-		thr.join();
+		if(!jfmt.is_object())
+			continue;
+		auto &fmt {formats.emplace_back()};
+		fmt.id = get_str(jfmt, "format_id");
+		fmt.format = get_str(jfmt, "format");
+		fmt.ext = get_str(jfmt, "ext");
+		fmt.note = get_str(jfmt, "format_note");
+		fmt.resolution = get_str(jfmt, "resolution");
+		fmt.vcodec_str = get_str(jfmt, "vcodec");
+		fmt.acodec_str = get_str(jfmt, "acodec");
+		fmt.vcodec = format_t::parse_codec(fmt.vcodec_str);
+		fmt.acodec = format_t::parse_codec(fmt.acodec_str);
+		fmt.height = get_int(jfmt, "height");
+		fmt.fps = get_int(jfmt, "fps");
+		fmt.vbr = get_int(jfmt, "vbr");
+		fmt.abr = get_int(jfmt, "abr");
+		fmt.asr = get_int(jfmt, "asr");
+		if(auto it {jfmt.find("tbr")}; it != jfmt.end() && it->is_number())
+			fmt.tbr = it->get<double>();
+		if(auto it {jfmt.find("filesize")}; it != jfmt.end() && it->is_number())
+			fmt.filesize = it->get<unsigned long long>();
+		fmt.premium = fmt.note == "Premium";
+		fmt.storyboard = fmt.format.find("storyboard") != -1;
+		const auto proto {get_str(jfmt, "protocol")};
+		fmt.fragmented = proto.starts_with("m3u8") || proto.starts_with("http_dash_segments") || proto == "ism" || proto == "f4m"
+			|| jfmt.contains("fragments");
+
+		const auto idx {formats.size() - 1};
+		by_id.emplace(fmt.id, idx);
+		if(fmt.premium && premium == -1)
+			premium = static_cast<int>(idx);
+		if(fmt.height > max_height)
+			max_height = fmt.height;
 	}
+
+	by_quality.resize(formats.size());
+	for(size_t n {0}; n < by_quality.size(); n++)
+		by_quality[n] = n;
+	std::stable_sort(by_quality.begin(), by_quality.end(), [this](size_t a, size_t b)
+	{
+		const auto &fa {formats[a]}, &fb {formats[b]};
+		if(fa.height != fb.height)
+			return fa.height > fb.height;
+		if(fa.fps != fb.fps)
+			return fa.fps > fb.fps;
+		return fa.tbr > fb.tbr;
+	});
+}
+
+
+const format_t *format_table::find(const std::string &id) const
+{
+	auto it {by_id.find(id)};
+	return it == by_id.end() ? nullptr : &formats[it->second];
+}
+
+
+size_t format_table::mem_size() const
+{
+	auto str_heap = [](const std::string &str) -> size_t { return str.capacity() > 15 ? str.capacity() + 1 : 0; };
+	size_t size {formats.capacity() * sizeof(format_t) + by_quality.capacity() * sizeof(size_t) +
+		by_id.bucket_count() * sizeof(void*) + by_id.size() * (sizeof(decltype(by_id)::value_type) + 2 * sizeof(void*))};
+	for(const auto &fmt : formats)
+		for(const auto *str : {&fmt.id, &fmt.format, &fmt.ext, &fmt.note, &fmt.resolution, &fmt.vcodec_str, &fmt.acodec_str})
+			size += str_heap(*str);
+	for(const auto &[id, idx] : by_id)
+		size += str_heap(id);
+	return size;
+}
+
+
+void packed_text::pack(const std::string &text)
+{
+	size = text.size();
+	data = util::compress(text);
+	if(data.empty() || data.size() >= size)
+		data = text;
+}
+
+
+std::string packed_text::unpack() const
+{
+	if(data.size() == size)
+		return data;
+	return util::decompress(data, size);
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include <chrono>
+#include <algorithm>
+#include <unordered_map>
 #include <nana/gui.hpp>
 #include "util.hpp"
 #include "icons.hpp"
+#include "executor.hpp"
+#include "queue_model.hpp"
 
 struct version_t
 {
@@ -34,13 +38,65 @@ struct favicon_t
 
 	favicon_t() = default;
 	~favicon_t();
-	void add(std::string favicon_url, callback fn);
+	void add(std::string favicon_url, callback fn, executor &tasks); // the first call downloads it on the I/O pool
 	operator const image &() const { return img; }
+	size_t mem_size() const { return img.empty() ? 0 : img.size().width * img.size().height * 4; } // 32-bit DIB
 
 private:
 	image img;
-	std::thread thr;
+	executor::task<void> fetch;
 	std::mutex mtx;
-	bool working {false};
 	std::vector<callback> callbacks;
+};
+
+// The "formats" array of an info dict, parsed once into typed fields, so the code that picks or describes
+// formats doesn't go through JSON lookups and string copies every time.
+struct format_t
+{
+	enum class codec : unsigned char { unknown, none, h264, h265, vp8, vp9, av1, aac, opus, vorbis, mp3, flac, ac3, eac3, other };
+
+	std::string id, format, ext, note, resolution, vcodec_str, acodec_str;
+	codec vcodec {codec::unknown}, acodec {codec::unknown};
+	int height {-1}, fps {-1}, vbr {-1}, abr {-1}, asr {-1}; // -1 = not in the info
+	double tbr {0};
+	unsigned long long filesize {0};
+	bool premium {false}, storyboard {false};
+	bool fragmented {false}; // HLS, DASH, ISM or F4M: downloaded in fragments, which -N can fetch in parallel
+
+	bool video_only() const { return acodec == codec::none; }
+	bool audio_only() const { return vcodec == codec::none; }
+	static codec parse_codec(const std::string &str);
+};
+
+
+struct format_table
+{
+	std::vector<format_t> formats; // in the order of the info dict (worst to best, as yt-dlp lists them)
+	std::unordered_map<std::string, size_t> by_id;
+	std::vector<size_t> by_quality; // best first: height, then fps, then total bitrate
+	int max_height {0}, premium {-1}; // premium: index of YouTube's "Premium" format, -1 if there's none
+
+	void build(const nlohmann::json &info);
+	void clear() { *this = {}; }
+	bool empty() const { return formats.empty(); }
+	const format_t *find(const std::string &id) const;
+	size_t mem_size() const; // estimated heap bytes
+};
+
+
+// Text (a JSON dump) kept compressed in memory, for documents that are held for a long time but read only now and
+// then. If compression isn't available or doesn't pay off, the text is kept as it is.
+class packed_text
+{
+public:
+	void pack(const std::string &text);
+	std::string unpack() const;
+	void clear() { data.clear(); size = 0; }
+	bool empty() const { return size == 0; }
+	size_t packed_size() const { return data.size(); }
+	size_t unpacked_size() const { return size; }
+
+private:
+	std::string data;
+	size_t size {0}; // of the original text; equal to data.size() when it's stored as it is
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "ui_queue.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+
+void ui_queue::post(kind k, const std::wstring &item, std::function<void()> fn)
+{
+	const auto now {trace::now()};
+	std::lock_guard lock {mtx};
+	st.posted++;
+	if(k == kind::other)
+		forget(item);
+	else if(auto it {latest.find({k, item})}; it != latest.end())
+	{
+		entries[it->second].fn = std::move(fn);
+		st.coalesced++;
+		return;
+	}
+	if(k != kind::other)
+		latest[{k, item}] = entries.size();
+	entries.push_back({k, item, std::move(fn), {}, now});
+	count = entries.size();
+}
+
+
+void ui_queue::post_output(const std::wstring &item, std::string text)
+{
+	const auto now {trace::now()};
+	std::lock_guard lock {mtx};
+	st.posted++;
+	if(auto it {latest.find({kind::output, item})}; it != latest.end())
+	{
+		entries[it->second].text += text;
+		st.coalesced++;
+		return;
+	}
+	latest[{kind::output, item}] = entries.size();
+	entries.push_back({kind::output, item, nullptr, std::move(text), now});
+	count = entries.size();
+}
+
+
+void ui_queue::forget(const std::wstring &item)
+{
+	for(auto k : {kind::row, kind::progress_amount, kind::progress_value, kind::progress_shadow, kind::progress_caption, kind::output})
+		latest.erase({k, item});
+}
+
+
+void ui_queue::discard(const std::wstring &item)
+{
+	std::lock_guard lock {mtx};
+	forget(item);
+	for(auto &entry : entries)
+		if(entry.item == item)
+			entry.live = false;
+}
+
+
+size_t ui_queue::drain()
+{
+	std::vector<entry_t> batch;
+	{
+		std::lock_guard lock {mtx};
+		batch.swap(entries);
+		latest.clear();
+		count = 0;
+	}
+	if(batch.empty())
+		return 0;
+
+	size_t applied {0};
+	long long total_latency {0}, max_latency {0};
+	for(auto &entry : batch)
+	{
+		if(!entry.live)
+			continue;
+		const auto latency {trace::now() - entry.posted};
+		if(entry.k == kind::output)
+			sink(entry.item, std::move(entry.text));
+		else entry.fn();
+		total_latency += latency;
+		max_latency = std::max(max_latency, latency);
+		applied++;
+	}
+
+	std::lock_guard lock {mtx};
+	st.applied += applied;
+	st.batches++;
+	st.last_batch = applied;
+	st.max_batch = std::max(st.max_batch, applied);
+	st.total_latency += total_latency;
+	st.max_latency = std::max(st.max_latency, max_latency);
+	return applied;
+}
+
+
+ui_queue::stats_t ui_queue::stats() const
+{
+	std::lock_guard lock {mtx};
+	return st;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+
+/* Updates of the widgets, posted by the worker threads (download, info extraction, favicons) and made by the GUI thread,
+   which drains the queue in batches, a few dozen times per second (see GUI::drain_ui). Any number of threads can post;
+   only the GUI thread drains. An update is tied to a queue item, and is one of a few kinds:
+
+   - the output of an item is merged with the item's pending output, so a batch appends it to the outbox in one go
+   - a row or progress bar update replaces a pending one of the same kind and item, so only the latest one is made
+   - "other" runs as posted, and the item's updates that come after it are made after it, as they're not merged into
+     the ones that came before (it's a barrier for the item's updates)
+
+   The queue keeps counts of what goes through it, the time from posting to making an update (latency), and the size
+   of the batches. */
+
+class ui_queue
+{
+public:
+	enum class kind : unsigned char { row, progress_amount, progress_value, progress_shadow, progress_caption, output, other };
+
+	struct stats_t
+	{
+		size_t posted {0}, coalesced {0}, applied {0}, batches {0}, last_batch {0}, max_batch {0};
+		long long total_latency {0}, max_latency {0}; // microseconds
+	};
+
+	using output_sink = std::function<void(const std::wstring &item, std::string text)>;
+
+	ui_queue(output_sink sink) : sink {std::move(sink)} {}
+
+	void post(kind k, const std::wstring &item, std::function<void()> fn);
+	void post_output(const std::wstring &item, std::string text);
+	void discard(const std::wstring &item); // drops the item's pending updates (call when the item is removed)
+	bool pending() const { return count.load(std::memory_order_relaxed) != 0; }
+	size_t drain(); // GUI thread only; makes the pending updates, returns how many
+	stats_t stats() const;
+
+private:
+	struct entry_t
+	{
+		kind k;
+		std::wstring item;
+		std::function<void()> fn;
+		std::string text; // kind::output
+		long long posted; // trace::now() of the first update that went into the entry
+		bool live {true};
+	};
+
+	void forget(const std::wstring &item); // the item's pending entries are no longer merged into
+
+	mutable std::mutex mtx;
+	std::vector<entry_t> entries;
+	std::map<std::pair<kind, std::wstring>, size_t> latest; // position in entries of the entry that's merged into
+	std::atomic<size_t> count {0};
+	stats_t st;
+	output_sink sink;
+};
@@ -1,19 +1,23 @@
 #include "util.hpp"
+#include "trace.hpp"
 #include "bitextractor.hpp"
 #include "bitexception.hpp"
+#include "bitmemextractor.hpp"
+#include "bitarchiveinfo.hpp"
 
 #include <Netlistmgr.h>
 #include <WinInet.h>
 #include <TlHelp32.h>
+#include <Psapi.h>
+#include <bcrypt.h>
 #include <iostream>
 #include <codecvt>
 
 #pragma warning (disable: 4244)
 
 std::recursive_mutex subclass::mutex_;
-std::map<HWND, subclass*> subclass::table_;
 
-std::string util::format_int(unsigned i)
+std::string util::format_int(unsigned long long i)
 {
 	std::stringstream ss;
 	ss.imbue(std::locale {ss.getloc(), new Sep<char>{}});
@@ -28,9 +32,9 @@ std::string util::format_float(float f, unsigned precision)
 	return ss.str();
 }
 
-std::string util::int_to_filesize(unsigned i, bool with_bytes)
+std::string util::int_to_filesize(unsigned long long i, bool with_bytes)
 {
-	float f {static_cast<float>(i)};
+	double f {static_cast<double>(i)};
 	std::string s, bytes {" (" + format_int(i) + ")"};
 	if(i < 1024)
 		s = format_int(i);
@@ -38,10 +42,58 @@ std::string util::int_to_filesize(unsigned i, bool with_bytes)
 		s = std::to_string(i/1024) + " KB" + (with_bytes ? bytes : "");
 	else if(i < 1024*1024*1024)
 		s = format_float(f/(1024*1024)) + " MB" + (with_bytes ? bytes : "");
-	else s = format_float(f/(1024*1024*1024)) + " GB" + (with_bytes ? bytes : "");
+	else if(i < 1024ull*1024*1024*1024)
+		s = format_float(f/(1024*1024*1024)) + " GB" + (with_bytes ? bytes : "");
+	else s = format_float(f/(1024ull*1024*1024*1024)) + " TB" + (with_bytes ? bytes : "");
 	return s;
 }
 
+std::string util::format_duration(unsigned long long secs)
+{
+	auto two = [](unsigned long long n) { return (n < 10 ? "0" : "") + std::to_string(n); };
+	if(secs >= 3600)
+		return std::to_string(secs / 3600) + ':' + two(secs / 60 % 60) + ':' + two(secs % 60);
+	return std::to_string(secs / 60) + ':' + two(secs % 60);
+}
+
+static double parse_amount(const std::string &str) // "1.23MiB", "4.5 KB/s"... to bytes, -1 if it's not a number
+{
+	auto pos {str.find_first_not_of(" ~")};
+	if(pos == -1 || !isdigit(str[pos]))
+		return -1; // "Unknown B/s", "Unknown"
+	char *end {nullptr};
+	double val {std::strtod(str.data() + pos, &end)};
+	if(!end) return -1;
+	std::string unit {end};
+	double mul {unit.size() > 1 && unit[1] == 'i' ? 1024.0 : 1000.0};
+	if(unit.starts_with("K") || unit.starts_with("k")) val *= mul;
+	else if(unit.starts_with("M")) val *= mul * mul;
+	else if(unit.starts_with("G")) val *= mul * mul * mul;
+	else if(unit.starts_with("T")) val *= mul * mul * mul * mul;
+	return val;
+}
+
+double util::parse_speed(const std::string &text)
+{
+	std::string str;
+	auto pos {text.find(" at ")};
+	if(pos != -1)
+		str = text.substr(pos + 4);
+	else if((pos = text.find("DL:")) != -1)
+		str = text.substr(pos + 3);
+	else return -1;
+	return parse_amount(str);
+}
+
+double util::parse_size(const std::string &text)
+{
+	if(auto pos {text.find("% of ")}; pos != -1) // yt-dlp: "[download]  45.2% of ~ 1.23GiB at ..."
+		return parse_amount(text.substr(pos + 5));
+	if(auto pos {text.find("/")}, pos2 {text.find("DL:")}; pos != -1 && pos2 != -1 && pos < pos2) // aria2c: "[#1 12MiB/345MiB(3%) CN:16 DL:2MiB]"
+		return parse_amount(text.substr(pos + 1));
+	return -1;
+}
+
 std::string util::GetLastErrorStr(bool inet)
 {
 	std::string str(4096, '\0');
@@ -95,13 +147,15 @@ std::vector<HWND> util::hwnds_from_pid(DWORD pid)
 	return lparam.hwnds;
 }
 
-std::string util::run_piped_process(std::wstring cmd, bool *working, append_callback cbappend, progress_callback cbprog, bool *graceful_exit, std::string suppress)
+std::string util::run_piped_process(std::wstring cmd, std::atomic_bool *working, append_callback cbappend, progress_callback cbprog, bool *graceful_exit, status_callback cbstatus,
+								bool low_priority)
 {
 	std::wstring modpath(4096, '\0');
 	modpath.resize(GetModuleFileNameW(0, &modpath.front(), modpath.size()));
 
 	std::string ret;
 	HANDLE hPipeRead, hPipeWrite;
+	trace::span span {"process"};
 
 	SECURITY_ATTRIBUTES sa {sizeof(SECURITY_ATTRIBUTES)};
 	sa.bInheritHandle = TRUE;
@@ -118,7 +172,12 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 
 	PROCESS_INFORMATION pi {0};
 
-	BOOL res {CreateProcessW(NULL, &cmd.front(), NULL, NULL, TRUE, CREATE_NEW_CONSOLE|CREATE_NEW_PROCESS_GROUP, NULL, NULL, &si, &pi)};
+	// a process started with below normal priority passes it on to its children (yt-dlp to ffmpeg)
+	DWORD flags {CREATE_NEW_CONSOLE | CREATE_NEW_PROCESS_GROUP};
+	if(low_priority)
+		flags |= BELOW_NORMAL_PRIORITY_CLASS;
+	BOOL res {CreateProcessW(NULL, &cmd.front(), NULL, NULL, TRUE, flags, NULL, NULL, &si, &pi)};
+	trace::instant("process: spawned");
 	if(!res)
 	{
 		CloseHandle(hPipeWrite);
@@ -144,8 +203,8 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 		if(graceful_exit)
 			*graceful_exit = false;
 	};
-	std::string playlist_line;
-	bool procexit {false}, subs {false};
+	std::string playlist_line, status_line; // status_line: the start of a status line that was cut off by the end of a read
+	bool procexit {false}, subs {false}, first_read {true};
 	while(!procexit)
 	{
 		procexit = WaitForSingleObject(pi.hProcess, 50) == WAIT_OBJECT_0;
@@ -164,6 +223,11 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 
 			if(!::ReadFile(hPipeRead, buf, min(sizeof(buf) - 1, dwAvail), &dwRead, NULL) || !dwRead)
 				break;
+			if(first_read)
+			{
+				first_read = false;
+				trace::instant("process: first output");
+			}
 
 			if(working && !(*working))
 			{
@@ -187,6 +251,8 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 					std::wstring_convert<std::codecvt_utf8<wchar_t>> u8conv;
 					strbuf = u8conv.to_bytes(wstr);
 				}
+				strbuf = status_line + strbuf;
+				status_line.clear();
 				size_t lnstart {0}, lnend {0};
 				do
 				{
@@ -197,13 +263,25 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 						if(lnend != 1)
 							line = strbuf.substr(lnstart, lnend - lnstart);
 						else line = strbuf.substr(lnstart);
+						if(lnend == -1 && (line.starts_with(status_marker) || std::string_view {status_marker}.starts_with(line)))
+						{
+							status_line = line;
+							continue;
+						}
 						if(line.size()) 
 							line += '\n';
 						if(lnend + 1 == strbuf.size())
 							lnend = -1;
 						else lnstart = lnend + 1;
 					}
-					if(!line.empty() && (suppress.empty() || line.find(suppress) == -1))
+					if(line.starts_with(status_marker))
+					{
+						line.pop_back();
+						if(cbstatus && *working)
+							cbstatus(line.substr(sizeof status_marker - 1));
+						continue;
+					}
+					if(!line.empty())
 					{
 						if(cbappend && *working && line[0] == '[')
 						{
@@ -214,13 +292,10 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 								if(text != "[download]" && text[1] != '#')
 									if(*working)
 										cbappend(text, true);
-								if(text == "[Exec]" && text.find("ytdlp_status") != 1)
-									continue;
 								if(text == "[ExtractAudio]" || text.starts_with("[Fixup") || text == "[Merger]")
 									cbprog(-1, -1, text, 0, 0);
-								else if(!suppress.empty())
-									if(text == "[download]" && (line.find("Destination:") == 11 || line.find("has already been downloaded") != -1))
-										cbprog(-1, -1, line, 0, 0);
+								else if(text == "[download]" && (line.find("Destination:") == 11 || line.find("has already been downloaded") != -1))
+									cbprog(-1, -1, line, 0, 0);
 							}
 						}
 						const bool line_starts_with_download {line.starts_with("[download]")},
@@ -292,6 +367,7 @@ std::string util::run_piped_process(std::wstring cmd, bool *working, append_call
 		}
 	}
 
+	trace::instant("process: exited");
 	DWORD exit_code {0};
 	GetExitCodeProcess(pi.hProcess, &exit_code);
 	if(exit_code == 1 && cbprog)
@@ -363,7 +439,7 @@ std::wstring util::get_sys_folder(REFKNOWNFOLDERID rfid)
 	return sres;
 }
 
-std::string util::get_inet_res(std::string res, std::string *error)
+std::string util::get_inet_res(std::string res, std::string *error, std::stop_token stop)
 {
 	std::string ret;
 	if(error) error->clear();
@@ -382,11 +458,25 @@ std::string util::get_inet_res(std::string res, std::string *error)
 	auto hinet {InternetOpenA(agent, INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0)};
 	if(hinet)
 	{
+		// closing the session handle from another thread makes the blocked calls on it return with an error
+		std::mutex mtx;
+		bool closed {false};
+		auto close_session = [&]
+		{
+			std::lock_guard lock {mtx};
+			if(!closed)
+			{
+				closed = true;
+				InternetCloseHandle(hinet);
+			}
+		};
+		std::stop_callback on_stop {stop, close_session};
+
 		auto hfile {InternetOpenUrlA(hinet, res.data(), NULL, 0, 0, 0)};
 		if(hfile)
 		{
 			DWORD read {1};
-			while(read)
+			while(read && !stop.stop_requested())
 			{
 				std::string buf(4096, '\0');
 				if(InternetReadFile(hfile, &buf.front(), buf.size(), &read))
@@ -397,22 +487,33 @@ std::string util::get_inet_res(std::string res, std::string *error)
 				}
 				else
 				{
-					if(error) *error = GetLastErrorStr(true);
+					if(error && !stop.stop_requested()) *error = GetLastErrorStr(true);
 					break;
 				}
 			}
-			InternetCloseHandle(hfile);
+			std::lock_guard lock {mtx};
+			if(!closed) // closing the session has closed the request handle too
+				InternetCloseHandle(hfile);
 		}
-		else if(error) *error = GetLastErrorStr(true);
-		InternetCloseHandle(hinet);
+		else if(error && !stop.stop_requested()) *error = GetLastErrorStr(true);
+		close_session();
+		if(stop.stop_requested())
+			ret.clear();
 	}
 	else if(error) *error = GetLastErrorStr(true);
 	return ret;
 }
 
-std::string util::dl_inet_res(std::string res, fs::path fname, bool *working, std::function<void(unsigned)> cb)
+std::string util::dl_inet_res(std::string res, fs::path fname, bool *working, std::function<void(unsigned)> cb, std::string *sha256,
+							   std::function<void(const std::string&)> cbdata)
 {
 	std::string ret;
+	std::unique_ptr<sha256_stream> hasher;
+	if(sha256)
+	{
+		sha256->clear();
+		hasher = std::make_unique<sha256_stream>();
+	}
 	std::ofstream f {fname, std::ios::binary};
 	if(!f.good())
 		return "Failed to open file for writing: " + fname.string();
@@ -444,6 +545,10 @@ std::string util::dl_inet_res(std::string res, fs::path fname, bool *working, st
 						ret = "Failed writing to file: " + fname.string();
 						break;
 					}
+					if(cbdata && read)
+						cbdata(buf);
+					if(hasher && read)
+						hasher->update(buf);
 					if(cb)
 					{
 						if(working)
@@ -467,9 +572,319 @@ std::string util::dl_inet_res(std::string res, fs::path fname, bool *working, st
 	}
 	else ret = GetLastErrorStr(true);
 
+	if(hasher)
+	{
+		auto digest {hasher->finish()};
+		if(ret.empty() && (!working || *working))
+			*sha256 = digest;
+	}
+
 	return ret;
 }
 
+
+std::string util::sha256_from_sums(const std::string &sums, std::string fname)
+{
+	std::stringstream ss {sums};
+	std::string line;
+	while(std::getline(ss, line))
+	{
+		if(!line.empty() && line.back() == '\r')
+			line.pop_back();
+		auto pos {line.find(' ')};
+		if(pos == 64)
+		{
+			auto name {line.substr(line.find_first_not_of(" *", pos))};
+			if(name == fname)
+			{
+				auto digest {line.substr(0, 64)};
+				for(auto &c : digest)
+					c = std::tolower(c);
+				return digest;
+			}
+		}
+	}
+	return "";
+}
+
+
+util::unzip_stream::unzip_stream(fs::path out_path, std::vector<std::string> wanted) : outdir {out_path}, wanted {wanted}
+{
+	std::wstring modpath(4096, '\0');
+	modpath.resize(GetModuleFileNameW(0, &modpath.front(), modpath.size()));
+	fs::path lib_path {modpath};
+	lib_path.replace_filename("7z.dll");
+
+	thr = std::thread {[this, lib_path]
+	{
+		using namespace bit7z;
+		using namespace std::chrono;
+		std::unique_ptr<Bit7zLibrary> lib;
+		try { lib = std::make_unique<Bit7zLibrary>(lib_path); }
+		catch(const BitException &ex) { err = ex.what(); }
+
+		std::unique_lock<std::mutex> lock {mtx};
+		while(true)
+		{
+			cv.wait(lock, [this] { return done || !jobs.empty(); });
+			if(jobs.empty())
+				break;
+			auto job {std::move(jobs.front())};
+			jobs.pop_front();
+			lock.unlock();
+			if(lib && err.empty())
+			{
+				try
+				{
+					auto t0 {steady_clock::now()};
+					std::vector<byte_t> in {job.second.begin(), job.second.end()}, out;
+					BitMemExtractor {*lib, BitFormat::Zip}.extract(in, out, 0);
+					auto t1 {steady_clock::now()};
+					std::ofstream f {outdir / job.first, std::ios::binary};
+					f.write(reinterpret_cast<const char*>(out.data()), out.size());
+					if(f.good())
+						extracted++;
+					else err = "Failed writing to file: " + (outdir / job.first).string();
+					decompress_ms += duration_cast<milliseconds>(t1 - t0).count();
+					write_ms += duration_cast<milliseconds>(steady_clock::now() - t1).count();
+				}
+				catch(const BitException &ex) { err = ex.what(); }
+			}
+			lock.lock();
+		}
+	}};
+}
+
+
+util::unzip_stream::~unzip_stream()
+{
+	if(thr.joinable())
+		finish();
+}
+
+
+void util::unzip_stream::feed(const std::string &chunk)
+{
+	if(ended || gave_up)
+		return;
+	pending += chunk;
+	parse();
+}
+
+
+void util::unzip_stream::parse()
+{
+	auto get16 = [this](size_t pos) { return unsigned(uint8_t(pending[pos])) | unsigned(uint8_t(pending[pos + 1])) << 8; };
+	auto get32 = [&](size_t pos) { return get16(pos) | get16(pos + 2) << 16; };
+
+	size_t pos {0};
+	while(!ended && !gave_up)
+	{
+		if(in_data)
+		{
+			auto n {std::min<unsigned long long>(member_left, pending.size() - pos)};
+			if(keep) member.append(pending, pos, n);
+			pos += n;
+			member_left -= n;
+			if(member_left)
+				break;
+			in_data = false;
+			if(keep)
+			{
+				push_member();
+				found++;
+			}
+			continue;
+		}
+
+		if(found >= wanted.size()) // what comes after the last wanted member doesn't matter
+		{
+			ended = true;
+			break;
+		}
+		if(pending.size() - pos < 30)
+			break;
+		if(get32(pos) != 0x04034b50) // past the last local header (central directory)
+		{
+			ended = true;
+			break;
+		}
+		const auto flags {get16(pos + 6)}, name_len {get16(pos + 26)}, extra_len {get16(pos + 28)};
+		if(pending.size() - pos < 30 + name_len + extra_len)
+			break;
+		const unsigned csize {get32(pos + 18)}, usize {get32(pos + 22)};
+		std::string name {pending.substr(pos + 30, name_len)};
+		std::replace(name.begin(), name.end(), '\\', '/');
+		keep = false;
+		for(const auto &w : wanted)
+			if(name.ends_with('/' + w) || name == w)
+				keep = true;
+		if((flags & 8) || csize == 0xffffffff || usize == 0xffffffff)
+		{
+			// size not known from the local header; can't find the next header without inflating, so bail out
+			gave_up = true;
+			break;
+		}
+		if(keep)
+		{
+			member_name = name.substr(name.rfind('/') + 1);
+			member_header = pending.substr(pos, 30);
+			member.clear();
+			member.reserve(csize);
+		}
+		member_left = csize;
+		in_data = true;
+		pos += 30 + name_len + extra_len;
+	}
+	pending.erase(0, pos);
+	if(ended || gave_up)
+		pending.clear();
+}
+
+
+void util::unzip_stream::push_member()
+{
+	// wrap the member in a minimal single-entry zip, so that 7-Zip can decode it from memory
+	auto put16 = [](std::string &s, unsigned v) { s += char(v & 0xff); s += char(v >> 8 & 0xff); };
+	auto put32 = [&](std::string &s, unsigned v) { put16(s, v & 0xffff); put16(s, v >> 16); };
+
+	std::string zip {member_header};
+	zip[26] = char(member_name.size() & 0xff);
+	zip[27] = char(member_name.size() >> 8);
+	zip[28] = zip[29] = 0; // drop the extra field
+	zip += member_name;
+	zip += member;
+	const unsigned cd_offset = zip.size();
+
+	std::string cd;
+	put32(cd, 0x02014b50);
+	put16(cd, 20); // version made by
+	cd += member_header.substr(4, 26 - 4); // version needed .. uncompressed size
+	put16(cd, member_name.size());
+	put16(cd, 0); // extra
+	put16(cd, 0); // comment
+	put16(cd, 0); // disk
+	put16(cd, 0); // internal attributes
+	put32(cd, 0); // external attributes
+	put32(cd, 0); // local header offset
+	cd += member_name;
+	zip += cd;
+
+	put32(zip, 0x06054b50);
+	put16(zip, 0);
+	put16(zip, 0);
+	put16(zip, 1);
+	put16(zip, 1);
+	put32(zip, cd.size());
+	put32(zip, cd_offset);
+	put16(zip, 0);
+
+	{
+		std::lock_guard<std::mutex> lock {mtx};
+		jobs.emplace_back(member_name, std::move(zip));
+	}
+	cv.notify_one();
+	member.clear();
+}
+
+
+bool util::unzip_stream::finish()
+{
+	if(thr.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock {mtx};
+			done = true;
+		}
+		cv.notify_one();
+		thr.join();
+	}
+	return !gave_up && err.empty() && extracted == wanted.size();
+}
+
+
+util::sha256_stream::sha256_stream()
+{
+	BCRYPT_ALG_HANDLE alg {nullptr};
+	BCRYPT_HASH_HANDLE hash {nullptr};
+	DWORD objlen {0}, cb {0};
+	if(BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&alg, BCRYPT_SHA256_ALGORITHM, NULL, 0)))
+	{
+		halg = alg;
+		if(BCRYPT_SUCCESS(BCryptGetProperty(alg, BCRYPT_OBJECT_LENGTH, reinterpret_cast<PUCHAR>(&objlen), sizeof objlen, &cb, 0)))
+		{
+			hashobj.resize(objlen);
+			if(BCRYPT_SUCCESS(BCryptCreateHash(alg, &hash, reinterpret_cast<PUCHAR>(&hashobj.front()), objlen, NULL, 0, 0)))
+				hhash = hash;
+		}
+	}
+	failed = hhash == nullptr;
+
+	thr = std::thread {[this]
+	{
+		std::unique_lock<std::mutex> lock {mtx};
+		while(true)
+		{
+			cv.wait(lock, [this] { return done || !chunks.empty(); });
+			if(chunks.empty())
+				break;
+			auto chunk {std::move(chunks.front())};
+			chunks.pop_front();
+			lock.unlock();
+			if(!failed && !BCRYPT_SUCCESS(BCryptHashData(hhash, reinterpret_cast<PUCHAR>(chunk.data()), chunk.size(), 0)))
+				failed = true;
+			lock.lock();
+		}
+	}};
+}
+
+
+util::sha256_stream::~sha256_stream()
+{
+	if(thr.joinable())
+		finish();
+	if(hhash) BCryptDestroyHash(hhash);
+	if(halg) BCryptCloseAlgorithmProvider(halg, 0);
+}
+
+
+void util::sha256_stream::update(std::string chunk)
+{
+	{
+		std::lock_guard<std::mutex> lock {mtx};
+		chunks.push_back(std::move(chunk));
+	}
+	cv.notify_one();
+}
+
+
+std::string util::sha256_stream::finish()
+{
+	if(thr.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock {mtx};
+			done = true;
+		}
+		cv.notify_one();
+		thr.join();
+	}
+	else return "";
+
+	unsigned char digest[32] {0};
+	if(failed || !BCRYPT_SUCCESS(BCryptFinishHash(hhash, digest, sizeof digest, 0)))
+		return "";
+
+	std::string hex;
+	const char *digits {"0123456789abcdef"};
+	for(auto b : digest)
+	{
+		hex += digits[b >> 4];
+		hex += digits[b & 0xf];
+	}
+	return hex;
+}
+
 std::string util::extract_7z(fs::path arc_path, fs::path out_path, unsigned ffmpeg, bool ytdlp_interface)
 {
 	using namespace bit7z;
@@ -485,10 +900,20 @@ std::string util::extract_7z(fs::path arc_path, fs::path out_path, unsigned ffmp
 		BitExtractor extractor {lib, ffmpeg ? BitFormat::Zip : BitFormat::SevenZip};
 		if(ffmpeg)
 		{
-			extractor.extractMatching(arc_path, L"*\\bin\\ffmpeg.exe", out_path);
-			extractor.extractMatching(arc_path, L"*\\bin\\ffprobe.exe", out_path);
-			if(ffmpeg > 1)
-				extractor.extractMatching(arc_path, L"*\\bin\\ffplay.exe", out_path);
+			// collect the indices first, so that the archive is only decoded once
+			std::vector<uint32_t> indices;
+			BitArchiveInfo info {lib, arc_path, BitFormat::Zip};
+			for(const auto &item : info.items())
+			{
+				std::wstring path {item.path()};
+				std::replace(path.begin(), path.end(), L'/', L'\\');
+				if(path.ends_with(L"\\bin\\ffmpeg.exe") || path.ends_with(L"\\bin\\ffprobe.exe") ||
+				   (ffmpeg > 1 && path.ends_with(L"\\bin\\ffplay.exe")))
+					indices.push_back(item.index());
+			}
+			if(indices.empty())
+				return "The archive doesn't contain the FFmpeg executables";
+			extractor.extractItems(arc_path, indices, out_path);
 		}
 		else if(ytdlp_interface)
 		{
@@ -550,6 +975,134 @@ void util::set_clipboard_text(HWND hwnd, std::wstring text)
 	}
 }
 
+size_t util::json_mem_size(const nlohmann::json &j)
+{
+	// MSVC's containers: strings up to 15 chars are stored inline, tree nodes have 32 bytes of links and flags
+	using json = nlohmann::json;
+	auto str_heap = [](const std::string &str) -> size_t { return str.capacity() > 15 ? str.capacity() + 1 : 0; };
+	size_t size {0};
+	switch(j.type())
+	{
+	case json::value_t::object:
+		size += sizeof(json::object_t);
+		for(const auto &[key, val] : j.get_ref<const json::object_t&>())
+			size += 32 + sizeof(json::object_t::value_type) + str_heap(key) + json_mem_size(val);
+		break;
+	case json::value_t::array:
+	{
+		const auto &arr {j.get_ref<const json::array_t&>()};
+		size += sizeof(json::array_t) + arr.capacity() * sizeof(json);
+		for(const auto &el : arr)
+			size += json_mem_size(el);
+		break;
+	}
+	case json::value_t::string:
+		size += sizeof(json::string_t) + str_heap(j.get_ref<const json::string_t&>());
+		break;
+	case json::value_t::binary:
+		size += sizeof(json::binary_t) + j.get_binary().capacity();
+		break;
+	default:
+		break;
+	}
+	return size;
+}
+
+util::process_stats util::get_process_stats()
+{
+	process_stats stats;
+	const auto proc {GetCurrentProcess()};
+	PROCESS_MEMORY_COUNTERS_EX pmc {};
+	if(GetProcessMemoryInfo(proc, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof pmc))
+	{
+		stats.working_set = pmc.WorkingSetSize;
+		stats.peak_working_set = pmc.PeakWorkingSetSize;
+		stats.private_bytes = pmc.PrivateUsage;
+	}
+	DWORD handles {0};
+	if(GetProcessHandleCount(proc, &handles))
+		stats.handles = handles;
+	stats.gdi_objects = GetGuiResources(proc, GR_GDIOBJECTS);
+	stats.user_objects = GetGuiResources(proc, GR_USEROBJECTS);
+
+	auto snap {CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0)};
+	if(snap != INVALID_HANDLE_VALUE)
+	{
+		const auto pid {GetCurrentProcessId()};
+		THREADENTRY32 te {sizeof te};
+		if(Thread32First(snap, &te))
+			do if(te.th32OwnerProcessID == pid)
+				stats.threads++;
+			while(Thread32Next(snap, &te));
+		CloseHandle(snap);
+	}
+	return stats;
+}
+
+namespace
+{
+	// the compression functions of ntdll, loaded at runtime like RtlGetNtVersionNumbers in themed_form.cpp
+	using fnRtlGetCompressionWorkSpaceSize = LONG(WINAPI*)(USHORT format, PULONG buf_ws_size, PULONG frag_ws_size);
+	using fnRtlCompressBuffer = LONG(WINAPI*)(USHORT format, PUCHAR src, ULONG src_size, PUCHAR dst, ULONG dst_size,
+											  ULONG chunk_size, PULONG final_size, PVOID workspace);
+	using fnRtlDecompressBufferEx = LONG(WINAPI*)(USHORT format, PUCHAR dst, ULONG dst_size, PUCHAR src, ULONG src_size,
+												  PULONG final_size, PVOID workspace);
+
+	constexpr USHORT xpress_huff {4}; // COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_STANDARD
+
+	struct ntdll_compression
+	{
+		fnRtlGetCompressionWorkSpaceSize workspace_size {nullptr};
+		fnRtlCompressBuffer compress {nullptr};
+		fnRtlDecompressBufferEx decompress {nullptr};
+		ULONG buf_ws_size {0}, frag_ws_size {0};
+
+		ntdll_compression()
+		{
+			auto ntdll {GetModuleHandleW(L"ntdll.dll")};
+			if(!ntdll) return;
+			workspace_size = reinterpret_cast<fnRtlGetCompressionWorkSpaceSize>(GetProcAddress(ntdll, "RtlGetCompressionWorkSpaceSize"));
+			compress = reinterpret_cast<fnRtlCompressBuffer>(GetProcAddress(ntdll, "RtlCompressBuffer"));
+			decompress = reinterpret_cast<fnRtlDecompressBufferEx>(GetProcAddress(ntdll, "RtlDecompressBufferEx"));
+			if(!workspace_size || !compress || !decompress || workspace_size(xpress_huff, &buf_ws_size, &frag_ws_size) != 0)
+				compress = nullptr;
+		}
+	};
+
+	const ntdll_compression &ntdll_comp()
+	{
+		static const ntdll_compression funcs;
+		return funcs;
+	}
+}
+
+std::string util::compress(const std::string &data)
+{
+	const auto &nt {ntdll_comp()};
+	if(!nt.compress || data.empty() || data.size() > ULONG_MAX)
+		return "";
+	std::string out(data.size(), '\0'), workspace(nt.buf_ws_size, '\0');
+	ULONG final_size {0};
+	if(nt.compress(xpress_huff, (PUCHAR)data.data(), data.size(), (PUCHAR)out.data(), out.size(), 4096, &final_size, workspace.data()) != 0)
+		return ""; // also when the output would be larger than the input
+	out.resize(final_size);
+	out.shrink_to_fit();
+	return out;
+}
+
+std::string util::decompress(const std::string &data, size_t size)
+{
+	const auto &nt {ntdll_comp()};
+	if(!nt.compress || data.empty() || size > ULONG_MAX)
+		return "";
+	std::string out(size, '\0'), workspace(nt.frag_ws_size, '\0');
+	ULONG final_size {0};
+	if(nt.decompress(xpress_huff, (PUCHAR)out.data(), out.size(), (PUCHAR)data.data(), data.size(), &final_size, workspace.data()) != 0)
+		return "";
+	out.resize(final_size);
+	return out;
+}
+
 bool util::is_dir_writable(fs::path dir)
 {
 	if(std::ofstream {dir / "write_test.out"}.good())
@@ -9,6 +9,11 @@
 #include <fstream>
 #include <sstream>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <stop_token>
+#include <deque>
+#include <condition_variable>
 
 #include <nana/gui.hpp>
 
@@ -32,31 +37,111 @@ namespace util
 		CONNECTION_ERROR
 	};
 
+	struct process_stats
+	{
+		unsigned long long working_set {0}, peak_working_set {0}, private_bytes {0};
+		unsigned threads {0}, handles {0}, gdi_objects {0}, user_objects {0};
+	};
+
 	using progress_callback = std::function<void(ULONGLONG, ULONGLONG, std::string, int, int)>;
 	using append_callback = std::function<void(std::string, bool)>;
+	using status_callback = std::function<void(const std::string &)>;
 
-	std::string format_int(unsigned i);
+	// prefix of the lines that the program has yt-dlp print with --print, to tell it about a queue item's progress
+	// through the stages (see GUI::process_queue_item); run_piped_process hands them to its status callback
+	constexpr char status_marker[] {"@ytdlp-interface@ "};
+
+	std::string format_int(unsigned long long i);
 	std::string format_float(float f, unsigned precision = 2);
-	std::string int_to_filesize(unsigned i, bool with_bytes = true);
+	std::string int_to_filesize(unsigned long long i, bool with_bytes = true);
+	std::string format_duration(unsigned long long secs); // "m:ss" or "h:mm:ss"
+	double parse_speed(const std::string &text); // bytes/s from a yt-dlp or aria2c progress line, -1 if there's none
+	double parse_size(const std::string &text); // size in bytes of the file that a progress line is about, -1 if it's not there
 	std::string GetLastErrorStr(bool inet = false);
 	HWND hwnd_from_pid(DWORD pid);
 	std::vector<HWND> hwnds_from_pid(DWORD pid);
-	std::string run_piped_process(std::wstring cmd, bool *working = nullptr, append_callback cbappend = nullptr,
-								  progress_callback cbprog = nullptr, bool *graceful_exit = nullptr, std::string suppress = "");
+	std::string run_piped_process(std::wstring cmd, std::atomic_bool *working = nullptr, append_callback cbappend = nullptr,
+								  progress_callback cbprog = nullptr, bool *graceful_exit = nullptr, status_callback cbstatus = nullptr,
+								  bool low_priority = false);
 	DWORD other_instance(std::wstring path = L"");
 	std::wstring get_sys_folder(REFKNOWNFOLDERID rfid);
-	std::string get_inet_res(std::string res, std::string *error = nullptr);
-	std::string dl_inet_res(std::string res, fs::path fname, bool *working = nullptr, std::function<void(unsigned)> cb = nullptr);
+	std::string get_inet_res(std::string res, std::string *error = nullptr, std::stop_token stop = {}); // a stop request aborts it
+	std::string dl_inet_res(std::string res, fs::path fname, bool *working = nullptr, std::function<void(unsigned)> cb = nullptr,
+							std::string *sha256 = nullptr, std::function<void(const std::string&)> cbdata = nullptr);
+	std::string sha256_from_sums(const std::string &sums, std::string fname); // parses "<hex>  <fname>" lines (SHA2-256SUMS)
 	std::string extract_7z(fs::path arc_path, fs::path out_path, unsigned ffmpeg = 0, bool ytdlp_interface = false);
 	std::wstring get_clipboard_text();
 	void set_clipboard_text(HWND hwnd, std::wstring text);
+	size_t json_mem_size(const nlohmann::json &j); // estimated heap bytes held by a parsed document
+	process_stats get_process_stats();
+	std::string compress(const std::string &data); // XPRESS Huffman (ntdll); empty string if it can't be done
+	std::string decompress(const std::string &data, size_t size); // size: the size of the original data
 	bool is_dir_writable(fs::path dir);
 	int scale(int val); // DPI scaling
 	unsigned scale_uint(unsigned val); // DPI scaling
 	INTERNET_STATUS check_inet_connection();
+
+	// SHA-256 computed on a worker thread, so the caller (the network loop) only pays for a copy of each chunk.
+	// Uses the CNG provider, which takes the SHA extensions (SHA-NI) path on CPUs that have them.
+	class sha256_stream
+	{
+	public:
+		sha256_stream();
+		~sha256_stream();
+		void update(std::string chunk);
+		std::string finish(); // lowercase hex digest, empty string if CNG failed
+
+	private:
+		void *halg {nullptr}, *hhash {nullptr};
+		std::string hashobj;
+		std::deque<std::string> chunks;
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::thread thr;
+		bool done {false}, failed {false};
+	};
+
+	// Extracts the wanted members of a zip archive while it is being downloaded: feed() parses the local file headers
+	// as the data comes in, and each completed member is decompressed and written on a worker thread. Only the
+	// entries whose sizes are in the local header can be handled this way; if any member before the last wanted one
+	// uses a data descriptor or zip64, the next header can't be found without inflating it, so the stream gives up and
+	// the caller extracts from the downloaded file instead.
+	class unzip_stream
+	{
+	public:
+		unzip_stream(fs::path out_path, std::vector<std::string> wanted); // wanted: member paths ending with these
+		~unzip_stream();
+		void feed(const std::string &chunk);
+		bool finish(); // true if every wanted member was extracted
+		std::string error() { return err; }
+		double secs_decompress() { return decompress_ms / 1000.0; }
+		double secs_write() { return write_ms / 1000.0; }
+
+	private:
+		void parse();
+		void push_member();
+
+		fs::path outdir;
+		std::vector<std::string> wanted;
+		std::string pending, member, member_name, member_header;
+		unsigned long long member_left {0};
+		bool in_data {false}, keep {false}, ended {false}, gave_up {false}, done {false};
+		unsigned extracted {0}, found {0}; // found: members handed to the worker thread
+		std::deque<std::pair<std::string, std::string>> jobs; // {member file name, single-entry zip}
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::thread thr;
+		std::string err;
+		long long decompress_ms {0}, write_ms {0};
+	};
 }
 
 // https://github.com/qPCR4vir/nana-demo/blob/master/Examples/windows-subclassing.cpp
+/* The message handlers of a window are kept in an immutable table that's replaced as a whole when a handler is added
+   or removed, and published through an atomic pointer; the subclass is found through a property of the window. This
+   way, the window procedure (which sees every message of the window) doesn't lock anything: only the functions that
+   change the handlers do. A replaced table is kept until the subclass is destroyed, because a message that's being
+   handled may still be using it (handlers are only changed a few times in the life of a window). */
 class subclass
 {
 	struct msg_pro
@@ -65,11 +150,12 @@ class subclass
 		std::function<bool(UINT, WPARAM, LPARAM, LRESULT*)> after;
 	};
 
+	typedef std::map<UINT, msg_pro> msg_table;
 	typedef std::lock_guard<std::recursive_mutex> lock_guard;
 public:
 	subclass(nana::window wd)
 		: native_(reinterpret_cast<HWND>(nana::API::root(wd))),
-		old_proc_(nullptr)
+		old_proc_(nullptr), msg_table_(nullptr)
 	{
 	}
 
@@ -81,65 +167,72 @@ public:
 	void make_before(UINT msg, std::function<bool(UINT, WPARAM, LPARAM, LRESULT*)> fn)
 	{
 		lock_guard lock(mutex_);
-		msg_table_[msg].before = std::move(fn);
+		_m_update([&](msg_table &table) { table[msg].before = std::move(fn); });
 		_m_subclass(true);
 	}
 
 	void make_after(UINT msg, std::function<bool(UINT, WPARAM, LPARAM, LRESULT*)> fn)
 	{
 		lock_guard lock(mutex_);
-		msg_table_[msg].after = std::move(fn);
+		_m_update([&](msg_table &table) { table[msg].after = std::move(fn); });
 		_m_subclass(true);
 	}
 
 	void umake_before(UINT msg)
 	{
 		lock_guard lock(mutex_);
-		auto i = msg_table_.find(msg);
-		if(msg_table_.end() != i)
+		_m_update([&](msg_table &table)
 		{
-			i->second.before = nullptr;
-			if(nullptr == i->second.after)
+			auto i = table.find(msg);
+			if(table.end() != i)
 			{
-				msg_table_.erase(msg);
-				if(msg_table_.empty())
-					_m_subclass(false);
+				i->second.before = nullptr;
+				if(nullptr == i->second.after)
+					table.erase(i);
 			}
-		}
+		});
 	}
 
 	void umake_after(UINT msg)
 	{
 		lock_guard lock(mutex_);
-		auto i = msg_table_.find(msg);
-		if(msg_table_.end() != i)
+		_m_update([&](msg_table &table)
 		{
-			i->second.after = nullptr;
-			if(nullptr == i->second.before)
+			auto i = table.find(msg);
+			if(table.end() != i)
 			{
-				msg_table_.erase(msg);
-				if(msg_table_.empty())
-					_m_subclass(false);
+				i->second.after = nullptr;
+				if(nullptr == i->second.before)
+					table.erase(i);
 			}
-		}
+		});
 	}
 
 	void umake(UINT msg)
 	{
 		lock_guard lock(mutex_);
-		msg_table_.erase(msg);
-
-		if(msg_table_.empty())
-			_m_subclass(false);
+		_m_update([&](msg_table &table) { table.erase(msg); });
 	}
 
 	void clear()
 	{
 		lock_guard lock(mutex_);
-		msg_table_.clear();
-		_m_subclass(false);
+		_m_update([](msg_table &table) { table.clear(); });
 	}
 private:
+	// publishes a modified copy of the current table, and unsubclasses the window if that leaves no handlers
+	template<typename F> void _m_update(F modify)
+	{
+		auto current = msg_table_.load(std::memory_order_acquire);
+		auto table = current ? std::make_unique<msg_table>(*current) : std::make_unique<msg_table>();
+		modify(*table);
+		const bool empty = table->empty();
+		msg_table_.store(table.get(), std::memory_order_release);
+		tables_.push_back(std::move(table));
+		if(empty)
+			_m_subclass(false);
+	}
+
 	void _m_subclass(bool enable)
 	{
 		lock_guard lock(mutex_);
@@ -148,49 +241,53 @@ private:
 		{
 			if(native_ && (nullptr == old_proc_))
 			{
-				old_proc_ = (WNDPROC)::SetWindowLongPtr(native_, -4 /* GWL_WNDPROC*/, (LONG_PTR)_m_subclass_proc);
-				if(old_proc_)
-					table_[native_] = this;
+				// the window procedure can be called as soon as it's set, so what it needs is in place before that
+				old_proc_ = (WNDPROC)::GetWindowLongPtr(native_, -4 /* GWL_WNDPROC*/);
+				::SetPropW(native_, prop_name, this);
+				if(!old_proc_ || !::SetWindowLongPtr(native_, -4 /* GWL_WNDPROC*/, (LONG_PTR)_m_subclass_proc))
+				{
+					::RemovePropW(native_, prop_name);
+					old_proc_ = nullptr;
+				}
 			}
 		}
 		else
 		{
 			if(old_proc_)
 			{
-				table_.erase(native_);
-				::SetWindowLongPtr(native_, -4 /* GWL_WNDPROC*/, (LONG_PTR)old_proc_);
+				::SetWindowLongPtr(native_, -4 /* GWL_WNDPROC*/, (LONG_PTR)old_proc_.load());
+				::RemovePropW(native_, prop_name);
 				old_proc_ = nullptr;
-
 			}
 		}
 	}
 
-	static bool _m_call_before(msg_pro& pro, UINT msg, WPARAM wp, LPARAM lp, LRESULT* res)
+	static bool _m_call_before(const msg_pro& pro, UINT msg, WPARAM wp, LPARAM lp, LRESULT* res)
 	{
 		return (pro.before ? pro.before(msg, wp, lp, res) : true);
 	}
 
-	static bool _m_call_after(msg_pro& pro, UINT msg, WPARAM wp, LPARAM lp, LRESULT* res)
+	static bool _m_call_after(const msg_pro& pro, UINT msg, WPARAM wp, LPARAM lp, LRESULT* res)
 	{
 		return (pro.after ? pro.after(msg, wp, lp, res) : true);
 	}
 private:
 	static LRESULT CALLBACK _m_subclass_proc(HWND wd, UINT msg, WPARAM wp, LPARAM lp)
 	{
-		lock_guard lock(mutex_);
-
 		subclass * self = _m_find(wd);
-		if(nullptr == self || nullptr == self->old_proc_)
+		WNDPROC old_proc = self ? self->old_proc_.load() : nullptr;
+		if(nullptr == old_proc)
 			return 0;
 
-		auto i = self->msg_table_.find(msg);
-		if(self->msg_table_.end() == i)
-			return ::CallWindowProc(self->old_proc_, wd, msg, wp, lp);
+		const msg_table * table = self->msg_table_.load(std::memory_order_acquire);
+		auto i = table ? table->find(msg) : msg_table::const_iterator {};
+		if(!table || table->end() == i)
+			return ::CallWindowProc(old_proc, wd, msg, wp, lp);
 
 		LRESULT res = 0;
 		if(self->_m_call_before(i->second, msg, wp, lp, &res))
 		{
-			res = ::CallWindowProc(self->old_proc_, wd, msg, wp, lp);
+			res = ::CallWindowProc(old_proc, wd, msg, wp, lp);
 			self->_m_call_after(i->second, msg, wp, lp, &res);
 		}
 
@@ -202,18 +299,14 @@ private:
 
 	static subclass * _m_find(HWND wd)
 	{
-		lock_guard lock(mutex_);
-		std::map<HWND, subclass*>::iterator i = table_.find(wd);
-		if(i != table_.end())
-			return i->second;
-
-		return 0;
+		return static_cast<subclass*>(::GetPropW(wd, prop_name));
 	}
 private:
 	HWND native_;
-	WNDPROC old_proc_;
-	std::map<UINT, msg_pro> msg_table_;
+	std::atomic<WNDPROC> old_proc_;
+	std::atomic<const msg_table*> msg_table_; // the current one of tables_
+	std::vector<std::unique_ptr<const msg_table>> tables_; // every table that was published, oldest first
 
-	static std::recursive_mutex mutex_;
-	static std::map<HWND, subclass*> table_;
+	static std::recursive_mutex mutex_; // taken by the functions that change the handlers, not by the window procedure
+	static constexpr wchar_t prop_name[] {L"ytdlp-interface subclass"};
 };
\ No newline at end of file
@@ -1415,46 +1415,33 @@ void inline_widget::resize(const nana::size &sz)
 
 void inline_widget::set(const value_type &value)
 {
-	if(!value.empty() && text.caption().substr(0, 8) != value.substr(0, 8))
+	if(!value.empty() && (text.caption().substr(0, 8) != value.substr(0, 8) || generation != layout_generation))
 	{
-		if(value.front() == '%')
+		generation = layout_generation;
+		if(value.size() < 4)
+			text.caption(value);
+		else
 		{
-			conf = value[1] - 0x30;
-			if(conf > 1)
-				text.show();
-			else text.hide();
-			if(conf == 1 || conf == 3)
-				pic.show();
-			else pic.hide();
-			indicator_->modify(pos_, value.substr(2));
+			clip_text(value);
+			auto pimg {lb->at(pos_).value<lbqval_t>().pimg};
+			if(pimg) pic.load(*pimg);
 		}
-		else
+		if(lb->column_at(1).visible())
 		{
-			if(value.size() < 4)
-				text.caption(value);
-			else
-			{
-				clip_text(value);
-				auto pimg {lb->at(pos_).value<lbqval_t>().pimg};
-				if(pimg) pic.load(*pimg);
-			}
-			if(lb->column_at(1).visible())
-			{
-				const auto w {lb->column_at(1).width()};
-				if(w == util::scale(30))
-					conf = 1;
-				else if(w == util::scale(130))
-					conf = 3;
-				else conf = 2;
-			}
-			else conf = 0;
-			if(conf > 1)
-				text.show();
-			else text.hide();
-			if(conf == 1 || conf == 3)
-				pic.show();
-			else pic.hide();
+			const auto w {lb->column_at(1).width()};
+			if(w == util::scale(30))
+				conf = 1;
+			else if(w == util::scale(130))
+				conf = 3;
+			else conf = 2;
 		}
+		else conf = 0;
+		if(conf > 1)
+			text.show();
+		else text.hide();
+		if(conf == 1 || conf == 3)
+			pic.show();
+		else pic.hide();
 	}
 }
 
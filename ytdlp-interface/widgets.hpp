@@ -687,6 +687,10 @@ namespace widgets
 
 class inline_widget : public nana::listbox::inline_notifier_interface
 {
+public:
+	static void relayout() { layout_generation++; } // the widgets lay themselves out again when they're next drawn
+
+private:
 	virtual void create(nana::window wd) override;
 	virtual void activate(inline_indicator &ind, index_type pos);
 	void resize(const nana::size &sz) override;
@@ -702,4 +706,6 @@ class inline_widget : public nana::listbox::inline_notifier_interface
 	widgets::Listbox *lb {nullptr};
 	int conf {3};
 	HWND hwnd {nullptr};
+	static inline unsigned layout_generation {0};
+	unsigned generation {0};
 };
\ No newline at end of file